@@ -1,6 +1,7 @@
 // lib/packages/smart_media_player/audio/engine_soundtouch_ffi.dart
 
 import 'dart:ffi' as ffi;
+import 'dart:isolate';
 import 'dart:typed_data';
 import 'dart:io';
 
@@ -15,6 +16,7 @@ import 'package:ffi/ffi.dart';
 ///    - void   st_create()
 ///    - void   st_dispose()
 ///    - bool   st_openFile(const char* path)
+///    - bool   st_openFileCached(const char* path, const char* cachePath) // 전체 PCM 캐시
 ///    - void   st_close()
 ///    - void   st_set_tempo(float t)
 ///    - void   st_set_pitch_semitones(float semi)
@@ -23,6 +25,32 @@ import 'package:ffi/ffi.dart';
 ///    - double st_getDurationMs()              // ms
 ///    - double st_getPositionMs()              // ms (SoT)
 ///    - void   st_seekToMs(double ms)
+///    - void   st_scrubSetVelocity(double v)   // FF/RW 스크럽 (배수, 음수=역방향)
+///    - void   st_scrubToMs(double ms)         // 드래그 스크럽 (타겟 추종)
+///    - void   st_scrubEnd()
+///    - void   st_setLoop(double aMs, double bMs, int repeat) // 네이티브 A/B 루프
+///    - void   st_clearLoop()
+///    - int    st_getLoopRemaining()           // -1=무한, 0=없음/소진
+///    - bool   st_consumeEndOfStream()         // 트랙 끝 도달 (1회성)
+///    - void   st_setEventPort(int64 port, void* postCObject) // 이벤트 채널
+///    - void   st_setPositionTickHz(int hz)
+///    - void   st_setLateStretch(bool enabled, int aheadFrames) // 저지연 tempo/pitch 반응
+///    - int    st_getStretchAheadFrames()
+///    - int    st_getSampleRate()            // 엔진 레이트 (= 장치 네이티브)
+///    - bool   st_setEngineConfig(int periodFrames, int periods, bool lowLatency, int ringFrames, int warmupMs)
+///    - int    st_getEngineConfig(int32* out, int maxCount) // 협상된 장치 프로필
+///    - int    st_getStretchQuality()         // 0 = 최고, CPU 부하 시 거버너가 올림
+///    - int    st_getQualityHistory(int64* out, int maxEntries)
+///    - int64  st_getCopyBytesSaved()         // 중간 버퍼 없이 옮긴 누적 바이트 (진단용)
+///    - double st_getCopyBytesSavedPerSecond() // 재생 오디오 1초당 아낀 바이트
+///    - void   st_setStretchBypass(bool enabled) // 원속(tempo 1 / pitch 0)에서 SoundTouch 우회
+///    - bool   st_isStretchBypassed()
+///    - void   st_setFillBounds(int minFrames, int maxFrames) // 적응 출력 버퍼 범위
+///    - int    st_getFillTarget()
+///    - int    st_getFillHistory(int64* out, int maxEntries)
+///    - void   st_setIdlePolicy(int idleStopMs)  // 정지 중 장치 휴면 (0 = 끔)
+///    - bool   st_isDeviceIdle()
+///    - double st_getLastWakeLatencyMs()
 ///    - void   st_copyLastBuffer(float* dst, int maxFrames)
 ///    - double st_getRmsLevel()
 ///    - void   st_feed_pcm(float* data, int frames) // no-op
@@ -31,10 +59,22 @@ import 'package:ffi/ffi.dart';
 ///
 ///  Dart 쪽에서:
 ///    - st_create / st_dispose : 엔진 수명 관리
-///    - stOpenFile(String path) / stCloseFile()
+///    - stOpenFile(String path, {pcmCachePath}) / stCloseFile()
 ///    - st_setTempo / st_setPitch / st_setVolume
 ///    - stGetDuration(), stGetPosition(), stGetPlaybackTimeSeconds()
 ///    - stSeekTo(Duration / ms)
+///    - stScrubSetVelocity() / stScrubTo() / stScrubEnd()
+///    - stSetLoop() / stClearLoop() / stGetLoopRemaining()
+///    - stConsumeEndOfStream()
+///    - stSetEventPort(SendPort?) / stSetPositionTickHz()
+///    - stSetLateStretch() / stGetStretchAheadFrames()
+///    - stGetSampleRate()
+///    - stSetEngineConfig() / stGetEngineConfig() // st_create 전에 설정
+///    - stGetStretchQuality() / stGetQualityHistory()
+///    - stGetCopyBytesSaved() / stGetCopyBytesSavedPerSecond()
+///    - stSetStretchBypass() / stIsStretchBypassed()
+///    - stSetFillBounds() / stGetFillTarget() / stGetFillHistory()
+///    - stSetIdlePolicy() / stIsDeviceIdle() / stGetLastWakeLatency()
 ///    - stGetLastBuffer(), stGetRmsLevel()
 ///    - feedPcmToFFI(...)는 기존호환용 no-op 래퍼
 ///    - stPlay() / stPause() 는 STEP 2-B에서 네이티브 재생/일시정지로 연결
@@ -69,12 +109,47 @@ typedef _st_getPositionMs_native = ffi.Double Function();
 
 typedef _st_seekToMs_native = ffi.Void Function(ffi.Double);
 
+typedef _st_scrubSetVelocity_native = ffi.Void Function(ffi.Double);
+typedef _st_scrubToMs_native = ffi.Void Function(ffi.Double);
+typedef _st_scrubEnd_native = ffi.Void Function();
+
+typedef _st_setLoop_native = ffi.Void Function(ffi.Double, ffi.Double, ffi.Int32);
+typedef _st_clearLoop_native = ffi.Void Function();
+typedef _st_getLoopRemaining_native = ffi.Int32 Function();
+typedef _st_consumeEndOfStream_native = ffi.Bool Function();
+typedef _st_setEventPort_native =
+    ffi.Void Function(ffi.Int64, ffi.Pointer<ffi.Void>);
+typedef _st_setPositionTickHz_native = ffi.Void Function(ffi.Int32);
+typedef _st_setLateStretch_native = ffi.Void Function(ffi.Bool, ffi.Int32);
+typedef _st_getStretchAheadFrames_native = ffi.Int32 Function();
+typedef _st_getSampleRate_native = ffi.Int32 Function();
+typedef _st_setEngineConfig_native =
+    ffi.Bool Function(ffi.Int32, ffi.Int32, ffi.Bool, ffi.Int32, ffi.Int32);
+typedef _st_getEngineConfig_native =
+    ffi.Int32 Function(ffi.Pointer<ffi.Int32>, ffi.Int32);
+typedef _st_getStretchQuality_native = ffi.Int32 Function();
+typedef _st_getQualityHistory_native =
+    ffi.Int32 Function(ffi.Pointer<ffi.Int64>, ffi.Int32);
+typedef _st_getCopyBytesSaved_native = ffi.Int64 Function();
+typedef _st_getCopyBytesSavedPerSecond_native = ffi.Double Function();
+typedef _st_setStretchBypass_native = ffi.Void Function(ffi.Bool);
+typedef _st_isStretchBypassed_native = ffi.Bool Function();
+typedef _st_setFillBounds_native = ffi.Void Function(ffi.Int32, ffi.Int32);
+typedef _st_getFillTarget_native = ffi.Int32 Function();
+typedef _st_getFillHistory_native =
+    ffi.Int32 Function(ffi.Pointer<ffi.Int64>, ffi.Int32);
+typedef _st_setIdlePolicy_native = ffi.Void Function(ffi.Int32);
+typedef _st_isDeviceIdle_native = ffi.Bool Function();
+typedef _st_getLastWakeLatencyMs_native = ffi.Double Function();
+
 typedef _st_copyLastBuffer_native =
     ffi.Void Function(ffi.Pointer<ffi.Float>, ffi.Int32);
 
 typedef _st_getRmsLevel_native = ffi.Double Function();
 
 typedef _st_openFile_native = ffi.Bool Function(ffi.Pointer<Utf8>);
+typedef _st_openFileCached_native =
+    ffi.Bool Function(ffi.Pointer<Utf8>, ffi.Pointer<Utf8>);
 typedef _st_close_native = ffi.Void Function();
 
 typedef _st_feedPcm_native =
@@ -100,11 +175,41 @@ typedef _st_getPositionMs_dart = double Function();
 
 typedef _st_seekToMs_dart = void Function(double);
 
+typedef _st_scrubSetVelocity_dart = void Function(double);
+typedef _st_scrubToMs_dart = void Function(double);
+typedef _st_scrubEnd_dart = void Function();
+
+typedef _st_setLoop_dart = void Function(double, double, int);
+typedef _st_clearLoop_dart = void Function();
+typedef _st_getLoopRemaining_dart = int Function();
+typedef _st_consumeEndOfStream_dart = bool Function();
+typedef _st_setEventPort_dart = void Function(int, ffi.Pointer<ffi.Void>);
+typedef _st_setPositionTickHz_dart = void Function(int);
+typedef _st_setLateStretch_dart = void Function(bool, int);
+typedef _st_getStretchAheadFrames_dart = int Function();
+typedef _st_getSampleRate_dart = int Function();
+typedef _st_setEngineConfig_dart = bool Function(int, int, bool, int, int);
+typedef _st_getEngineConfig_dart = int Function(ffi.Pointer<ffi.Int32>, int);
+typedef _st_getStretchQuality_dart = int Function();
+typedef _st_getQualityHistory_dart = int Function(ffi.Pointer<ffi.Int64>, int);
+typedef _st_getCopyBytesSaved_dart = int Function();
+typedef _st_getCopyBytesSavedPerSecond_dart = double Function();
+typedef _st_setStretchBypass_dart = void Function(bool);
+typedef _st_isStretchBypassed_dart = bool Function();
+typedef _st_setFillBounds_dart = void Function(int, int);
+typedef _st_getFillTarget_dart = int Function();
+typedef _st_getFillHistory_dart = int Function(ffi.Pointer<ffi.Int64>, int);
+typedef _st_setIdlePolicy_dart = void Function(int);
+typedef _st_isDeviceIdle_dart = bool Function();
+typedef _st_getLastWakeLatencyMs_dart = double Function();
+
 typedef _st_copyLastBuffer_dart = void Function(ffi.Pointer<ffi.Float>, int);
 
 typedef _st_getRmsLevel_dart = double Function();
 
 typedef _st_openFile_dart = bool Function(ffi.Pointer<Utf8>);
+typedef _st_openFileCached_dart =
+    bool Function(ffi.Pointer<Utf8>, ffi.Pointer<Utf8>);
 typedef _st_close_dart = void Function();
 
 typedef _st_feedPcm_dart = void Function(ffi.Pointer<ffi.Float>, int);
@@ -153,6 +258,111 @@ final _st_getPositionMs = _lib
 final _st_seekToMs = _lib
     .lookupFunction<_st_seekToMs_native, _st_seekToMs_dart>('st_seekToMs');
 
+final _st_scrubSetVelocity = _lib
+    .lookupFunction<_st_scrubSetVelocity_native, _st_scrubSetVelocity_dart>(
+      'st_scrubSetVelocity',
+    );
+
+final _st_scrubToMs = _lib
+    .lookupFunction<_st_scrubToMs_native, _st_scrubToMs_dart>('st_scrubToMs');
+
+final _st_scrubEnd = _lib
+    .lookupFunction<_st_scrubEnd_native, _st_scrubEnd_dart>('st_scrubEnd');
+
+final _st_setLoop = _lib
+    .lookupFunction<_st_setLoop_native, _st_setLoop_dart>('st_setLoop');
+
+final _st_clearLoop = _lib
+    .lookupFunction<_st_clearLoop_native, _st_clearLoop_dart>('st_clearLoop');
+
+final _st_getLoopRemaining = _lib
+    .lookupFunction<_st_getLoopRemaining_native, _st_getLoopRemaining_dart>(
+      'st_getLoopRemaining',
+    );
+final _st_consumeEndOfStream = _lib
+    .lookupFunction<_st_consumeEndOfStream_native, _st_consumeEndOfStream_dart>(
+      'st_consumeEndOfStream',
+    );
+final _st_setEventPort = _lib
+    .lookupFunction<_st_setEventPort_native, _st_setEventPort_dart>(
+      'st_setEventPort',
+    );
+final _st_setPositionTickHz = _lib
+    .lookupFunction<_st_setPositionTickHz_native, _st_setPositionTickHz_dart>(
+      'st_setPositionTickHz',
+    );
+final _st_setLateStretch = _lib
+    .lookupFunction<_st_setLateStretch_native, _st_setLateStretch_dart>(
+      'st_setLateStretch',
+    );
+final _st_getStretchAheadFrames = _lib
+    .lookupFunction<
+      _st_getStretchAheadFrames_native,
+      _st_getStretchAheadFrames_dart
+    >('st_getStretchAheadFrames');
+final _st_getSampleRate = _lib
+    .lookupFunction<_st_getSampleRate_native, _st_getSampleRate_dart>(
+      'st_getSampleRate',
+    );
+final _st_setEngineConfig = _lib
+    .lookupFunction<_st_setEngineConfig_native, _st_setEngineConfig_dart>(
+      'st_setEngineConfig',
+    );
+final _st_getEngineConfig = _lib
+    .lookupFunction<_st_getEngineConfig_native, _st_getEngineConfig_dart>(
+      'st_getEngineConfig',
+    );
+final _st_getStretchQuality = _lib
+    .lookupFunction<_st_getStretchQuality_native, _st_getStretchQuality_dart>(
+      'st_getStretchQuality',
+    );
+final _st_getQualityHistory = _lib
+    .lookupFunction<_st_getQualityHistory_native, _st_getQualityHistory_dart>(
+      'st_getQualityHistory',
+    );
+final _st_getCopyBytesSaved = _lib
+    .lookupFunction<_st_getCopyBytesSaved_native, _st_getCopyBytesSaved_dart>(
+      'st_getCopyBytesSaved',
+    );
+final _st_getCopyBytesSavedPerSecond = _lib
+    .lookupFunction<
+      _st_getCopyBytesSavedPerSecond_native,
+      _st_getCopyBytesSavedPerSecond_dart
+    >('st_getCopyBytesSavedPerSecond');
+final _st_setStretchBypass = _lib
+    .lookupFunction<_st_setStretchBypass_native, _st_setStretchBypass_dart>(
+      'st_setStretchBypass',
+    );
+final _st_isStretchBypassed = _lib
+    .lookupFunction<_st_isStretchBypassed_native, _st_isStretchBypassed_dart>(
+      'st_isStretchBypassed',
+    );
+final _st_setFillBounds = _lib
+    .lookupFunction<_st_setFillBounds_native, _st_setFillBounds_dart>(
+      'st_setFillBounds',
+    );
+final _st_getFillTarget = _lib
+    .lookupFunction<_st_getFillTarget_native, _st_getFillTarget_dart>(
+      'st_getFillTarget',
+    );
+final _st_getFillHistory = _lib
+    .lookupFunction<_st_getFillHistory_native, _st_getFillHistory_dart>(
+      'st_getFillHistory',
+    );
+final _st_setIdlePolicy = _lib
+    .lookupFunction<_st_setIdlePolicy_native, _st_setIdlePolicy_dart>(
+      'st_setIdlePolicy',
+    );
+final _st_isDeviceIdle = _lib
+    .lookupFunction<_st_isDeviceIdle_native, _st_isDeviceIdle_dart>(
+      'st_isDeviceIdle',
+    );
+final _st_getLastWakeLatencyMs = _lib
+    .lookupFunction<
+      _st_getLastWakeLatencyMs_native,
+      _st_getLastWakeLatencyMs_dart
+    >('st_getLastWakeLatencyMs');
+
 final _st_copyLastBuffer = _lib
     .lookupFunction<_st_copyLastBuffer_native, _st_copyLastBuffer_dart>(
       'st_copyLastBuffer',
@@ -165,6 +375,10 @@ final _st_getRmsLevel = _lib
 
 final _st_openFile = _lib
     .lookupFunction<_st_openFile_native, _st_openFile_dart>('st_openFile');
+final _st_openFileCached = _lib
+    .lookupFunction<_st_openFileCached_native, _st_openFileCached_dart>(
+      'st_openFileCached',
+    );
 
 final _st_close = _lib.lookupFunction<_st_close_native, _st_close_dart>(
   'st_close',
@@ -226,14 +440,20 @@ void stDisposeEngine() {
 
 /// 파일 열기 (FFmpeg 디코더 + SoundTouch + miniaudio 준비)
 /// - path: UTF-8 경로 (macOS 파일시스템 경로)
+/// - pcmCachePath: 전체 PCM 캐시 파일 경로 (있으면 재사용, 없으면 백그라운드 생성)
+///   → 준비되면 seek/루프/스크럽이 디코드 없이 메모리에서 처리됨. 긴 파일은 네이티브가 무시
 /// - return: true = 성공, false = 실패
-bool stOpenFile(String path) {
+bool stOpenFile(String path, {String? pcmCachePath}) {
   final ptr = path.toNativeUtf8();
+  final cachePtr = pcmCachePath?.toNativeUtf8();
   try {
-    final ok = _st_openFile(ptr);
+    final ok = cachePtr == null
+        ? _st_openFile(ptr)
+        : _st_openFileCached(ptr, cachePtr);
     return ok;
   } finally {
     calloc.free(ptr);
+    if (cachePtr != null) calloc.free(cachePtr);
   }
 }
 
@@ -278,6 +498,209 @@ void stSeekToDuration(Duration position) {
   _st_seekToMs(ms);
 }
 
+/// 스크럽 속도 지정 (FF/RW 홀드용)
+/// - velocity: 원속 대비 배수 (2.0 = 2배속 앞으로, -2.0 = 2배속 뒤로, 0 = 제자리)
+/// - 네이티브가 짧은 그레인을 이어 붙여 재생 → seek 없이 연속된 소리
+void stScrubSetVelocity(double velocity) {
+  _st_scrubSetVelocity(velocity);
+}
+
+/// 스크럽 타겟 지정 (파형 드래그용)
+/// - 네이티브가 타겟을 향해 속도를 조절하며 따라간다 (seek storm 없음)
+void stScrubTo(Duration position) {
+  final ms = position.inMilliseconds.toDouble();
+  _st_scrubToMs(ms < 0 ? 0.0 : ms);
+}
+
+/// 스크럽 종료 → 마지막 위치에서 일반 재생(또는 정지)으로 복귀
+void stScrubEnd() {
+  _st_scrubEnd();
+}
+
+/// 네이티브 A/B 루프 설정
+/// - repeat: 0 = 무한, N = B에 N번 도달하면 종료
+/// - wrap은 엔진이 소스 샘플 단위로 처리 (seek/무음 없음, 10ms 크로스페이드)
+void stSetLoop(Duration a, Duration b, int repeat) {
+  _st_setLoop(
+    a.inMicroseconds / 1000.0,
+    b.inMicroseconds / 1000.0,
+    repeat < 0 ? 0 : repeat,
+  );
+}
+
+/// 네이티브 루프 해제
+void stClearLoop() {
+  _st_clearLoop();
+}
+
+/// 남은 반복 횟수 (-1 = 무한, 0 = 루프 없음/소진)
+/// - 엔진이 wrap을 실제로 출력한 시점에 갱신된다
+int stGetLoopRemaining() {
+  return _st_getLoopRemaining();
+}
+
+/// 트랙 끝까지 재생됐는지 (1회성: true를 한 번 돌려주면 해제)
+/// - SoundTouch 꼬리까지 디바이스로 다 나간 시점 기준, seek/새 파일이면 리셋
+bool stConsumeEndOfStream() {
+  return _st_consumeEndOfStream();
+}
+
+/// 엔진 이벤트 채널 연결 (null = 해제)
+/// - 메시지: [kind, value, timestampUs] (List<int>)
+///   kind 1=위치 tick(ms) 2=underrun 3=트랙 끝 4=루프 wrap(남은 반복)
+///        5=seek 완료(타겟 ms) 6=출력 장치 변경
+void stSetEventPort(SendPort? port) {
+  _st_setEventPort(
+    port?.nativePort ?? 0,
+    port == null ? ffi.nullptr : ffi.NativeApi.postCObject.cast(),
+  );
+}
+
+/// 재생 중 위치 tick 주기 (Hz, 0 = 끔)
+void stSetPositionTickHz(int hz) {
+  _st_setPositionTickHz(hz);
+}
+
+/// 늦은 스트레치 모드 (tempo/pitch 변경이 ~20ms 안에 들림)
+/// - 링에는 소스 PCM을 두고, SoundTouch는 출력 직전 워커가 돌린다
+/// - aheadFrames: 출력 링을 앞서 채워 둘 프레임 수 (0 = 장치 period × 2)
+void stSetLateStretch({required bool enabled, int aheadFrames = 0}) {
+  _st_setLateStretch(enabled, aheadFrames);
+}
+
+/// 늦은 스트레치 워커가 지금 유지하는 출력 앞섬 (엔진 레이트 프레임, 모드 꺼짐 = 0)
+int stGetStretchAheadFrames() {
+  return _st_getStretchAheadFrames();
+}
+
+/// 엔진 샘플레이트 (출력 장치 네이티브 레이트, st_create 이후 고정)
+int stGetSampleRate() {
+  return _st_getSampleRate();
+}
+
+/// 장치 프로필 요청 — st_create(stInitEngine) 전에만 유효
+/// - periodFrames / periods: 0 = miniaudio 기본
+/// - lowLatency: true = low_latency, false = conservative 성능 프로필
+/// - ringFrames: 출력 링 용량 (프레임), warmupMs: 재생 시작 전 채울 분량
+/// - return: false = 엔진이 이미 생성됨 (dispose 후 다시 설정)
+bool stSetEngineConfig({
+  int periodFrames = 0,
+  int periods = 0,
+  bool lowLatency = true,
+  int ringFrames = 16384,
+  int warmupMs = 100,
+}) {
+  return _st_setEngineConfig(
+    periodFrames,
+    periods,
+    lowLatency,
+    ringFrames,
+    warmupMs,
+  );
+}
+
+/// SoundTouch 품질 단계 (0 = 최고 / 1 = quickseek + 짧은 AA / 2 = + 좁은 seek window)
+/// - 엔진 거버너가 CPU 부하에 따라 내리고, 여유가 돌아오면 다시 올린다
+int stGetStretchQuality() {
+  return _st_getStretchQuality();
+}
+
+/// 품질 단계 변경 이력 (오래된 것부터)
+/// - 항목마다 [timestampUs, fromLevel, toLevel, stretchLoad‰, callbackLoad‰, underrun(0/1)]
+/// - 부하 = 스트레치: putSamples 시간 / 출력 오디오 길이, 콜백: 실행 시간 / period (판단 창 최대치)
+List<List<int>> stGetQualityHistory({int maxEntries = 64}) {
+  final ptr = calloc<ffi.Int64>(maxEntries * 6);
+  try {
+    final n = _st_getQualityHistory(ptr, maxEntries);
+    return List<List<int>>.generate(
+      n,
+      (i) => List<int>.generate(6, (k) => ptr[i * 6 + k]),
+    );
+  } finally {
+    calloc.free(ptr);
+  }
+}
+
+/// 디코더 → SoundTouch → 출력 링 경로에서 중간 버퍼 복사 없이 옮긴 누적 바이트 (진단용)
+int stGetCopyBytesSaved() {
+  return _st_getCopyBytesSaved();
+}
+
+/// 위 값을 재생 오디오 1초당 바이트로 환산 (재생 전이면 0)
+/// - 입력(디코더 → SoundTouch)과 출력(SoundTouch → 링) 양쪽에서 아낀 복사를 합친 값
+double stGetCopyBytesSavedPerSecond() {
+  return _st_getCopyBytesSavedPerSecond();
+}
+
+/// 원속(tempo 1 / pitch 0)에서 SoundTouch를 거치지 않고 원본을 그대로 재생 (기본 켬)
+/// - 슬라이더를 움직이면 짧은 크로스페이드로 SoundTouch 경로에 복귀
+void stSetStretchBypass(bool enabled) {
+  _st_setStretchBypass(enabled);
+}
+
+bool stIsStretchBypassed() {
+  return _st_isStretchBypassed();
+}
+
+/// 적응 출력 버퍼 범위 (엔진 레이트 프레임, 0 = 기본)
+/// - 엔진이 underrun/디코드 비용을 보고 이 범위 안에서 목표 채움량을 늘리거나 줄인다
+void stSetFillBounds({int minFrames = 0, int maxFrames = 0}) {
+  _st_setFillBounds(minFrames, maxFrames);
+}
+
+/// 현재 출력 버퍼 목표 채움량 (엔진 레이트 프레임)
+int stGetFillTarget() {
+  return _st_getFillTarget();
+}
+
+/// 목표 채움량 변경 이력 (오래된 것부터)
+/// - 항목마다 [timestampUs, targetFrames, reason, blockCostPeakUs]
+/// - reason: 1 underrun / 2 디코드 비용 / 3 축소 / 4 범위 변경
+List<List<int>> stGetFillHistory({int maxEntries = 64}) {
+  final ptr = calloc<ffi.Int64>(maxEntries * 4);
+  try {
+    final n = _st_getFillHistory(ptr, maxEntries);
+    return List<List<int>>.generate(
+      n,
+      (i) => [ptr[i * 4], ptr[i * 4 + 1], ptr[i * 4 + 2], ptr[i * 4 + 3]],
+    );
+  } finally {
+    calloc.free(ptr);
+  }
+}
+
+/// 정지 중 장치 휴면 — 정지가 idleAfter 이상 이어지면 출력 장치를 세움
+/// - Duration.zero = 끔 (휴면 중이면 바로 깨움)
+/// - 재생/스크럽 요청 시 자동으로 깨어나며 링에 남은 오디오부터 바로 출력
+void stSetIdlePolicy(Duration idleAfter) {
+  _st_setIdlePolicy(idleAfter.inMilliseconds);
+}
+
+/// 출력 장치가 휴면 중인지
+bool stIsDeviceIdle() {
+  return _st_isDeviceIdle();
+}
+
+/// 마지막 휴면 해제 → 첫 오디오 콜백까지 걸린 시간
+Duration stGetLastWakeLatency() {
+  final ms = _st_getLastWakeLatencyMs();
+  if (ms.isNaN || ms.isInfinite) return Duration.zero;
+  return Duration(microseconds: (ms * 1000).round());
+}
+
+/// 협상된 장치 프로필
+/// - [periodFrames, periods, lowLatency, ringFrames, warmupMs, sampleRate, latencyFrames]
+List<int> stGetEngineConfig() {
+  const count = 7;
+  final ptr = calloc<ffi.Int32>(count);
+  try {
+    final n = _st_getEngineConfig(ptr, count);
+    return List<int>.generate(n, (i) => ptr[i]);
+  } finally {
+    calloc.free(ptr);
+  }
+}
+
 /// 최근 출력 버퍼(stereo, interleaved)를 가져온다.
 /// - maxFrames: 최대 프레임 수 (기본 4096, 네이티브 BUF_FRAMES와 동일)
 /// - return: 길이 = frames * 2(float32) 인 Float32List
@@ -21,12 +21,16 @@
 import '../../smart_media_player/video/sticky_video_overlay.dart';
 import 'dart:async';
 import 'dart:io';
+import 'dart:isolate';
 
 import 'package:flutter/material.dart';
 import 'package:media_kit/media_kit.dart';
+import 'package:path/path.dart' as p;
 import 'package:media_kit_video/media_kit_video.dart';
 
 import '../audio/engine_soundtouch_ffi.dart';
+import 'engine_events.dart';
+import 'engine_profile.dart';
 import '../video/video_sync_service.dart';
 
 // ================================================================
@@ -66,6 +70,7 @@ class EngineApi {
   late final Player _player;
 
   bool _initialized = false;
+  EngineDeviceProfile _deviceProfile = EngineDeviceProfile.standard;
   bool _hasFile = false;
 
   Duration _duration = Duration.zero;
@@ -77,7 +82,7 @@ class EngineApi {
 
   /// 🔥 오디오(SoT) 기준 "트랙 자연 종료" 콜백
   ///
-  /// - EngineApi 내부 SoT 폴링에서 종료를 감지하면 한 번만 호출된다.
+  /// - 네이티브 endOfStream 이벤트를 받으면 한 번만 호출된다.
   /// - Screen(SmartMediaPlayerScreen)에서 LoopExecutor/패턴 엔진으로
   ///   위임하기 위해 사용한다.
   /// - null 이면 EngineApi가 기존 `_handleTrackCompleted()` 로직을 사용한다.
@@ -106,13 +111,14 @@ class EngineApi {
   Stream<Duration> get duration$ => _durationCtl.stream;
   Stream<bool> get playing$ => _playingCtl.stream;
 
-  // FFmpeg SoT polling용 타이머
-  Timer? _positionTimer;
-  DateTime? _lastPosLogAt;
+  /// 네이티브 엔진 푸시 이벤트 (위치 tick / underrun / 트랙 끝 / 루프 wrap / seek 완료 / 장치 변경)
+  /// - LoopExecutor, VideoSyncService, Screen watchdog이 각자 타이머 대신 구독
+  final _eventCtl = StreamController<EngineEvent>.broadcast();
+  Stream<EngineEvent> get events$ => _eventCtl.stream;
 
-  // 🔥 오디오(FFmpeg SoT) 기준 트랙 종료 감지용 상태
-  Duration? _lastPolledPosition;
-  bool _endCandidate = false;
+  // 네이티브 이벤트 수신 포트
+  ReceivePort? _eventPort;
+  DateTime? _lastPosLogAt;
 
   // ================================================================
   // PUBLIC GETTERS
@@ -218,52 +224,35 @@ class EngineApi {
     }
   }
 
-  // ================================================================
-  // INIT
-  // ================================================================
-  Future<void> init() async {
-    if (_initialized) return;
-    _initialized = true;
-
-    // media_kit 초기화는 ctor에서 이미 수행 및 Player 생성 완료 상태.
-    // 여기서는 네이티브 엔진과 SoT 폴링, mpv 이벤트 스트림만 붙인다.
-
-    stInitEngine();
-    _logSmpEngine('init(): native audio engine initialized');
-
-    // FFmpeg SoT polling (position stream)
-    _positionTimer?.cancel();
-    _positionTimer = Timer.periodic(const Duration(milliseconds: 50), (_) {
-      if (!_hasFile) return;
-
-      final raw = stGetPosition();
-      final pos = (_duration > Duration.zero)
-          ? _clampToDuration(raw)
-          : raw; // duration 미정일 때는 raw 그대로
-
-      // === 기본 position 스트림 전파 ===
-      _positionCtl.add(pos);
-
-      // === 오디오(SoT) 기반 트랙 종료 감지 ===
-      if (_duration > Duration.zero) {
-        // "끝 근처" 영역 (마지막 80ms)
-        final endThreshold = _duration - const Duration(milliseconds: 80);
-        final wasAtEnd =
-            _lastPolledPosition != null && _lastPolledPosition! >= endThreshold;
-        final isAtEnd = pos >= endThreshold;
-
-        // 끝 영역에 진입 → "후보" 플래그
-        if (!wasAtEnd && isAtEnd) {
-          _endCandidate = true;
+  // 네이티브 이벤트 처리 → position$ / 트랙 종료 / events$
+  void _onEngineEvent(EngineEvent e) {
+    switch (e.kind) {
+      case EngineEventKind.position:
+      case EngineEventKind.seekComplete:
+        if (!_hasFile) return;
+        final raw = e.asPosition;
+        final pos = (_duration > Duration.zero)
+            ? _clampToDuration(raw)
+            : raw; // duration 미정일 때는 raw 그대로
+        _positionCtl.add(pos);
+
+        // SoT 로깅 (500ms 이상 간격으로만 + tick 채널에만)
+        final now = DateTime.now();
+        if (_lastPosLogAt == null ||
+            now.difference(_lastPosLogAt!) >=
+                const Duration(milliseconds: 500)) {
+          _lastPosLogAt = now;
+          _logSmpEngine(
+            'tick: pos=${pos.inMilliseconds}ms, dur=${_duration.inMilliseconds}ms, playing=$_nativePlaying',
+            tick: true,
+          );
         }
+        break;
 
-        // 후보 상태에서 위치가 더 이상 안 움직이고(정지) 오디오는 재생 중이면 → 실제 종료로 간주
-                if (_endCandidate &&
-            _lastPolledPosition != null &&
-            pos == _lastPolledPosition &&
-            _nativePlaying) {
-          _endCandidate = false;
-
+      case EngineEventKind.endOfStream:
+        // 네이티브 1회성 플래그도 함께 소비
+        //  - 스크럽 중에는 끝에 닿아도 종료가 아님
+        if (stConsumeEndOfStream() && _hasFile && !_scrubbing) {
           // 🔥 Screen 쪽에 위임할 수 있으면 먼저 위임하고,
           // 없으면 기존 기본 트랙 완료 동작을 사용한다.
           if (trackCompletedHandler != null) {
@@ -272,22 +261,44 @@ class EngineApi {
             unawaited(_handleTrackCompleted());
           }
         }
+        break;
 
-      }
+      case EngineEventKind.underrun:
+      case EngineEventKind.deviceChange:
+      case EngineEventKind.deviceIdle:
+        _logSmpEngine('event: $e');
+        break;
 
-      _lastPolledPosition = pos;
+      default:
+        break;
+    }
 
-      // SoT 로깅 (500ms 이상 간격으로만 + tick 채널에만)
-      final now = DateTime.now();
-      if (_lastPosLogAt == null ||
-          now.difference(_lastPosLogAt!) >= const Duration(milliseconds: 500)) {
-        _lastPosLogAt = now;
-        _logSmpEngine(
-          'tick: pos=${pos.inMilliseconds}ms, dur=${_duration.inMilliseconds}ms, playing=$_nativePlaying',
-          tick: true,
-        );
-      }
-    });
+    _eventCtl.add(e);
+  }
+
+  // ================================================================
+  // INIT
+  // ================================================================
+  //  - profile: 장치 프로필 (period / 링 깊이). 엔진 생성 전에만 적용됨
+  Future<void> init({EngineDeviceProfile? profile}) async {
+    if (_initialized) return;
+    _initialized = true;
+
+    // media_kit 초기화는 ctor에서 이미 수행 및 Player 생성 완료 상태.
+    // 여기서는 네이티브 엔진과 이벤트 채널, mpv 이벤트 스트림만 붙인다.
+
+    if (profile != null && !profile.request()) {
+      _logSmpEngine('init(): device profile ignored (engine already created)');
+    }
+    stInitEngine();
+    _deviceProfile = EngineDeviceProfile.negotiated();
+    _logSmpEngine('init(): native audio engine initialized, $_deviceProfile');
+
+    // 네이티브 이벤트 채널 (위치 tick 등은 엔진이 push)
+    _eventPort?.close();
+    _eventPort = ReceivePort()
+      ..listen((msg) => _onEngineEvent(EngineEvent.fromMessage(msg)));
+    stSetEventPort(_eventPort!.sendPort);
 
     // media_kit playing stream → playing$ (영상 상태와 오디오 상태를 최대한 맞춰준다)
     _player.stream.playing.listen((v) {
@@ -307,9 +318,11 @@ class EngineApi {
   // ================================================================
   // LOAD MEDIA (FFmpeg 네이티브 엔진 + optional video)
   // ================================================================
+  //  - pcmCachePath: 전체 PCM 캐시 파일 (미디어 해시 기반, 앱 재시작 후에도 재사용)
   Future<Duration> load({
     required String path,
     required void Function(Duration) onDuration,
+    String? pcmCachePath,
   }) async {
     await init();
 
@@ -327,14 +340,13 @@ class EngineApi {
     _pendingVideoTarget = null;
     _nativePlaying = false;
     _playingCtl.add(false);
-    _lastPolledPosition = null;
-    _endCandidate = false;
 
     // 🔁 이전에 붙어 있던 영상 플레이어/컨트롤러 완전히 분리
     VideoSyncService.instance.detachPlayer();
 
     // 네이티브 엔진에 파일 오픈
-    final ok = stOpenFile(path);
+    final cachePath = await _preparePcmCache(pcmCachePath);
+    final ok = stOpenFile(path, pcmCachePath: cachePath);
     if (!ok) {
       throw Exception(
         '[EngineApi] Failed to open file via native engine: $path',
@@ -401,6 +413,44 @@ class EngineApi {
     return _duration;
   }
 
+  // 전체 PCM 캐시 파일 준비
+  //  - 폴더 생성 + 이번 파일 사용 시각 갱신
+  //  - 파일당 수십~수백 MB라서 최근에 쓴 것만 남기고 정리
+  //  - 실패하면 null → 캐시 없이 스트리밍 디코드
+  static const int _pcmCacheKeep = 8;
+
+  Future<String?> _preparePcmCache(String? cachePath) async {
+    if (cachePath == null || cachePath.isEmpty) return null;
+    try {
+      final dir = Directory(p.dirname(cachePath));
+      await dir.create(recursive: true);
+
+      final self = File(cachePath);
+      if (await self.exists()) {
+        await self.setLastModified(DateTime.now());
+      }
+
+      final others = <File>[];
+      await for (final e in dir.list()) {
+        if (e is File && e.path.endsWith('.pcm') && e.path != cachePath) {
+          others.add(e);
+        }
+      }
+      if (others.length >= _pcmCacheKeep) {
+        final stamped = <(File, DateTime)>[
+          for (final f in others) (f, await f.lastModified()),
+        ]..sort((a, b) => b.$2.compareTo(a.$2));
+        for (final (f, _) in stamped.skip(_pcmCacheKeep - 1)) {
+          await f.delete();
+        }
+      }
+      return cachePath;
+    } catch (e) {
+      _logSmpEngine('pcm cache prepare failed: $e');
+      return null;
+    }
+  }
+
   // ================================================================
   // PLAYBACK CONTROL (네이티브 엔진 + 비디오 연동)
   // ================================================================
@@ -567,6 +617,62 @@ class EngineApi {
     st_setVolume(clamped.toDouble());
   }
 
+  /// 저지연 tempo/pitch 모드 (네이티브 늦은 스트레치)
+  /// - 슬라이더 조작이 ~20ms 안에 들리는 대신 SoundTouch가 출력 직전에 돈다
+  /// - aheadFrames: 출력 버퍼 앞섬 (0 = 장치 period × 2)
+  void setLowLatencyStretch(bool enabled, {int aheadFrames = 0}) {
+    _logSmpEngine(
+      'setLowLatencyStretch(): enabled=$enabled, aheadFrames=$aheadFrames',
+    );
+    stSetLateStretch(enabled: enabled, aheadFrames: aheadFrames);
+  }
+
+  /// 정지 중 출력 장치 휴면 (Duration.zero = 끔, 기본 30초)
+  /// - 하루 종일 켜 두는 환경에서 정지 중 콜백/스레드 wakeup을 없앤다
+  void setIdlePolicy(Duration idleAfter) {
+    _logSmpEngine('setIdlePolicy(): ${idleAfter.inMilliseconds}ms');
+    stSetIdlePolicy(idleAfter);
+  }
+
+  /// 출력 장치가 휴면 중인지 / 마지막 휴면 해제 지연
+  bool get deviceIdle => stIsDeviceIdle();
+  Duration get lastWakeLatency => stGetLastWakeLatency();
+
+  /// CPU 부하에 따른 SoundTouch 품질 단계 (0 = 최고)
+  int get stretchQuality => stGetStretchQuality();
+
+  /// 원속 재생 시 SoundTouch 우회 — 허용 여부 / 지금 우회 중인지
+  void setStretchBypass(bool enabled) => stSetStretchBypass(enabled);
+  bool get stretchBypassed => stIsStretchBypassed();
+
+  /// 적응 출력 버퍼 — 현재 목표 채움량 / 범위 지정 / 변경 이력
+  Duration get fillTarget => Duration(
+    microseconds: stGetFillTarget() * 1000000 ~/ stGetSampleRate(),
+  );
+
+  void setFillBounds({Duration? min, Duration? max}) {
+    final rate = stGetSampleRate();
+    stSetFillBounds(
+      minFrames: min == null ? 0 : min.inMicroseconds * rate ~/ 1000000,
+      maxFrames: max == null ? 0 : max.inMicroseconds * rate ~/ 1000000,
+    );
+  }
+
+  List<FillTargetChange> get fillHistory =>
+      stGetFillHistory().map(FillTargetChange.fromNative).toList();
+
+  /// 품질 단계 변경 이력 — 단계가 바뀐 시각과 그때의 스트레치/콜백 부하, underrun
+  List<StretchQualityChange> get qualityHistory =>
+      stGetQualityHistory().map(StretchQualityChange.fromNative).toList();
+
+  /// miniaudio와 협상된 장치 프로필 (init 이후)
+  EngineDeviceProfile get deviceProfile => _deviceProfile;
+
+  /// 늦은 스트레치가 지금 유지하는 출력 앞섬 (모드 꺼짐 = Duration.zero)
+  Duration get stretchAhead => Duration(
+    microseconds: stGetStretchAheadFrames() * 1000000 ~/ stGetSampleRate(),
+  );
+
   Future<void> restoreChainState({
     required double tempo,
     required int pitchSemi,
@@ -593,7 +699,9 @@ class EngineApi {
   }
 
   // ================================================================
-  // FAST-FORWARD / FAST-REVERSE (seek 기반 시뮬레이션)
+  // FAST-FORWARD / FAST-REVERSE (네이티브 스크럽)
+  //  - 네이티브 엔진이 PCM 창에서 그레인을 이어 붙여 가변 속도로 재생
+  //  - Dart는 속도만 지정하고, 타이머는 양 끝 도달 감지에만 사용 (seek 없음)
   // ================================================================
   Timer? _ffrwTick;
   bool _ff = false;
@@ -601,9 +709,13 @@ class EngineApi {
   bool _ffStartedFromPause = false;
   bool _frStartedFromPause = false;
 
+  // 네이티브 스크럽 진행 중 (FF/RW 또는 드래그) → 트랙 종료 감지 보류
+  bool _scrubbing = false;
+  Duration _scrubTarget = Duration.zero;
+
   static const Duration _ffrwInterval = Duration(milliseconds: 55);
-  static const Duration _ffStep = Duration(milliseconds: 150);
-  static const Duration _frStep = Duration(milliseconds: 150);
+  static const double _ffSpeed = 2.7;
+  static const double _frSpeed = 2.7;
 
   Future<void> _startFfRwTick({
     required bool forward,
@@ -627,38 +739,21 @@ class EngineApi {
     _ff = forward;
     _fr = !forward;
 
+    // P2/P3: FF/FR은 항상 “타임라인 자유 이동”
+    // StartCue/Loop는 상하한으로 개입하지 않고, 네이티브가 파일 양 끝에서 멈춘다.
+    _scrubbing = true;
+    stScrubSetVelocity(forward ? _ffSpeed : -_frSpeed);
+
     _ffrwTick = Timer.periodic(_ffrwInterval, (_) async {
       if (!_ff && !_fr) return;
-      if (_seeking) return;
-
-      final cur = position;
-      Duration next;
 
-      if (_ff) {
-        next = cur + _ffStep;
-      } else {
-        next = cur - _frStep;
-      }
-
-      // P2/P3: FF/FR은 항상 “타임라인 자유 이동”
-      // StartCue/Loop는 상하한으로 개입하지 않고,
-      // duration 기반 글로벌 클램프만 적용
-      next = _clampToDuration(next);
-
-      if (_seeking) return;
-
-      _logSmpEngine(
-        'FFRW tick: forward=$_ff, cur=${cur.inMilliseconds}ms → next=${next.inMilliseconds}ms',
-        tick: true,
-      );
+      final cur = _clampToDuration(stGetPosition());
 
-      await seekUnified(next);
-
-      if (next == Duration.zero && _fr) {
+      if (cur == Duration.zero && _fr) {
         _logSmpEngine('FFRW tick: reached 0ms in FR → stop', tick: true);
         await fastReverse(false, startCue: scNorm);
       }
-      if (next == _duration && _ff) {
+      if (cur == _duration && _ff) {
         _logSmpEngine(
           'FFRW tick: reached end(${_duration.inMilliseconds}ms) in FF → stop',
           tick: true,
@@ -668,6 +763,38 @@ class EngineApi {
     });
   }
 
+  // FF/RW 해제 공통: 정지로 돌아갈 거면 먼저 pause → 스크럽 종료 시 소리가 새지 않음
+  Future<void> _stopFfRwScrub({required bool returnToPause}) async {
+    _ffrwTick?.cancel();
+    _ffrwTick = null;
+
+    if (returnToPause) {
+      await pause();
+    }
+    stScrubEnd();
+    _scrubbing = false;
+    _scheduleVideoSeek(_clampToDuration(stGetPosition()));
+  }
+
+  /// 파형 드래그 스크럽: 드래그 위치를 네이티브 스크럽 타겟으로 전달
+  /// - 매 드래그 업데이트마다 seek하지 않고, 엔진이 연속된 소리로 따라간다
+  void scrubTo(Duration d) {
+    if (!_hasFile || _duration <= Duration.zero) return;
+    final target = _clampToDuration(d);
+    _scrubbing = true;
+    _positionCtl.add(target);
+    _scrubTarget = target;
+    stScrubTo(target);
+  }
+
+  /// 파형 드래그 스크럽 종료: 마지막 타겟 위치에서 일반 재생으로 복귀
+  void endScrub() {
+    if (!_scrubbing) return;
+    stScrubEnd();
+    _scrubbing = false;
+    _scheduleVideoSeek(_scrubTarget);
+  }
+
   Future<void> fastForward(
     bool on, {
     required Duration startCue,
@@ -715,13 +842,10 @@ class EngineApi {
 
     _logSmpEngine('fastForward(off): stop FFRW');
 
-    _ffrwTick?.cancel();
-    _ffrwTick = null;
-
     if (_ffStartedFromPause) {
       _logSmpEngine('fastForward(off): returning to pause()');
-      await pause();
     }
+    await _stopFfRwScrub(returnToPause: _ffStartedFromPause);
 
     _ffStartedFromPause = false;
   }
@@ -773,17 +897,37 @@ class EngineApi {
 
     _logSmpEngine('fastReverse(off): stop FFRW');
 
-    _ffrwTick?.cancel();
-    _ffrwTick = null;
-
     if (_frStartedFromPause) {
       _logSmpEngine('fastReverse(off): returning to pause()');
-      await pause();
     }
+    await _stopFfRwScrub(returnToPause: _frStartedFromPause);
 
     _frStartedFromPause = false;
   }
 
+  // ================================================================
+  // NATIVE A/B LOOP (엔진이 소스 샘플 단위로 wrap)
+  // ================================================================
+  /// A/B 구간을 엔진에 설정한다.
+  /// - repeat: 0 = 무한, N = B에 N번 도달하면 종료
+  /// - 같은 구간을 다시 설정하면 캐시는 유지하고 반복 횟수만 갱신
+  void setNativeLoop(Duration a, Duration b, {int repeat = 0}) {
+    if (!_hasFile) return;
+    final aa = _clampToDuration(a);
+    final bb = _clampToDuration(b);
+    _logSmpEngine(
+      'setNativeLoop(): a=${aa.inMilliseconds}ms, b=${bb.inMilliseconds}ms, repeat=$repeat',
+    );
+    stSetLoop(aa, bb, repeat);
+  }
+
+  void clearNativeLoop() {
+    stClearLoop();
+  }
+
+  /// 엔진 기준 남은 반복 (-1 = 무한, 0 = 루프 없음/소진)
+  int get nativeLoopRemaining => stGetLoopRemaining();
+
   // ================================================================
   // UNIFIED SEEK (FFmpeg 네이티브 엔진 기준)
   // ================================================================
@@ -926,6 +1070,7 @@ class EngineApi {
     _fr = false;
     _ffStartedFromPause = false;
     _frStartedFromPause = false;
+    _scrubbing = false;
 
     // 2) 네이티브 엔진 정지
     try {
@@ -945,8 +1090,6 @@ class EngineApi {
     _hasFile = false;
     _nativePlaying = false;
     _pendingVideoTarget = null;
-    _lastPolledPosition = null;
-    _endCandidate = false;
 
     // 3) SoT / duration / playing 상태 리셋
     _duration = Duration.zero;
@@ -981,8 +1124,9 @@ class EngineApi {
     try {
       _ffrwTick?.cancel();
       _ffrwTick = null;
-      _positionTimer?.cancel();
-      _positionTimer = null;
+      stSetEventPort(null);
+      _eventPort?.close();
+      _eventPort = null;
 
       await VideoSyncService.instance.dispose();
       await _player.dispose();
@@ -997,6 +1141,7 @@ class EngineApi {
     await _positionCtl.close();
     await _durationCtl.close();
     await _playingCtl.close();
+    await _eventCtl.close();
   }
 
   // ================================================================
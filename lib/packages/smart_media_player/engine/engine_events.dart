@@ -0,0 +1,50 @@
+// lib/packages/smart_media_player/engine/engine_events.dart
+//
+// 네이티브 엔진 → Dart 푸시 이벤트
+//  - 엔진의 알림 스레드(non-RT)가 Dart_PostCObject로 [kind, value, timestampUs]를 보낸다
+//  - timestampUs는 엔진 steady clock 기준 (이벤트가 실제로 일어난 시점)
+//  - 위치 tick은 재생 중에만 오고, 정지되면 마지막 위치 1회 후 멈춘다
+
+enum EngineEventKind {
+  position, // value = SoT ms
+  underrun, // value = 부족했던 프레임 수
+  endOfStream,
+  loopWrap, // value = 남은 반복 (-1 = 무한, 0 = 루프 종료)
+  seekComplete, // value = 타겟 ms
+  deviceChange, // value = miniaudio notification type
+  deviceIdle, // value = 1 휴면 진입 / 0 재개
+  unknown,
+}
+
+class EngineEvent {
+  final EngineEventKind kind;
+  final int value;
+  final int timestampUs;
+
+  const EngineEvent(this.kind, this.value, this.timestampUs);
+
+  /// 네이티브 메시지 [kind, value, timestampUs] 해석
+  factory EngineEvent.fromMessage(Object? message) {
+    if (message is! List || message.length < 3) {
+      return const EngineEvent(EngineEventKind.unknown, 0, 0);
+    }
+    final code = message[0] as int;
+    final kind = switch (code) {
+      1 => EngineEventKind.position,
+      2 => EngineEventKind.underrun,
+      3 => EngineEventKind.endOfStream,
+      4 => EngineEventKind.loopWrap,
+      5 => EngineEventKind.seekComplete,
+      6 => EngineEventKind.deviceChange,
+      7 => EngineEventKind.deviceIdle,
+      _ => EngineEventKind.unknown,
+    };
+    return EngineEvent(kind, message[1] as int, message[2] as int);
+  }
+
+  /// position / seekComplete 용
+  Duration get asPosition => Duration(milliseconds: value);
+
+  @override
+  String toString() => 'EngineEvent($kind, $value, t=${timestampUs}us)';
+}
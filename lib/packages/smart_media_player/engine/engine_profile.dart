@@ -0,0 +1,153 @@
+// lib/packages/smart_media_player/engine/engine_profile.dart
+//
+// 네이티브 엔진 장치 프로필 (period / 버퍼 깊이)
+//  - 엔진 생성(st_create) 전에 요청 → 생성 후 miniaudio와 협상한 실제 값을 다시 읽는다
+//  - period는 장치 레이트 프레임, ring은 엔진 레이트 프레임 (보통 같은 레이트)
+
+import '../audio/engine_soundtouch_ffi.dart';
+
+class EngineDeviceProfile {
+  final int periodFrames; // 0 = miniaudio 기본
+  final int periods; // 0 = miniaudio 기본
+  final bool lowLatency; // low_latency / conservative 성능 프로필
+  final int ringFrames; // 출력 링 용량
+  final int warmupMs; // 재생 시작 전 채울 분량
+
+  // 협상 결과에만 채워짐
+  final int sampleRate;
+  final int latencyFrames;
+
+  const EngineDeviceProfile({
+    this.periodFrames = 0,
+    this.periods = 0,
+    this.lowLatency = true,
+    this.ringFrames = 16384,
+    this.warmupMs = 100,
+    this.sampleRate = 0,
+    this.latencyFrames = 0,
+  });
+
+  /// 엔진 기본값 (miniaudio 기본 period, low_latency)
+  static const standard = EngineDeviceProfile();
+
+  /// 마이크와 함께 연주 — 작은 period, 얕은 링, 짧은 워밍업
+  static const playAlong = EngineDeviceProfile(
+    periodFrames: 128,
+    periods: 2,
+    lowLatency: true,
+    ringFrames: 8192,
+    warmupMs: 20,
+  );
+
+  /// 백그라운드 재생 — 큰 period로 깨어나는 횟수를 줄이고 링을 깊게
+  static const background = EngineDeviceProfile(
+    periodFrames: 2048,
+    periods: 3,
+    lowLatency: false,
+    ringFrames: 65536,
+    warmupMs: 250,
+  );
+
+  /// 엔진 생성 전에 요청 (이미 생성됐으면 false)
+  bool request() => stSetEngineConfig(
+    periodFrames: periodFrames,
+    periods: periods,
+    lowLatency: lowLatency,
+    ringFrames: ringFrames,
+    warmupMs: warmupMs,
+  );
+
+  /// 협상된 프로필 (엔진 생성 전이면 요청값)
+  factory EngineDeviceProfile.negotiated() {
+    final v = stGetEngineConfig();
+    if (v.length < 7) return const EngineDeviceProfile();
+    return EngineDeviceProfile(
+      periodFrames: v[0],
+      periods: v[1],
+      lowLatency: v[2] != 0,
+      ringFrames: v[3],
+      warmupMs: v[4],
+      sampleRate: v[5],
+      latencyFrames: v[6],
+    );
+  }
+
+  /// 출력 장치 지연 (협상 결과 기준)
+  Duration get outputLatency => sampleRate > 0
+      ? Duration(microseconds: latencyFrames * 1000000 ~/ sampleRate)
+      : Duration.zero;
+
+  @override
+  String toString() =>
+      'EngineDeviceProfile(period=$periodFrames x$periods, '
+      '${lowLatency ? 'low-latency' : 'conservative'}, ring=$ringFrames, '
+      'warmup=${warmupMs}ms, rate=$sampleRate, latency=${outputLatency.inMicroseconds}us)';
+}
+
+/// 적응 출력 버퍼 목표량 변경 1건 (엔진 JitterController)
+enum FillChangeReason { underrun, decodeCost, shrink, bounds, unknown }
+
+class FillTargetChange {
+  final int timestampUs; // 엔진 steady clock
+  final int targetFrames;
+  final FillChangeReason reason;
+  final Duration blockCostPeak; // 당시 디코드+스트레치 블록 비용 최대치
+
+  const FillTargetChange(
+    this.timestampUs,
+    this.targetFrames,
+    this.reason,
+    this.blockCostPeak,
+  );
+
+  factory FillTargetChange.fromNative(List<int> v) => FillTargetChange(
+    v[0],
+    v[1],
+    switch (v[2]) {
+      1 => FillChangeReason.underrun,
+      2 => FillChangeReason.decodeCost,
+      3 => FillChangeReason.shrink,
+      4 => FillChangeReason.bounds,
+      _ => FillChangeReason.unknown,
+    },
+    Duration(microseconds: v[3]),
+  );
+
+  @override
+  String toString() =>
+      'FillTargetChange($reason, target=$targetFrames, cost=${blockCostPeak.inMicroseconds}us)';
+}
+
+/// SoundTouch 품질 단계 변경 1건 (엔진 StretchGovernor)
+class StretchQualityChange {
+  final int timestampUs; // 엔진 steady clock
+  final int fromLevel;
+  final int toLevel;
+  final double stretchLoad; // putSamples 시간 / 출력 오디오 길이 (1.0 = 실시간 한계)
+  final double callbackLoad; // 콜백 실행 시간 / period (판단 창 최대치)
+  final bool underrun; // 판단 창 안에서 underrun이 있었는지
+
+  const StretchQualityChange(
+    this.timestampUs,
+    this.fromLevel,
+    this.toLevel,
+    this.stretchLoad,
+    this.callbackLoad,
+    this.underrun,
+  );
+
+  factory StretchQualityChange.fromNative(List<int> v) => StretchQualityChange(
+    v[0],
+    v[1],
+    v[2],
+    v[3] / 1000.0,
+    v[4] / 1000.0,
+    v[5] != 0,
+  );
+
+  @override
+  String toString() =>
+      'StretchQualityChange($fromLevel -> $toLevel, '
+      'stretch=${(stretchLoad * 100).round()}%, callback=${(callbackLoad * 100).round()}%'
+      '${underrun ? ', underrun' : ''})';
+}
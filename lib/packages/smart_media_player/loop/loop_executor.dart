@@ -5,6 +5,10 @@
 //
 // A/B 유지 + B 근접 시 재진입 + 범위 이탈 복귀 + Repeat/Remaining 정확 반영
 // StartCue는 screen.dart가 책임지므로 loopExecutor는 관여하지 않음.
+//
+// 네이티브 루프 훅(armNativeLoop 등)이 주입되면:
+//  - B → A wrap은 엔진이 소스 샘플 단위로 처리 (seek/무음 없음)
+//  - 여기서는 구간/반복 설정 전달, 남은 횟수 폴링, 범위 이탈 복귀만 담당
 
 import 'dart:async';
 
@@ -22,6 +26,11 @@ class LoopExecutor {
   final void Function(int remaining)? onLoopRemainingChanged;
   final void Function()? onExitLoop;
 
+  // ===== 네이티브 루프 (옵션) =====
+  final void Function(Duration a, Duration b, int repeat)? armNativeLoop;
+  final void Function()? disarmNativeLoop;
+  final int Function()? getNativeRemaining;
+
   LoopExecutor({
     required this.getPosition,
     required this.getDuration,
@@ -31,8 +40,16 @@ class LoopExecutor {
     this.onLoopStateChanged,
     this.onLoopRemainingChanged,
     this.onExitLoop,
+    this.armNativeLoop,
+    this.disarmNativeLoop,
+    this.getNativeRemaining,
   });
 
+  bool get _native => armNativeLoop != null && getNativeRemaining != null;
+
+  // 네이티브 모드에서 B 이후 허용 오차 (엔진 wrap 직전 SoT 폴링 지연 흡수)
+  static const Duration _nativeOverrunPad = Duration(milliseconds: 250);
+
   // ===== Loop 상태 =====
   Duration? loopA;
   Duration? loopB;
@@ -45,6 +62,7 @@ class LoopExecutor {
   int remaining = -1;
 
   Timer? _tickTimer;
+  StreamSubscription<Object?>? _tickSub;
   bool _busy = false;
 
   // ============================================================
@@ -62,6 +80,7 @@ class LoopExecutor {
       remaining = -1;
     }
 
+    _syncNative();
     onLoopStateChanged?.call(loopOn);
     onLoopRemainingChanged?.call(remaining);
   }
@@ -76,6 +95,7 @@ class LoopExecutor {
     } else {
       remaining = -1;
     }
+    _syncNative();
     onLoopRemainingChanged?.call(remaining);
   }
 
@@ -122,16 +142,37 @@ class LoopExecutor {
       // Step 3-7 규칙: B 설정 시 remaining 초기화(screen과 동일)
       remaining = (repeat == 0) ? -1 : repeat;
 
+      _syncNative();
       onLoopStateChanged?.call(true);
       onLoopRemainingChanged?.call(remaining);
     }
   }
 
+  /// 현재 루프 상태를 네이티브 엔진에 반영 (훅이 없으면 no-op)
+  /// - remaining(-1=무한)을 그대로 엔진 repeat(0=무한)으로 전달
+  void _syncNative() {
+    if (!_native) return;
+
+    final a = loopA;
+    final b = loopB;
+    if (loopOn && a != null && b != null && a < b && remaining != 0) {
+      armNativeLoop!(a, b, remaining < 0 ? 0 : remaining);
+    } else {
+      disarmNativeLoop?.call();
+    }
+  }
+
   // ============================================================
   // E. Tick Control
   // ============================================================
-  void start() {
+  /// [ticks] 가 주어지면 엔진 이벤트(위치 tick / seek 완료 / 루프 wrap)에 맞춰 평가하고,
+  /// 없으면 기존처럼 60ms 타이머로 폴링한다.
+  void start({Stream<Object?>? ticks}) {
     stop();
+    if (ticks != null) {
+      _tickSub = ticks.listen((_) => _tick());
+      return;
+    }
     _tickTimer = Timer.periodic(
       const Duration(milliseconds: 60),
       (_) => _tick(),
@@ -139,6 +180,8 @@ class LoopExecutor {
   }
 
   void stop() {
+    _tickSub?.cancel();
+    _tickSub = null;
     _tickTimer?.cancel();
     _tickTimer = null;
   }
@@ -165,6 +208,30 @@ class LoopExecutor {
         return;
       }
 
+      // ---------------------------------------------------------
+      // 0) 네이티브 루프: wrap은 엔진 담당 → 남은 횟수만 반영
+      // ---------------------------------------------------------
+      if (_native) {
+        if (pos < a || pos > b + _nativeOverrunPad) {
+          await seek(a);
+          await play();
+          return;
+        }
+
+        final rem = getNativeRemaining!();
+        if (remaining > 0 && rem >= 0 && rem != remaining) {
+          remaining = rem;
+          onLoopRemainingChanged?.call(remaining);
+
+          if (remaining == 0) {
+            loopOn = false;
+            onLoopStateChanged?.call(false);
+            onExitLoop?.call();
+          }
+        }
+        return;
+      }
+
       // ---------------------------------------------------------
       // 1) Loop 범위 이탈: 즉시 A로 복귀
       // ---------------------------------------------------------
@@ -218,6 +285,7 @@ class LoopExecutor {
     } else {
       remaining = repeat;
     }
+    _syncNative();
     onLoopRemainingChanged?.call(remaining);
   }
 }
@@ -16,6 +16,7 @@ import 'ui/smp_shortcuts.dart';
 import 'ui/smp_waveform_gestures.dart';
 import 'ui/smp_notes_panel.dart';
 import 'engine/engine_api.dart';
+import 'engine/engine_events.dart';
 import 'video/sticky_video_overlay.dart';
 
 // NEW
@@ -696,8 +697,8 @@ SaveStatus _saveStatus = SaveStatus.idle;
 DateTime? _lastSavedAt;
 int _pendingRetryCount = 0;
 
-// 워치독
-Timer? _posWatchdog;
+// 워치독 (엔진 위치 tick 구독)
+StreamSubscription<EngineEvent>? _posWatchdog;
 
 // 오늘 날짜
 late final String _todayDateStr = () {
@@ -767,10 +768,23 @@ _loopExec = LoopExecutor(
         // 🔁 루프 한 바퀴 정상 종료 시
         await _handleLoopOrTrackExit(fromTrackEnd: false);
       },
+      // 🔁 B → A wrap은 네이티브 엔진이 샘플 단위로 처리 (seek 없음)
+      armNativeLoop: (a, b, repeat) =>
+          EngineApi.instance.setNativeLoop(a, b, repeat: repeat),
+      disarmNativeLoop: () => EngineApi.instance.clearNativeLoop(),
+      getNativeRemaining: () => EngineApi.instance.nativeLoopRemaining,
 
 );
 
-_loopExec.start();
+// 루프 평가는 엔진 이벤트에 맞춰 (위치 tick / seek 완료 / 루프 wrap)
+_loopExec.start(
+  ticks: EngineApi.instance.events$.where(
+    (e) =>
+        e.kind == EngineEventKind.position ||
+        e.kind == EngineEventKind.seekComplete ||
+        e.kind == EngineEventKind.loopWrap,
+  ),
+);
 
 // A 패치: 라이프사이클 옵저버 등록
 WidgetsBinding.instance.addObserver(this);
@@ -825,6 +839,12 @@ _gestures = SmpWaveformGestures(
     await _engineSeekAndMaybeResumeFromScreen(d);
     _requestSave(saveMemo: false);
   },
+  // 재생 중 드래그: 엔진 스크럽으로 연속 재생, 손을 떼면 그 위치에서 이어서 재생
+  onScrubRequest: (d) => EngineApi.instance.scrubTo(d),
+  onScrubEnd: () {
+    EngineApi.instance.endScrub();
+    _requestSave(saveMemo: false);
+  },
   saveDebounced: ({saveMemo = false}) => _requestSave(saveMemo: saveMemo),
   isPlaying: () => EngineApi.instance.isPlaying,
 );
@@ -1192,37 +1212,38 @@ if (effDur != Duration.zero) {
 
 void _startPosWatchdog() {
 _posWatchdog?.cancel();
-const period = Duration(seconds: 1);
+const steadyLimit = Duration(seconds: 5);
 
 
-int steadyTicks = 0;
+DateTime lastChangeAt = DateTime.now();
 bool reportedInThisSpan = false;
 Duration last = Duration.zero;
 
-_posWatchdog = Timer.periodic(period, (_) {
+_posWatchdog = EngineApi.instance.events$
+    .where((e) => e.kind == EngineEventKind.position)
+    .listen((e) {
   if (!mounted || _isDisposing) return;
 
   final playing = EngineApi.instance.isPlaying;
-  final current = _position;
+  final current = e.asPosition;
+  final now = DateTime.now();
 
   // 위치가 바뀌면 → 새 구간 시작
   if (current != last) {
     last = current;
-    steadyTicks = 0;
+    lastChangeAt = now;
     reportedInThisSpan = false;
     return;
   }
 
   // 위치는 그대로인데, 재생 중이 아니면 → 정지 상태이므로 무시
   if (!playing) {
+    lastChangeAt = now;
     return;
   }
 
-  // 재생 중 + 위치가 1초 이상 동일할 때 카운트
-  steadyTicks++;
-
   // 5초 동안 그대로일 때 한 번만 로그
-  if (!reportedInThisSpan && steadyTicks >= 5) {
+  if (!reportedInThisSpan && now.difference(lastChangeAt) >= steadyLimit) {
     debugPrint(
       '[SMP] position steady 5s while playing (pos=${current.inMilliseconds}ms)',
     );
@@ -1237,6 +1258,9 @@ _posWatchdog = Timer.periodic(period, (_) {
 Future<void> _openMedia() async {
 await EngineApi.instance.load(
 path: widget.mediaPath,
+pcmCachePath: widget.mediaHash.isEmpty
+    ? null
+    : p.join(_cacheDir, '${widget.mediaHash}.pcm'),
 onDuration: (d) {
 final engineDuration = d;
 final waveDuration = _wf.duration.value;
@@ -33,6 +33,10 @@ class SmpWaveformGestures {
   // 실제 엔진 seek 호출
   final Future<void> Function(Duration) onSeekRequest;
 
+  // 재생 중 드래그 스크럽 (없으면 드래그도 onSeekRequest로 처리)
+  final void Function(Duration)? onScrubRequest;
+  final VoidCallback? onScrubEnd;
+
   // 일시정지 콜백 (EngineApi.pause는 screen.dart에서 주입)
   final VoidCallback onPause;
 
@@ -48,6 +52,7 @@ class SmpWaveformGestures {
   bool _attached = false;
 
   bool _isDragging = false;
+  bool _scrubbing = false;
   Duration? _dragStartPos;
   Duration? _dragLastPos;
 
@@ -58,6 +63,8 @@ class SmpWaveformGestures {
     required this.setStartCue,
     required void Function(Duration) setPosition,
     required this.onSeekRequest,
+    this.onScrubRequest,
+    this.onScrubEnd,
     required this.onPause,
     required this.saveDebounced,
     required this.isPlaying,
@@ -164,6 +171,11 @@ class SmpWaveformGestures {
     _mode = GestureMode.idle;
     _isDragging = false;
 
+    if (_scrubbing) {
+      _scrubbing = false;
+      onScrubEnd?.call();
+    }
+
     if (_dragStartPos != null && _dragLastPos != null) {
       final a = _dragStartPos!;
       final b = _dragLastPos!;
@@ -219,6 +231,14 @@ class SmpWaveformGestures {
     waveform.position.value = target;
     _setPositionCallback(target);
 
+    // 드래그 중에는 엔진 스크럽으로 연속 재생 (드래그 업데이트마다 seek하지 않음)
+    final scrub = onScrubRequest;
+    if (scrub != null) {
+      _scrubbing = true;
+      scrub(target);
+      return;
+    }
+
     onSeekRequest(target);
   }
 
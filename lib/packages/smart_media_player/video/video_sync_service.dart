@@ -22,6 +22,7 @@ import 'package:media_kit/media_kit.dart';
 import 'package:media_kit_video/media_kit_video.dart';
 
 import '../engine/engine_api.dart';
+import '../engine/engine_events.dart';
 
 void _logVideoSync(String msg, {bool tick = false}) {
   const bool kTickLog = false; // tick 로그 보고 싶으면 true
@@ -36,7 +37,9 @@ class VideoSyncService {
   Player? _player;
   VideoController? _controller;
 
-  Timer? _tickTimer;
+  // 엔진 이벤트(위치 tick / seek 완료) 구독 → 타이머 대신 엔진 박자에 맞춰 정렬
+  StreamSubscription<EngineEvent>? _tickSub;
+  DateTime? _lastTickAt;
   bool _tickRunning = false;
   bool _disposed = false;
 
@@ -150,7 +153,7 @@ class VideoSyncService {
   }
 
   void detachPlayer() {
-    if (_player == null && _controller == null && _tickTimer == null) {
+    if (_player == null && _controller == null && _tickSub == null) {
       return;
     }
 
@@ -234,20 +237,38 @@ class VideoSyncService {
   // ===============================================================
 
   void _startTickLoop() {
-    if (_tickTimer != null) return;
+    if (_tickSub != null) return;
     if (_disposed) return;
 
-    _tickTimer = Timer.periodic(
-      const Duration(milliseconds: 80),
-      (_) => _onTick(),
-    );
+    _tickSub = EngineApi.instance.events$.listen((e) {
+      switch (e.kind) {
+        case EngineEventKind.seekComplete:
+          // seek 직후 pendingVideoTarget 은 바로 정렬
+          _onTick();
+          break;
+        case EngineEventKind.position:
+          // 정렬 간격은 기존 80ms 이상 유지
+          final now = DateTime.now();
+          if (_lastTickAt != null &&
+              now.difference(_lastTickAt!) <
+                  const Duration(milliseconds: 80)) {
+            return;
+          }
+          _lastTickAt = now;
+          _onTick();
+          break;
+        default:
+          break;
+      }
+    });
 
     _logVideoSync('tick loop started');
   }
 
   void _stopTickLoop() {
-    _tickTimer?.cancel();
-    _tickTimer = null;
+    _tickSub?.cancel();
+    _tickSub = null;
+    _lastTickAt = null;
     _logVideoSync('tick loop stopped');
   }
 
@@ -20,6 +20,11 @@
 //       - gST.receiveSamples()로 변조 샘플을 꺼내
 //         StableBuffer.push()로 링버퍼에 공급
 //       - StableBuffer가 충분히 차 있으면 back-pressure로 디코딩 속도 제어
+//       - seek는 SeekMailbox 명령으로 받아 스레드 안에서 실행 (pre-roll 포함)
+//       - 스크럽(FF/RW·드래그)은 PCM 창 + 그레인 OLA로 직접 StableBuffer에 공급
+//       - 짧은 파일은 전체 PCM 캐시(mmap)가 준비되면 FFmpeg 대신 메모리에서 공급 (seek = 위치 대입)
+//       - A/B 루프는 구간 캐시를 반복 공급, B→A는 크로스페이드 (seek 없음)
+//       - 반복이 안정되면 워커가 미리 렌더한 한 바퀴를 링에 복사만 (SoundTouch 우회)
 //
 //    miniaudio.data_callback:
 //       - MAOutputGuard: 새 파일/seek 직후에는
@@ -32,7 +37,8 @@
 //  특징:
 //    - 디코더 스레드는 gPaused를 보고 "정지 상태면 디코딩 쉬기"
 //    - StableBuffer는 중앙 재생 버퍼 (drop 없음, push 시 block 유사 정책)
-//    - seek 시 ST/StableBuffer/gLastBuffer/SoT/gWarmupNeeded 모두 정합 맞춰 초기화
+//    - StableBuffer는 lock-free SPSC 링 → 콜백은 디코더 때문에 block되지 않음
+//    - seek 시 ST/StableBuffer/gLastSnapshot/SoT/gWarmupNeeded 모두 정합 맞춰 초기화
 // ─────────────────────────────────────────────────────────────
 
 #define MINIAUDIO_IMPLEMENTATION
@@ -40,6 +46,7 @@
 
 #include "../ThirdParty/miniaudio/miniaudio.h"
 #include "../ThirdParty/soundtouch/include/SoundTouch.h"
+#include "stable_buffer.h"
 
 extern "C"
 {
@@ -54,12 +61,61 @@ extern "C"
 #include <atomic>
 #include <vector>
 #include <mutex>
+#include <condition_variable>
 #include <chrono>
 #include <cstdio>
 #include <cstring>
 #include <cmath>
 #include <algorithm>
 #include <cstdint>
+#include <string>
+#include <memory>
+#include <deque>
+#include <functional>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#if defined(__APPLE__)
+#include <pthread.h>
+#endif
+
+// Dart_PostCObject 메시지 레이아웃 (dart_native_api.h와 동일, 헤더 의존 없이 필요한 부분만)
+//  - 함수 포인터는 Dart가 NativeApi.postCObject로 넘겨준다
+typedef int64_t Dart_Port;
+enum Dart_CObject_Type
+{
+    Dart_CObject_kNull = 0,
+    Dart_CObject_kBool,
+    Dart_CObject_kInt32,
+    Dart_CObject_kInt64,
+    Dart_CObject_kDouble,
+    Dart_CObject_kString,
+    Dart_CObject_kArray,
+};
+struct Dart_CObject
+{
+    Dart_CObject_Type type;
+    union
+    {
+        bool as_bool;
+        int32_t as_int32;
+        int64_t as_int64;
+        double as_double;
+        const char *as_string;
+        struct
+        {
+            intptr_t length;
+            Dart_CObject **values;
+        } as_array;
+        struct
+        {
+            int64_t pad[3]; // 나머지 멤버(typed data 등) 크기 맞춤
+        } _reserved;
+    } value;
+};
+typedef bool (*Dart_PostCObjectFn)(Dart_Port port, Dart_CObject *message);
 
 // ─────────────────────────────
 // 네임스페이스
@@ -69,27 +125,154 @@ using namespace soundtouch;
 // ─────────────────────────────
 // 상수
 // ─────────────────────────────
-static constexpr int SAMPLE_RATE = 44100;
+static constexpr int DEFAULT_SAMPLE_RATE = 44100; // 장치가 레이트를 알려주지 않을 때
 static constexpr int CHANNELS = 2;
+static_assert(CHANNELS == STABLE_CHANNELS, "StableBuffer 링과 엔진의 채널 수가 같아야 함");
 static constexpr int BUF_FRAMES = 4096;         // RMS / last buffer
-static constexpr int STABLE_CAP_FRAMES = 16384; // StableBuffer 용량 (프레임 단위)
+static constexpr int STABLE_CAP_MIN_FRAMES = 8192;   // 늦은 스트레치 최대 앞섬 + 여유
+static constexpr int STABLE_CAP_MAX_FRAMES = 262144; // 약 5초 @48kHz
 
 // SoundTouch → StableBuffer로 옮길 때 사용할 청크 크기
 static constexpr int ST_DRAIN_CHUNK_FRAMES = 1024;
+// SoundTouch 내부 FIFO 예약량 (미러 링 → 정상 상태에서 할당/memmove 없음, 넘치면 그때만 늘어남)
+static constexpr int ST_RESERVE_MS = 400;
+// 피치 보간기: 폴리페이즈 windowed-sinc (AA 저역통과가 커널에 포함 → 보간 + AA 필터를 한 번에)
+//  - 0 linear / 1 cubic / 2 shannon / 3 polyphase, 탭 수는 SETTING_AA_FILTER_LENGTH (stretchAaLength)
+static constexpr int ST_TRANSPOSER_ALGORITHM = 3;
 
 // MAOutputGuard:
 //  - 재생/seek 직후 StableBuffer에 최소 몇 프레임이 쌓여야
-//    실제 오디오를 출력할지 결정
-static constexpr int GUARD_MIN_FRAMES = SAMPLE_RATE / 10; // 약 100ms
-
-// StableBuffer 가득 찼을 때 back-pressure 기준
-static constexpr int STABLE_HIGH_WATERMARK_FRAMES = (STABLE_CAP_FRAMES * 3) / 4;
+//    실제 오디오를 출력할지 결정 (기본값, 장치 프로필로 변경)
+static constexpr int GUARD_MIN_MS = 100;
+
+// seek 직후 워밍업 기준
+//  - seek는 pre-roll로 SoundTouch를 미리 채운 뒤 출력하므로
+//    디코더가 실시간보다 훨씬 빨리 채운다 → 짧은 guard로 충분
+static constexpr int SEEK_GUARD_MIN_FRAMES = 512; // 약 12ms
+
+// seek pre-roll 상한 (SoundTouch 초기 지연을 덮을 만큼만)
+static constexpr int SEEK_PREROLL_MAX_MS = 200;
+
+// tempo 1 / pitch 0 우회 — SoundTouch를 거치지 않고 소스를 그대로 링으로
+//  - 진입: SoundTouch를 flush해 남은 출력까지 내보내고, 마지막 부분을 같은 위치의 원본과 크로스페이드
+//  - 해제: 최근 원본으로 SoundTouch를 pre-roll (출력은 버림) → 첫 출력을 원본과 크로스페이드
+static constexpr int BYPASS_XFADE_MS = 10;
+static constexpr float BYPASS_TEMPO_EPS = 1e-4f;
+static constexpr float BYPASS_PITCH_EPS = 1e-3f; // 반음
+
+// 재생 중 대기할 때의 안전망 타임아웃
+//  - 콜백의 lock-free notify가 대기 진입 직전과 겹쳐 유실되는 경우만 커버
+static constexpr int DECODER_SAFETY_WAIT_MS = 20;
+
+// 스크럽 (FF/RW · 파형 드래그)
+//  - 그레인: Hann 창 2048프레임, 50% overlap (hop 1024) → 이음새 없는 OLA
+//  - 링에는 hop 2개 분량만 미리 채움 → 속도 변화가 ~50ms 안에 들림
+//  - PCM 창은 청크 단위로 디코드해서 앞/뒤로 늘리고, 최대 길이를 넘으면 반대쪽을 잘라냄
+static constexpr int SCRUB_GRAIN_FRAMES = 2048;
+static constexpr int SCRUB_HOP_FRAMES = SCRUB_GRAIN_FRAMES / 2;
+static constexpr int SCRUB_AHEAD_FRAMES = SCRUB_HOP_FRAMES * 2;
+static constexpr int SCRUB_CHUNK_FRAMES = 8192;                // 약 186ms
+static constexpr int SCRUB_WINDOW_MAX_MS = 2000;
+static constexpr double SCRUB_MAX_SPEED = 8.0;                  // 원속 대비 배수
+static constexpr double SCRUB_MIN_SPEED = 0.05;                 // 이보다 느리면 fade-out
+static constexpr double SCRUB_FOLLOW_TAU_SEC = 0.08;            // 드래그 추종 시간상수
+
+// 네이티브 A/B 루프
+//  - B → A wrap은 소스 샘플 단위로 정확하게, equal-power 크로스페이드로 이어 붙임
+//  - 구간 PCM은 보조 입력으로 한 번 디코드해 메모리에 두고 반복 공급 (seek/flush 없음)
+//  - 캐시 상한을 넘는 긴 구간은 B에서 FFmpeg 입력만 A로 되감는다 (SoundTouch/링 유지)
+static constexpr int LOOP_XFADE_MS = 10;
+static constexpr int LOOP_CACHE_MAX_MS = 60 * 1000; // 44.1kHz 기준 약 20MB
+static constexpr int LOOP_FEED_CHUNK_FRAMES = 2048;
+
+// 루프 렌더 캐시
+//  - 반복 중인 구간을 현재 tempo/pitch로 한 바퀴 미리 렌더 → 정상 반복 중엔 링에 복사만 (SoundTouch 우회)
+//  - 워커 스레드가 현재 키 + tempo ±STEP 이웃을 백그라운드로 렌더 (슬라이더 미세 조정 시 즉시 교체)
+static constexpr int LOOP_RENDER_MAX_MS = 15 * 1000; // 소스 기준
+static constexpr float LOOP_RENDER_TEMPO_STEP = 0.05f;
+static constexpr size_t LOOP_RENDER_KEEP = 3; // 보관할 렌더 결과 수 (현재 + 이웃 2)
+
+// 전체 파일 PCM 캐시 (mmap)
+//  - 이 길이 이하면 한 번 디코드해 캐시 파일로 두고 seek/루프/스크럽을 메모리에서 바로 처리
+//  - 넘으면 기존 FFmpeg 스트리밍 디코드 유지 (12분 ≈ 254MB @44.1kHz, 277MB @48kHz)
+static constexpr int PCM_CACHE_MAX_MS = 12 * 60 * 1000;
+static constexpr uint32_t PCM_CACHE_VERSION = 1;
+
+// tempo/pitch 변경 램프
+//  - 디코더가 처리 블록(feedSoundTouch 1회)마다 목표값 쪽으로 한 칸씩 → 슬라이더 드래그 시 클릭/정체 없음
+static constexpr int PARAM_RAMP_BLOCKS = 4;
+
+// 늦은 스트레치 모드 (링에는 소스 PCM, SoundTouch는 콜백 직전에)
+//  - 스트레치 워커가 출력 링을 ahead 프레임만큼만 앞서 채움 → tempo/pitch 변경이 ~20ms 안에 들림
+//  - ahead 0 = 자동 (장치 period × AUTO_PERIODS), 그 외는 MIN~MAX로 제한
+//  - 워커는 CHUNK 단위로 SoundTouch에 넣음 (램프 한 칸 = 청크 1개 ≈ 6ms)
+static constexpr int LATE_STRETCH_AUTO_PERIODS = 2;
+static constexpr int LATE_STRETCH_MIN_AHEAD_FRAMES = 256;
+static constexpr int LATE_STRETCH_MAX_AHEAD_MS = 100;
+static constexpr int LATE_STRETCH_CHUNK_FRAMES = 256;
+static constexpr int LATE_STRETCH_SAFETY_WAIT_MS = 5;
+
+// 출력 링 적응 목표량 (jitter buffer, 일반 모드)
+//  - underrun이 나면 즉시 ×GROW, 최근 블록 비용(디코드+스트레치) 최대치로 하한을 정함
+//  - HOLD 동안 underrun이 없으면 SHRINK_STEP마다 ×SHRINK로 하한까지 줄임 → 여유 있을 땐 저지연
+static constexpr int JITTER_MIN_FRAMES = 2048;
+static constexpr double JITTER_GROW = 1.5;
+static constexpr double JITTER_SHRINK = 0.9;
+static constexpr int JITTER_HOLD_MS = 10000;
+static constexpr int JITTER_SHRINK_STEP_MS = 2000;
+static constexpr int JITTER_COST_SAFETY = 3; // 하한 = (블록 비용 최대치 + period) × SAFETY
+static constexpr size_t JITTER_HISTORY = 64;
+
+// SoundTouch 품질 거버너
+//  - WINDOW마다 스트레치 부하(putSamples 시간 / 출력 오디오 길이)와 콜백 부하(실행 시간 / period)를 봄
+//  - DOWN 기준을 넘거나 underrun이 나면 한 단계 내림, UP 기준 아래가 RECOVER 동안 이어지면 한 단계 올림
+//  - 단계를 바꾼 뒤 DWELL 동안은 판단 보류 (히스테리시스)
+static constexpr int GOV_WINDOW_MS = 500;
+static constexpr int GOV_DWELL_MS = 2000;
+static constexpr int GOV_RECOVER_MS = 10000;
+static constexpr double GOV_DOWN_STRETCH_LOAD = 0.35;
+static constexpr double GOV_DOWN_CALLBACK_LOAD = 0.6;
+static constexpr double GOV_UP_STRETCH_LOAD = 0.15;
+static constexpr double GOV_UP_CALLBACK_LOAD = 0.3;
+static constexpr int GOV_MAX_LEVEL = 2;
+static constexpr size_t GOV_HISTORY = 64;
+
+// 정지 중 장치 휴면
+//  - 정지 상태가 이만큼 이어지면 ma_device를 세움 (0 = 끔) → 콜백/스레드 모두 잠듦
+static constexpr int IDLE_STOP_DEFAULT_MS = 30000;
 
 // 기본 파라미터
 static constexpr float DEFAULT_TEMPO = 1.0f;
 static constexpr float DEFAULT_PITCH = 0.0f; // semitones
 static constexpr float DEFAULT_VOL = 1.0f;
 
+// 엔진 샘플레이트 = 출력 장치의 네이티브 레이트
+//  - initAudioDevice에서 한 번 정함 (디코더/콜백 스레드 시작 전) → 이후 읽기 전용
+//  - swr가 소스를 이 레이트로 한 번만 변환, SoundTouch/링/캐시/위치 모두 이 레이트 프레임
+//  - miniaudio 변환기는 레이트 변환 없이 통과 (경로 변경으로 장치 레이트가 바뀐 경우만 재변환)
+static int gSampleRate = DEFAULT_SAMPLE_RATE;
+
+static inline int64_t framesForMs(int64_t ms)
+{
+    return static_cast<int64_t>(gSampleRate) * ms / 1000;
+}
+
+// 장치 프로필 (period / 버퍼 깊이)
+//  - gEngineConfig: st_setEngineConfig 요청 (st_create 전에만 바꿀 수 있음)
+//  - gEngineActual: st_create에서 miniaudio와 협상한 결과 (period는 장치 레이트 프레임)
+//  - periodFrames / periods 0 = miniaudio 기본값
+//  - 마이크 합주용은 작은 period + low_latency, 백그라운드 재생은 큰 period + conservative + 깊은 링
+struct EngineConfig
+{
+    int periodFrames = 0;
+    int periods = 0;
+    bool lowLatency = true; // ma_performance_profile_low_latency / conservative
+    int ringFrames = STABLE_CAP_FRAMES;
+    int warmupMs = GUARD_MIN_MS;
+};
+static EngineConfig gEngineConfig;
+static EngineConfig gEngineActual;
+
 // ─────────────────────────────
 // 로깅
 // ─────────────────────────────
@@ -99,100 +282,493 @@ static inline void logLine(const char *tag, const char *msg)
 }
 
 // ─────────────────────────────
-// StableBuffer — 재생용 링버퍼 (프레임 단위)
-//  - FFmpeg+SoundTouch가 push (producer)
-//  - miniaudio 콜백이 pop (consumer)
-//  - drop 없이, push 시 공간 없으면 0을 리턴
+// DecoderWaker — 디코더 스레드 대기/깨우기
+//  - 디코더는 할 일이 없으면 condition_variable에서 잠든다
+//    (정지/EOF: 무기한, 버퍼 가득: 안전망 타임아웃)
+//  - 제어 스레드(st_play/seek/close)는 lock을 잡고 notify → 유실 없음
+//  - 오디오 콜백은 lock 없이 pending 플래그 + notify_one만 수행
+//    (디코더가 실제로 잠들어 있을 때만, low watermark 아래로 내려간 순간 1회)
 // ─────────────────────────────
-class StableBuffer
+class DecoderWaker
 {
 public:
-    StableBuffer()
+    // 제어 스레드용
+    void notify()
     {
-        buffer_.resize(STABLE_CAP_FRAMES * CHANNELS, 0.0f);
-        clear();
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            pending_.store(true, std::memory_order_release);
+        }
+        cv_.notify_one();
     }
 
-    void clear()
+    // 오디오 콜백용 (lock 없음)
+    void notifyFromAudio()
     {
-        std::lock_guard<std::mutex> lock(mu_);
-        head_ = 0;
-        tail_ = 0;
-        count_ = 0;
-        std::fill(buffer_.begin(), buffer_.end(), 0.0f);
+        if (!waiting_.load(std::memory_order_acquire))
+            return;
+        if (pending_.exchange(true, std::memory_order_acq_rel))
+            return; // 이미 깨우는 중
+        cv_.notify_one();
     }
 
-    // frames 단위 push
-    //  - 가능한 만큼만 쓰고, 실제 쓴 프레임 수를 리턴
-    int push(const float *src, int frames)
+    // 디코더 스레드용
+    //  - timeoutMs <= 0 이면 notify가 올 때까지 무기한 대기
+    void wait(int timeoutMs)
     {
-        if (!src || frames <= 0)
-            return 0;
+        std::unique_lock<std::mutex> lock(mu_);
+        waiting_.store(true, std::memory_order_release);
 
-        std::lock_guard<std::mutex> lock(mu_);
+        auto pred = [this]
+        { return pending_.load(std::memory_order_acquire); };
 
-        int freeFrames = STABLE_CAP_FRAMES - count_;
-        if (freeFrames <= 0)
+        if (timeoutMs > 0)
+        {
+            cv_.wait_for(lock, std::chrono::milliseconds(timeoutMs), pred);
+        }
+        else
         {
-            return 0; // 더 이상 쓸 공간 없음
+            cv_.wait(lock, pred);
         }
 
-        int framesToWrite = std::min(frames, freeFrames);
+        pending_.store(false, std::memory_order_release);
+        waiting_.store(false, std::memory_order_release);
+        wakeups_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint64_t wakeups() const
+    {
+        return wakeups_.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::mutex mu_;
+    std::condition_variable cv_;
+    std::atomic<bool> pending_{false};
+    std::atomic<bool> waiting_{false};
+    std::atomic<uint64_t> wakeups_{0};
+};
+
+// ─────────────────────────────
+// SeekMailbox — seek 명령 우편함 (lock-free, 최신 타겟만 유지)
+//  - 어느 스레드에서든 post (FFI)
+//  - 디코더 스레드가 fetch해서 실행
+//  - FF/RW·드래그 등으로 연속 post되면 중간 타겟은 자연히 덮어써짐 (coalescing)
+//  - seq는 단조 증가: 디코더가 처리한 seq와 다르면 "seek 진행 중"
+// ─────────────────────────────
+class SeekMailbox
+{
+public:
+    uint64_t post(double ms)
+    {
+        targetMs_.store(ms, std::memory_order_relaxed);
+        return seq_.fetch_add(1, std::memory_order_acq_rel) + 1;
+    }
+
+    // 새 명령이 있으면 true + 타겟 반환, seenSeq를 최신으로 갱신
+    //  - 덮어써진 명령 수는 coalesced 카운터로 집계
+    bool fetch(uint64_t &seenSeq, double &ms)
+    {
+        const uint64_t seq = seq_.load(std::memory_order_acquire);
+        if (seq == seenSeq)
+            return false;
+
+        ms = targetMs_.load(std::memory_order_relaxed);
+        coalesced_.fetch_add(seq - seenSeq - 1, std::memory_order_relaxed);
+        seenSeq = seq;
+        return true;
+    }
+
+    uint64_t latest() const
+    {
+        return seq_.load(std::memory_order_acquire);
+    }
+
+    uint64_t coalesced() const
+    {
+        return coalesced_.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint64_t> seq_{0};
+    std::atomic<double> targetMs_{0.0};
+    std::atomic<uint64_t> coalesced_{0};
+};
+
+// ─────────────────────────────
+// ParamMailbox — tempo/pitch 목표값 우편함 (lock-free)
+//  - FFI(UI 스레드)는 값만 쓰고 seq 증가 → gMutex를 잡지 않음
+//  - 디코더 스레드가 처리 블록마다 한 번 fetch → tempo/pitch 동시 변경도 재설정 1회
+// ─────────────────────────────
+class ParamMailbox
+{
+public:
+    void setTempo(float tempo)
+    {
+        tempo_.store(tempo, std::memory_order_relaxed);
+        seq_.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    void setPitch(float semitones)
+    {
+        pitch_.store(semitones, std::memory_order_relaxed);
+        seq_.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    // 새 값이 있으면 true + 목표값 반환, seenSeq를 최신으로 갱신
+    bool fetch(uint64_t &seenSeq, float &tempo, float &pitch) const
+    {
+        const uint64_t seq = seq_.load(std::memory_order_acquire);
+        if (seq == seenSeq)
+            return false;
+
+        tempo = tempo_.load(std::memory_order_relaxed);
+        pitch = pitch_.load(std::memory_order_relaxed);
+        seenSeq = seq;
+        return true;
+    }
+
+    float tempo() const
+    {
+        return tempo_.load(std::memory_order_relaxed);
+    }
+
+    float pitch() const
+    {
+        return pitch_.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint64_t> seq_{0};
+    std::atomic<float> tempo_{DEFAULT_TEMPO};
+    std::atomic<float> pitch_{DEFAULT_PITCH};
+};
+
+// ─────────────────────────────
+// RingMarkerQueue — StableBuffer 위치에 붙이는 이벤트 마커 (lock-free SPSC)
+//  - 디코더가 "링의 이 위치부터는 소스 위치가 X / 소스:출력 비율이 r" 같은 사실을 미리 push
+//  - 콜백은 해당 프레임을 실제로 출력한 블록에서 pop해 적용
+//    → 루프 wrap 시 SoT 점프/남은 반복 갱신, tempo 변경 후 SoT 전진 속도가 귀에 들리는 시점과 일치
+//  - epoch가 현재 링과 다르면 (seek/스크럽으로 clear됨) 버림
+// ─────────────────────────────
+struct RingMarker
+{
+    size_t ringPos = 0;      // StableBuffer 누적 쓰기 위치
+    int64_t srcFrame = -1;   // 이 위치의 소스 프레임 (-1 = SoT 그대로)
+    double rate = 0.0;       // 이 위치부터 출력 1프레임당 소스 프레임 (0 = 그대로)
+    bool loopEvent = false;  // 루프 한 바퀴 끝 (남은 반복 갱신 + EV_LOOP_WRAP)
+    bool endOfStream = false; // 소스 링 전용: 여기까지가 스트림 끝 (워커가 SoundTouch flush)
+    int loopRemaining = 0;   // 이 위치부터 보고할 남은 반복 (-1 = 무한)
+    uint32_t epoch = 0;
+};
+
+class RingMarkerQueue
+{
+public:
+    // producer (디코더 스레드) — 가득 차면 버림
+    bool push(const RingMarker &m)
+    {
+        const uint32_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) >= CAP)
+            return false;
+        slots_[head % CAP] = m;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
 
-        for (int f = 0; f < framesToWrite; ++f)
+    // consumer (오디오 콜백) — readEnd까지 출력된 마커를 순서대로 적용
+    template <typename Fn>
+    void consumeUpTo(size_t readEnd, uint32_t epoch, Fn &&apply)
+    {
+        uint32_t tail = tail_.load(std::memory_order_relaxed);
+        const uint32_t head = head_.load(std::memory_order_acquire);
+        while (tail != head)
         {
-            for (int c = 0; c < CHANNELS; ++c)
+            const RingMarker &m = slots_[tail % CAP];
+            if (m.epoch == epoch)
             {
-                buffer_[head_ * CHANNELS + c] = src[f * CHANNELS + c];
+                if (m.ringPos > readEnd)
+                    break;
+                apply(m, readEnd);
             }
-            head_ = (head_ + 1) % STABLE_CAP_FRAMES;
+            ++tail;
         }
-        count_ += framesToWrite;
-        return framesToWrite;
+        tail_.store(tail, std::memory_order_release);
     }
 
-    // frames 단위 pop
-    //  - 실제 가져온 프레임 수 리턴
-    int pop(float *dst, int maxFrames)
+    // consumer — 현재 epoch의 맨 앞 마커 (옛 epoch 마커는 버림)
+    bool peek(uint32_t epoch, RingMarker &out)
     {
-        if (!dst || maxFrames <= 0)
-            return 0;
+        uint32_t tail = tail_.load(std::memory_order_relaxed);
+        const uint32_t head = head_.load(std::memory_order_acquire);
+        while (tail != head && slots_[tail % CAP].epoch != epoch)
+        {
+            ++tail;
+        }
+        tail_.store(tail, std::memory_order_release);
+        if (tail == head)
+            return false;
+        out = slots_[tail % CAP];
+        return true;
+    }
 
-        std::lock_guard<std::mutex> lock(mu_);
+    // consumer — peek으로 본 마커를 소비
+    void popFront()
+    {
+        tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
 
-        if (count_ <= 0)
-            return 0;
+private:
+    static constexpr uint32_t CAP = 32;
+    RingMarker slots_[CAP];
+    std::atomic<uint32_t> head_{0};
+    std::atomic<uint32_t> tail_{0};
+};
+
+// ─────────────────────────────
+// EngineEventQueue — 엔진 이벤트 (생산 스레드 1개 → 알림 스레드)
+//  - 오디오 콜백 / 디코더 스레드가 각자 하나씩 가진다 (SPSC, lock-free)
+//  - 가득 차면 버림 (dropped 카운트만 증가) → 콜백은 절대 막히지 않음
+// ─────────────────────────────
+enum EngineEventKind : int32_t
+{
+    EV_POSITION = 1,     // value = SoT ms
+    EV_UNDERRUN = 2,     // value = 부족했던 프레임 수 (underrun 시작 시 1회)
+    EV_END_OF_STREAM = 3,
+    EV_LOOP_WRAP = 4,    // value = 남은 반복 (-1 = 무한, 0 = 루프 종료 후 B 이후로 진행)
+    EV_SEEK_COMPLETE = 5, // value = 타겟 ms
+    EV_DEVICE_CHANGE = 6, // value = ma_device_notification_type
+    EV_DEVICE_IDLE = 7,   // value = 1 휴면 진입 / 0 재개
+};
+
+struct EngineEvent
+{
+    int32_t kind = 0;
+    int64_t value = 0;
+    int64_t timeNs = 0; // steady clock
+};
 
-        int framesToRead = std::min(maxFrames, count_);
-        for (int f = 0; f < framesToRead; ++f)
+class EngineEventQueue
+{
+public:
+    bool push(int32_t kind, int64_t value, int64_t timeNs)
+    {
+        const uint32_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) >= CAP)
         {
-            for (int c = 0; c < CHANNELS; ++c)
-            {
-                dst[f * CHANNELS + c] = buffer_[tail_ * CHANNELS + c];
-            }
-            tail_ = (tail_ + 1) % STABLE_CAP_FRAMES;
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
         }
-        count_ -= framesToRead;
-        return framesToRead;
+        slots_[head % CAP] = EngineEvent{kind, value, timeNs};
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(EngineEvent &out)
+    {
+        const uint32_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire))
+            return false;
+        out = slots_[tail % CAP];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    uint64_t dropped() const
+    {
+        return dropped_.load(std::memory_order_relaxed);
     }
 
-    int size() const
+private:
+    static constexpr uint32_t CAP = 256;
+    EngineEvent slots_[CAP];
+    std::atomic<uint32_t> head_{0};
+    std::atomic<uint32_t> tail_{0};
+    std::atomic<uint64_t> dropped_{0};
+};
+
+// ─────────────────────────────
+// LoopMailbox — A/B 루프 설정 (FFI → 디코더 스레드)
+//  - 드물게 바뀌는 설정이라 mutex로 통째 복사, seq로 변경 여부만 lock 없이 확인
+// ─────────────────────────────
+struct LoopCommand
+{
+    bool enabled = false;
+    double aMs = 0.0;
+    double bMs = 0.0;
+    int repeat = 0; // 0 = 무한
+};
+
+class LoopMailbox
+{
+public:
+    void post(const LoopCommand &cmd)
     {
         std::lock_guard<std::mutex> lock(mu_);
-        return count_;
+        cmd_ = cmd;
+        seq_.fetch_add(1, std::memory_order_release);
     }
 
-    int capacity() const
+    bool fetch(uint64_t &seenSeq, LoopCommand &out)
     {
-        return STABLE_CAP_FRAMES;
+        if (seq_.load(std::memory_order_acquire) == seenSeq)
+            return false;
+        std::lock_guard<std::mutex> lock(mu_);
+        out = cmd_;
+        seenSeq = seq_.load(std::memory_order_relaxed);
+        return true;
     }
 
 private:
-    std::vector<float> buffer_;
-    int head_ = 0;
-    int tail_ = 0;
-    int count_ = 0;
-    mutable std::mutex mu_;
+    std::mutex mu_;
+    LoopCommand cmd_;
+    std::atomic<uint64_t> seq_{0};
+};
+
+// ─────────────────────────────
+// LastBufferSnapshot — 파형/RMS용 마지막 출력 블록 (triple buffer)
+//  - writer: miniaudio 콜백 1개 (lock 없이 publish)
+//  - reader: FFI(st_copyLastBuffer / st_getRmsLevel)
+//  - 슬롯 3개: writer는 back, reader는 front, 가운데(middle)는 교환용
+//    → publish = back과 middle을 atomic 교환 (FRESH 비트 세팅)
+//    → reader는 FRESH일 때만 front와 middle을 교환
+//  - writer와 reader가 같은 슬롯을 동시에 만지는 일이 없으므로 tearing 없음
+//  - reader 끼리만 readerMu_로 직렬화 (오디오 스레드는 절대 잡지 않음)
+// ─────────────────────────────
+class LastBufferSnapshot
+{
+public:
+    LastBufferSnapshot()
+    {
+        for (auto &slot : slots_)
+        {
+            slot.data.assign(BUF_FRAMES * CHANNELS, 0.0f);
+            slot.frames = 0;
+        }
+    }
+
+    // ── writer (콜백 전용) ──
+
+    // 출력 블록을 복사해서 publish (BUF_FRAMES 초과분은 잘라냄)
+    void publish(const float *src, int frames)
+    {
+        Slot &slot = slots_[back_];
+        const int n = std::max(0, std::min(frames, BUF_FRAMES));
+        if (n > 0)
+        {
+            std::memcpy(slot.data.data(), src, n * CHANNELS * sizeof(float));
+        }
+        slot.frames = n;
+        swapBack();
+        silent_ = (n == 0);
+    }
+
+    // 무음 publish — 이미 무음이면 아무것도 안 함 (정지 중 매 콜백 memset 방지)
+    void publishSilence()
+    {
+        if (clearRequested_.exchange(false, std::memory_order_acq_rel))
+        {
+            silent_ = false;
+        }
+        if (silent_)
+            return;
+
+        slots_[back_].frames = 0;
+        swapBack();
+        silent_ = true;
+    }
+
+    // 콜백이 아닌 스레드에서의 초기화 요청 (seek/close 등)
+    //  - 실제 무음 publish는 다음 콜백이 수행
+    void requestClear()
+    {
+        clearRequested_.store(true, std::memory_order_release);
+    }
+
+    // 콜백이 돌지 않는 상태(디바이스 미기동/해제 후)에서만 호출
+    void resetUnsafe()
+    {
+        std::lock_guard<std::mutex> lock(readerMu_);
+        for (auto &slot : slots_)
+        {
+            slot.frames = 0;
+        }
+        silent_ = true;
+        clearRequested_.store(false);
+    }
+
+    bool clearPending() const
+    {
+        return clearRequested_.load(std::memory_order_acquire);
+    }
+
+    // ── reader (FFI) ──
+
+    // 최신 스냅샷을 dst에 복사 (frames 이후는 0으로 채움)
+    void copyTo(float *dst, int maxFrames)
+    {
+        std::lock_guard<std::mutex> lock(readerMu_);
+        const Slot &slot = acquireFront();
+        const int frames = std::min(maxFrames, BUF_FRAMES);
+        const int valid = std::min(frames, slot.frames);
+
+        if (valid > 0)
+        {
+            std::memcpy(dst, slot.data.data(), valid * CHANNELS * sizeof(float));
+        }
+        if (valid < frames)
+        {
+            std::memset(dst + valid * CHANNELS, 0, (frames - valid) * CHANNELS * sizeof(float));
+        }
+    }
+
+    // 최신 스냅샷의 RMS (BUF_FRAMES 전체 기준, 빈 구간은 0으로 취급)
+    double rms()
+    {
+        std::lock_guard<std::mutex> lock(readerMu_);
+        const Slot &slot = acquireFront();
+
+        double sum = 0.0;
+        const int n = slot.frames * CHANNELS;
+        for (int i = 0; i < n; ++i)
+        {
+            const double v = static_cast<double>(slot.data[i]);
+            sum += v * v;
+        }
+        return std::sqrt(sum / static_cast<double>(BUF_FRAMES * CHANNELS));
+    }
+
+private:
+    struct Slot
+    {
+        std::vector<float> data;
+        int frames = 0;
+    };
+
+    static constexpr uint8_t FRESH = 0x4;
+    static constexpr uint8_t INDEX_MASK = 0x3;
+
+    void swapBack()
+    {
+        back_ = middle_.exchange(static_cast<uint8_t>(back_ | FRESH), std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    const Slot &acquireFront()
+    {
+        if (middle_.load(std::memory_order_acquire) & FRESH)
+        {
+            front_ = middle_.exchange(front_, std::memory_order_acq_rel) & INDEX_MASK;
+        }
+        return slots_[front_];
+    }
+
+    Slot slots_[3];
+    uint8_t back_ = 0;                // writer 소유
+    uint8_t front_ = 1;               // reader 소유
+    std::atomic<uint8_t> middle_{2};  // 교환용 (+ FRESH 비트)
+    bool silent_ = true;              // writer 소유
+    std::atomic<bool> clearRequested_{false};
+    std::mutex readerMu_;
 };
 
 // ─────────────────────────────
@@ -202,26 +778,83 @@ private:
 // StableBuffer (재생용 중앙 링버퍼)
 static StableBuffer gStable;
 
+// 출력 링 목표량 (JitterController가 조절, 일반 모드)
+//  - 디코더는 이만큼까지만 채우고, 콜백은 2/3 아래로 내려가면 디코더를 깨움
+static std::atomic<int> gFillTarget{STABLE_CAP_FRAMES * 3 / 4};
+static std::atomic<uint32_t> gUnderrunCount{0}; // 콜백 → underrun 시작 횟수
+
 // SoundTouch
 static SoundTouch gST;
-static std::mutex gMutex; // SoundTouch + gLastBuffer 보호
+static std::mutex gMutex; // SoundTouch 보호 (오디오 콜백은 잡지 않음)
 
-// 현재 tempo / pitch 상태 (SoundTouch 파라미터 튜닝용)
-static std::atomic<float> gTempo{DEFAULT_TEMPO};
-static std::atomic<float> gPitch{DEFAULT_PITCH};
+// tempo / pitch 목표값 (FFI → 디코더, 루프 렌더 키)
+static ParamMailbox gParamBox;
 
 // miniaudio
 static ma_device gDevice{};
 static std::atomic<bool> gDeviceStarted{false};
 
-// 재생 시간 = 실제 출력된 샘플 수 (SoT)
+// 재생 시간 (SoT) = 링에서 꺼내 출력한 지점의 소스 프레임 (엔진 레이트 기준)
+//  - 콜백이 출력 프레임 × (소스/출력 비율)로 전진 → tempo와 무관하게 소스 타임라인
+//  - seek/스크럽/open/close 같은 외부 대입은 setPlayheadFrames()로 (gPlayheadSeq 증가)
 static std::atomic<uint64_t> gProcessedSamples{0};
+static std::atomic<uint64_t> gPlayheadSeq{0};
+
+// 지금 스피커에서 들리는 소스 프레임 (SoT - 출력 장치 지연, 콜백이 publish)
+//  - gAudibleSeq가 gPlayheadSeq와 같을 때만 유효 (외부 대입 직후에는 SoT 그대로)
+static std::atomic<uint64_t> gAudibleSamples{0};
+static std::atomic<uint64_t> gAudibleSeq{0};
+
+// 출력 장치 지연 / period (엔진 레이트 기준 프레임, 디바이스 init/경로 변경 시 갱신)
+static std::atomic<int> gDeviceLatencyFrames{0};
+static std::atomic<int> gDevicePeriodFrames{0};
+
+// 장치 휴면 (IdleMonitor)
+//  - 장치 시작/정지는 gDeviceStateMutex 안에서만 (모니터 ↔ st_play/스크럽 경합 방지)
+//  - gLastActiveNs: 마지막 재생/정지/스크럽 요청 시각 → 여기서 gIdleStopMs가 지나면 휴면
+//  - gWakeStartNs: 휴면 해제 요청 시각 → 첫 콜백이 소비하며 gLastWakeLatencyNs 기록
+static std::mutex gDeviceStateMutex;
+static std::atomic<int> gIdleStopMs{IDLE_STOP_DEFAULT_MS};
+static std::atomic<bool> gDeviceIdle{false};
+static std::atomic<int64_t> gLastActiveNs{0};
+static std::atomic<int64_t> gWakeStartNs{0};
+static std::atomic<int64_t> gLastWakeLatencyNs{0};
+
+static inline void setPlayheadFrames(uint64_t frame)
+{
+    gProcessedSamples.store(frame);
+    gPlayheadSeq.fetch_add(1, std::memory_order_release);
+}
+
+// UI / 이벤트 / 비디오 싱크가 보는 위치
+static inline uint64_t audiblePlayheadFrames()
+{
+    const uint64_t seq = gPlayheadSeq.load(std::memory_order_acquire);
+    const uint64_t audible = gAudibleSamples.load(std::memory_order_acquire);
+    if (gAudibleSeq.load(std::memory_order_acquire) == seq)
+    {
+        return audible;
+    }
+    return gProcessedSamples.load();
+}
 
 // 출력 볼륨
 static std::atomic<float> gVolume{DEFAULT_VOL};
 
-// 파형/RMS용 마지막 출력 버퍼
-static std::vector<float> gLastBuffer(BUF_FRAMES *CHANNELS);
+// 콜백 실행 시간 계측 (worst-case, ns)
+static std::atomic<uint64_t> gCbMaxNs{0};
+static std::atomic<uint64_t> gCbCount{0};
+static std::atomic<int> gCbLoadPeak{0}; // 실행 시간 / period (‰), 거버너가 창마다 가져가며 0으로
+
+// SoundTouch 품질 단계 (StretchGovernor → 튜닝 적용, 0 = 최고 품질)
+static std::atomic<int> gStretchQuality{0};
+
+// tempo 1 / pitch 0 우회 (FFI 허용 여부 / 디코더가 실제로 우회 중인지)
+static std::atomic<bool> gBypassEnabled{true};
+static std::atomic<bool> gStretchBypassed{false};
+
+// 파형/RMS용 마지막 출력 버퍼 (콜백 → FFI, lock-free publish)
+static LastBufferSnapshot gLastSnapshot;
 
 // FFmpeg 디코더
 static std::once_flag gFFmpegInitOnce;
@@ -229,8 +862,18 @@ static AVFormatContext *gFmtCtx = nullptr;
 static AVCodecContext *gCodecCtx = nullptr;
 static SwrContext *gSwr = nullptr;
 static int gAudioStreamIndex = -1;
+static std::string gFilePath; // 보조 입력(루프 구간 캐시)용 — 디코더 스레드가 없을 때만 변경
 static std::thread gDecodeThread;
 static std::atomic<bool> gDecodeRunning{false};
+static DecoderWaker gDecodeWaker;
+
+// seek 명령 (FFI → 디코더 스레드)
+static SeekMailbox gSeekBox;
+static std::atomic<uint64_t> gSeekServedSeq{0}; // 디코더가 실행 완료한 seek seq
+
+// seek → 첫 오디오 출력까지 걸린 시간 측정
+static std::atomic<int64_t> gSeekStartNs{0};          // 0 = 측정 중 아님
+static std::atomic<int64_t> gLastSeekLatencyNs{-1};   // -1 = 아직 없음
 static std::atomic<bool> gFileOpened{false};
 static double gDurationMs = 0.0;
 
@@ -241,6 +884,81 @@ static std::atomic<bool> gPaused{true}; // 기본 정지
 
 // MAOutputGuard: 재생/seek/파일오픈 직후 워밍업 필요 여부
 static std::atomic<bool> gWarmupNeeded{false};
+static std::atomic<int> gWarmupFrames{0}; // 이번 워밍업 기준
+
+// 실제 워밍업 분량 — 목표량이 줄어든 뒤에도 디코더가 채울 수 있는 만큼만
+static inline int warmupFrames()
+{
+    return std::min(gWarmupFrames.load(std::memory_order_relaxed), gFillTarget.load(std::memory_order_relaxed));
+}
+
+// 스크럽 명령 (FFI → 디코더 스레드)
+//  - gScrubMode: OFF / VELOCITY(고정 속도, FF/RW) / FOLLOW(타겟 추종, 드래그)
+//  - gScrubActive: 디코더가 실제로 스크럽 출력 중인지 (콜백/SoT 분기용)
+enum ScrubMode : int
+{
+    SCRUB_OFF = 0,
+    SCRUB_VELOCITY = 1,
+    SCRUB_FOLLOW = 2,
+};
+static std::atomic<int> gScrubMode{SCRUB_OFF};
+static std::atomic<double> gScrubVelocity{0.0}; // 원속 대비 배수, 음수 = 역방향
+static std::atomic<double> gScrubTargetMs{0.0};
+static std::atomic<bool> gScrubActive{false};
+
+// A/B 루프 (FFI → 디코더), 남은 반복은 마커를 통해 콜백이 갱신
+static LoopMailbox gLoopBox;
+static std::atomic<int> gLoopRemaining{0}; // -1 = 무한, 0 = 루프 없음/소진
+static RingMarkerQueue gRingMarkers;
+static std::atomic<uint64_t> gLoopRenderedFrames{0}; // 렌더 캐시에서 바로 내보낸 출력 프레임 (진단용)
+static std::atomic<uint64_t> gCopyBytesSaved{0};     // 중간 버퍼를 거치지 않고 옮긴 바이트 (진단용)
+static std::atomic<uint64_t> gCopySavedFrames{0};    // 그 경로로 링에 들어간 출력 프레임 = 위 바이트가 담당한 재생 오디오
+
+// 스트림 끝 상태 (디코더 → 콜백)
+//  - DRAINING: 디코더/리샘플러/SoundTouch 꼬리까지 링에 다 넣음 → 링이 비면 ENDED
+//  - ENDED에서 콜백이 완료 이벤트를 한 번 올림 (st_consumeEndOfStream)
+enum StreamEndState : int
+{
+    STREAM_PLAYING = 0,
+    STREAM_DRAINING = 1,
+    STREAM_ENDED = 2,
+};
+static std::atomic<int> gStreamEnd{STREAM_PLAYING};
+static std::atomic<bool> gEndOfStreamEvent{false};
+
+// 늦은 스트레치 모드 (디코더 → 소스 링 → 스트레치 워커 → StableBuffer)
+//  - gLateStretchReq: FFI 요청 / gLateActive: 디코더가 실제로 전환한 상태
+//  - gStretchStepMutex: 워커 step 1회 동안 잡힘 → seek/스크럽 진입은 이걸 잡고 파이프라인을 비운다
+//  - gLateDropOut: seek pre-roll 출력 버림 수 (디코더 → 워커, 소스 링 epoch가 바뀔 때 인계)
+//  - gStretchTarget: 워커가 지금 맞추는 출력 링 목표량 (콜백이 이보다 적으면 워커를 깨움)
+static StableBuffer gSourceRing;
+static RingMarkerQueue gSourceMarkers;
+static std::atomic<bool> gLateStretchReq{false};
+static std::atomic<bool> gLateActive{false};
+static std::atomic<int> gStretchAheadReq{0};
+static std::atomic<int> gStretchTarget{0};
+static std::atomic<int64_t> gLateDropOut{0};
+static std::mutex gStretchStepMutex;
+static DecoderWaker gStretchWaker;
+
+// 엔진 이벤트 → Dart (SendPort)
+//  - 콜백/디코더는 각자 큐에 넣고 알림 스레드가 Dart_PostCObject로 전달
+//  - 위치 tick은 알림 스레드가 재생 중에만 주기적으로 만든다
+static EngineEventQueue gAudioEvents;
+static EngineEventQueue gDecoderEvents;
+static std::atomic<int> gDeviceChangeType{-1}; // miniaudio 알림 스레드 → -1 = 없음
+static std::atomic<int> gDeviceIdleEvent{-1};  // IdleMonitor / FFI → -1 = 없음
+static DecoderWaker gEventWaker;
+static std::thread gEventThread;
+static std::atomic<bool> gEventRunning{false};
+static std::atomic<int> gPositionTickHz{30};
+
+static inline int64_t steadyNowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
 
 // ─────────────────────────────
 // 내부 유틸 - SoundTouch 파라미터 튜닝
@@ -254,30 +972,45 @@ static std::atomic<bool> gWarmupNeeded{false};
 // 내부 유틸 - SoundTouch 파라미터 튜닝 (하이브리드 버전)
 //  - gMutex 잠긴 상태에서만 호출해야 함 (unsafe)
 // ─────────────────────────────
-static inline void applySoundTouchParams_unsafe()
+//  - configureSoundTouch: 임의의 SoundTouch 인스턴스용 (루프 렌더 워커도 같은 튜닝을 써야 이음새가 맞음)
+//  - 튜닝값은 tempo 구간(band)별로 고정 → 구간이 바뀔 때만 setSetting 필요
+struct StretchBand
 {
-    float tempo = gTempo.load();
-    float pitch = gPitch.load();
+    int seqMs;
+    int seekMs;
+    int ovlMs;
+    int quick;
+    int pyramid; // coarse-to-fine seek (quick보다 우선)
+};
 
+// tempo → 튜닝 구간 (0: 원속 근처 / 1: 연습 구간 / 2: 극단 슬로우)
+static int stretchBandOf(float tempo)
+{
     if (tempo <= 0.0f)
     {
         tempo = DEFAULT_TEMPO;
     }
 
     // 0.5x ~ 1.7x 범위 안으로만 제한
-    float t = tempo;
-    if (t < 0.5f)
-        t = 0.5f;
-    if (t > 1.7f)
-        t = 1.7f;
+    const float t = std::max(0.5f, std::min(1.7f, tempo));
+
+    if (t >= 0.90f && t <= 1.10f)
+        return 0;
+    if (t >= 0.75f)
+        return 1;
+    return 2;
+}
 
+static StretchBand stretchBandParams(int band)
+{
     float seqMs;
     float seekMs;
     float ovlMs;
     int quick;
+    int pyramid = 0;
 
     // 🔵 구간 1: 0.90x ~ 1.10x (거의 원속 = 음질 최우선)
-    if (t >= 0.90f && t <= 1.10f)
+    if (band == 0)
     {
         seqMs = 60.0f; // 넉넉한 윈도 (자연스러운 톤/보컬)
         seekMs = 26.0f;
@@ -285,7 +1018,7 @@ static inline void applySoundTouchParams_unsafe()
         quick = 1;
     }
     // 🟢 구간 2: 0.75x ~ 0.90x (실제 카피/연습 구간 = 밸런스)
-    else if (t >= 0.75f)
+    else if (band == 1)
     {
         seqMs = 45.0f; // 약간 짧게 → 타이트 + 안정성 타협
         seekMs = 20.0f;
@@ -298,7 +1031,8 @@ static inline void applySoundTouchParams_unsafe()
         seqMs = 36.0f; // 너무 짧지 않게 조금만 줄임 (이전 32보다 살짝 완화)
         seekMs = 18.0f;
         ovlMs = 9.0f;
-        quick = 0; // 정확도 우선, 대신 아티팩트 약간 감수
+        quick = 0;
+        pyramid = 1; // full search와 거의 같은 위치를 quickseek 비용으로
     }
 
     // 안전 범위 클램프
@@ -306,466 +1040,3796 @@ static inline void applySoundTouchParams_unsafe()
     seekMs = std::max(10.0f, std::min(50.0f, seekMs));
     ovlMs = std::max(5.0f, std::min(24.0f, ovlMs));
 
-    // 🔧 anti-alias 필터 ON (고역 보글보글 약간 완화 목적)
-    gST.setSetting(SETTING_SEQUENCE_MS, (int)seqMs);
-    gST.setSetting(SETTING_SEEKWINDOW_MS, (int)seekMs);
-    gST.setSetting(SETTING_OVERLAP_MS, (int)ovlMs);
-    gST.setSetting(SETTING_USE_QUICKSEEK, quick);
-    gST.setSetting(SETTING_USE_AA_FILTER, 1);
-
-    gST.setTempo(tempo);
-    gST.setPitchSemiTones(pitch);
-
-    std::printf(
-        "[ST] params tempo=%.3f (t=%.3f) seq=%.1f seek=%.1f ovl=%.1f quick=%d\n",
-        tempo, t, seqMs, seekMs, ovlMs, quick);
+    return StretchBand{(int)seqMs, (int)seekMs, (int)ovlMs, quick, pyramid};
 }
 
-// FFmpeg 초기화 (once)
-static void initFFmpegOnce()
+// 품질 단계 (CPU 부하 시 StretchGovernor가 올림)
+//  - 0: 구간 튜닝 그대로 / 1: quickseek 강제 + 보간 24탭 / 2: + seek window ×0.6, 보간 16탭
+//  - pyramid seek은 이미 quickseek 수준 비용이라 단계와 무관하게 유지
+//  - 폴리페이즈 32탭 ≈ 기존 cubic + AA 64탭 비용 (저지대역 -75dB vs -57dB), 24탭은 그보다 가벼움
+static int stretchAaLength(int quality)
 {
-    std::call_once(gFFmpegInitOnce, []()
-                   {
-        av_log_set_level(AV_LOG_ERROR);
-        avformat_network_init();
-        logLine("FFmpeg", "initialized"); });
+    return quality >= 2 ? 16 : quality == 1 ? 24 : 32;
 }
 
-// SoundTouch 초기화
-static void initSoundTouch()
+static void applyStretchBand(SoundTouch &st, int band, int quality)
 {
-    std::lock_guard<std::mutex> lock(gMutex);
+    StretchBand p = stretchBandParams(band);
+    if (quality >= 1)
+    {
+        p.quick = 1;
+    }
+    if (quality >= 2)
+    {
+        p.seekMs = std::max(10, p.seekMs * 3 / 5);
+    }
 
-    gST.setSampleRate(SAMPLE_RATE);
-    gST.setChannels(CHANNELS);
+    // 🔧 anti-alias 필터 ON (고역 보글보글 약간 완화 목적)
+    st.setSetting(SETTING_SEQUENCE_MS, p.seqMs);
+    st.setSetting(SETTING_SEEKWINDOW_MS, p.seekMs);
+    st.setSetting(SETTING_OVERLAP_MS, p.ovlMs);
+    st.setSetting(SETTING_USE_QUICKSEEK, p.quick);
+    st.setSetting(SETTING_USE_PYRAMIDSEEK, p.pyramid);
+    st.setSetting(SETTING_USE_AA_FILTER, 1);
+    st.setSetting(SETTING_AA_FILTER_LENGTH, stretchAaLength(quality));
+}
 
-    // tempo / pitch 기본값 세팅 + 파라미터 튜닝
-    gTempo.store(DEFAULT_TEMPO);
-    gPitch.store(DEFAULT_PITCH);
-    applySoundTouchParams_unsafe();
+static void configureSoundTouch(SoundTouch &st, float tempo, float pitch, bool verbose)
+{
+    if (tempo <= 0.0f)
+    {
+        tempo = DEFAULT_TEMPO;
+    }
 
-    gVolume.store(DEFAULT_VOL);
-    gProcessedSamples.store(0);
-    std::fill(gLastBuffer.begin(), gLastBuffer.end(), 0.0f);
+    const int band = stretchBandOf(tempo);
+    const int quality = gStretchQuality.load();
+    applyStretchBand(st, band, quality);
 
-    logLine("SoundTouch", "initialized");
+    st.setTempo(tempo);
+    st.setPitchSemiTones(pitch);
+
+    if (verbose)
+    {
+        const StretchBand p = stretchBandParams(band);
+        std::printf(
+            "[ST] params tempo=%.3f pitch=%.2f band=%d seq=%d seek=%d ovl=%d quick=%d pyramid=%d quality=%d\n",
+            tempo, pitch, band, p.seqMs, p.seekMs, p.ovlMs, p.quick, p.pyramid, quality);
+    }
 }
 
-// FFmpeg 파일 닫기
-static void closeFileInternal()
+static inline void applySoundTouchParams_unsafe()
 {
-    // 디코더 스레드 중지
-    gDecodeRunning.store(false);
-    if (gDecodeThread.joinable())
+    configureSoundTouch(gST, gParamBox.tempo(), gParamBox.pitch(), true);
+}
+
+// tempo/pitch 램프 상태 (디코더 스레드 전용, initSoundTouch에서 초기화)
+//  - applied*: 지금 gST에 걸린 값 / band: 지금 걸린 튜닝 구간
+//  - step == PARAM_RAMP_BLOCKS 이면 목표값 도달 (할 일 없음)
+struct ParamRamp
+{
+    uint64_t seenSeq = 0;
+    float fromTempo = DEFAULT_TEMPO;
+    float fromPitch = DEFAULT_PITCH;
+    float toTempo = DEFAULT_TEMPO;
+    float toPitch = DEFAULT_PITCH;
+    float appliedTempo = DEFAULT_TEMPO;
+    float appliedPitch = DEFAULT_PITCH;
+    int band = -1;
+    int quality = 0; // 지금 걸린 품질 단계
+    int step = PARAM_RAMP_BLOCKS;
+};
+
+static ParamRamp gParamRamp;
+
+// ─────────────────────────────
+// StretchGovernor — CPU 부하에 따라 SoundTouch 품질 단계 조절
+//  - 스트레치 스레드(디코더 또는 늦은 스트레치 워커)가 putSamples 시간을 기록
+//  - 콜백은 CallbackTimer가 period 대비 실행 시간 최대치를 gCbLoadPeak에 남김
+//  - evaluate()는 paramRampStep 안에서만 (램프와 같은 스레드 → 상태 lock 불필요)
+//  - 단계 변경은 gStretchQuality에 올리고, 다음 paramRampStep이 gST에 적용
+//  - 변경 이력은 FFI로 조회 (이전/새 단계 + 당시 스트레치/콜백 부하, underrun)
+//    → late-stretch 워커에서도 불리므로 stdout 대신 이력 링에만 남김 (lock은 변경 시에만)
+// ─────────────────────────────
+class StretchGovernor
+{
+public:
+    struct Change
     {
-        gDecodeThread.join();
+        int64_t timeNs = 0;
+        int32_t from = 0;
+        int32_t to = 0;
+        int32_t stretchLoadPermille = 0;
+        int32_t callbackLoadPermille = 0;
+        bool underrun = false;
+    };
+
+    // 스트레치 1회: putSamples 소요 시간, 넣은 소스 프레임, 당시 tempo
+    void onStretch(int64_t elapsedNs, int frames, float tempo)
+    {
+        const double outNs = static_cast<double>(frames) * 1e9 / (gSampleRate * std::max(0.1f, tempo));
+        costNs_.fetch_add(elapsedNs, std::memory_order_relaxed);
+        audioNs_.fetch_add(static_cast<int64_t>(outNs), std::memory_order_relaxed);
     }
 
-    // FFmpeg 컨텍스트 정리
-    if (gSwr)
+    void evaluate()
+    {
+        const int64_t now = steadyNowNs();
+        if (windowStartNs_ == 0)
+        {
+            windowStartNs_ = now;
+            changedNs_ = now;
+            headroomSinceNs_ = now;
+            seenUnderruns_ = gUnderrunCount.load(std::memory_order_relaxed);
+            return;
+        }
+        if (now - windowStartNs_ < static_cast<int64_t>(GOV_WINDOW_MS) * 1000000)
+        {
+            return;
+        }
+        windowStartNs_ = now;
+
+        const int64_t cost = costNs_.exchange(0, std::memory_order_relaxed);
+        const int64_t audio = audioNs_.exchange(0, std::memory_order_relaxed);
+        const double stretchLoad = audio > 0 ? static_cast<double>(cost) / static_cast<double>(audio) : 0.0;
+        const double callbackLoad = gCbLoadPeak.exchange(0, std::memory_order_relaxed) / 1000.0;
+        const uint32_t underruns = gUnderrunCount.load(std::memory_order_relaxed);
+        const bool underrun = underruns != seenUnderruns_;
+        seenUnderruns_ = underruns;
+
+        const bool pressure = underrun || stretchLoad > GOV_DOWN_STRETCH_LOAD || callbackLoad > GOV_DOWN_CALLBACK_LOAD;
+        const bool headroom = !underrun && stretchLoad < GOV_UP_STRETCH_LOAD && callbackLoad < GOV_UP_CALLBACK_LOAD;
+        if (!headroom)
+        {
+            headroomSinceNs_ = now;
+        }
+        if (now - changedNs_ < static_cast<int64_t>(GOV_DWELL_MS) * 1000000)
+        {
+            return;
+        }
+
+        const int level = gStretchQuality.load();
+        int next = level;
+        if (pressure && level < GOV_MAX_LEVEL)
+        {
+            next = level + 1;
+        }
+        else if (level > 0 && now - headroomSinceNs_ >= static_cast<int64_t>(GOV_RECOVER_MS) * 1000000)
+        {
+            next = level - 1;
+        }
+        if (next == level)
+        {
+            return;
+        }
+
+        gStretchQuality.store(next);
+        changedNs_ = now;
+        headroomSinceNs_ = now;
+
+        Change c;
+        c.timeNs = now;
+        c.from = level;
+        c.to = next;
+        c.stretchLoadPermille = static_cast<int32_t>(stretchLoad * 1000.0);
+        c.callbackLoadPermille = static_cast<int32_t>(callbackLoad * 1000.0);
+        c.underrun = underrun;
+        {
+            std::lock_guard<std::mutex> lock(historyMu_);
+            history_[historyHead_] = c;
+            historyHead_ = (historyHead_ + 1) % GOV_HISTORY;
+            historyCount_ = std::min(historyCount_ + 1, GOV_HISTORY);
+        }
+    }
+
+    int copyHistory(int64_t *out, int maxEntries)
+    {
+        std::lock_guard<std::mutex> lock(historyMu_);
+        const size_t count = std::min(historyCount_, static_cast<size_t>(std::max(0, maxEntries)));
+        for (size_t i = 0; i < count; ++i)
+        {
+            const Change &c = history_[(historyHead_ + GOV_HISTORY - count + i) % GOV_HISTORY];
+            out[i * 6 + 0] = c.timeNs / 1000;
+            out[i * 6 + 1] = c.from;
+            out[i * 6 + 2] = c.to;
+            out[i * 6 + 3] = c.stretchLoadPermille;
+            out[i * 6 + 4] = c.callbackLoadPermille;
+            out[i * 6 + 5] = c.underrun ? 1 : 0;
+        }
+        return static_cast<int>(count);
+    }
+
+private:
+    std::atomic<int64_t> costNs_{0};
+    std::atomic<int64_t> audioNs_{0};
+
+    // evaluate() 스레드 소유
+    int64_t windowStartNs_ = 0;
+    int64_t changedNs_ = 0;
+    int64_t headroomSinceNs_ = 0;
+    uint32_t seenUnderruns_ = 0;
+
+    std::mutex historyMu_;
+    Change history_[GOV_HISTORY];
+    size_t historyHead_ = 0;
+    size_t historyCount_ = 0;
+};
+
+static StretchGovernor gGovernor;
+
+// 스트레치 스레드용: putSamples 한 번을 재서 거버너에 기록
+static void putSamplesTimed(const float *src, int frames)
+{
+    const int64_t t0 = steadyNowNs();
+    {
+        std::lock_guard<std::mutex> lock(gMutex);
+        gST.putSamples(src, static_cast<uint>(frames));
+    }
+    gGovernor.onStretch(steadyNowNs() - t0, frames, gParamRamp.appliedTempo);
+}
+
+// 처리 블록마다 1회 (디코더 스레드) — 새 목표값이 있으면 gST를 한 칸씩 옮긴다
+//  - 튜닝 구간(setSetting 5개)은 목표 tempo 기준으로 변경 1회에 한 번만
+//  - jump: SoundTouch를 비우고 새로 시작할 때 (seek / 렌더 루프 이탈)는 바로 목표값
+//  - late-stretch 워커에서도 불림 → printf 등 막힐 수 있는 호출 금지
+static void paramRampStep(bool jump)
+{
+    ParamRamp &r = gParamRamp;
+
+    // 품질 단계 변경 (거버너 판단) → 튜닝 구간을 새 단계로 다시 적용
+    gGovernor.evaluate();
+    const int quality = gStretchQuality.load();
+    if (quality != r.quality && r.band >= 0)
     {
-        swr_free(&gSwr);
-        gSwr = nullptr;
+        std::lock_guard<std::mutex> lock(gMutex);
+        applyStretchBand(gST, r.band, quality);
     }
-    if (gCodecCtx)
+    r.quality = quality;
+
+    float tempo = DEFAULT_TEMPO;
+    float pitch = DEFAULT_PITCH;
+    if (gParamBox.fetch(r.seenSeq, tempo, pitch))
     {
-        avcodec_free_context(&gCodecCtx);
-        gCodecCtx = nullptr;
+        r.fromTempo = r.appliedTempo;
+        r.fromPitch = r.appliedPitch;
+        r.toTempo = tempo > 0.0f ? tempo : DEFAULT_TEMPO;
+        r.toPitch = pitch;
+        r.step = 0;
     }
-    if (gFmtCtx)
+    if (r.step >= PARAM_RAMP_BLOCKS)
     {
-        avformat_close_input(&gFmtCtx);
-        gFmtCtx = nullptr;
+        return;
     }
 
-    gAudioStreamIndex = -1;
-    gDurationMs = 0.0;
-    gFileOpened.store(false);
+    r.step = jump ? PARAM_RAMP_BLOCKS : r.step + 1;
+    const bool done = r.step >= PARAM_RAMP_BLOCKS;
+    const float k = static_cast<float>(r.step) / static_cast<float>(PARAM_RAMP_BLOCKS);
+    const float t = done ? r.toTempo : r.fromTempo + (r.toTempo - r.fromTempo) * k;
+    const float semi = done ? r.toPitch : r.fromPitch + (r.toPitch - r.fromPitch) * k;
+    const int band = stretchBandOf(r.toTempo);
 
     {
         std::lock_guard<std::mutex> lock(gMutex);
-        gST.clear();
-        gST.flush();
-        std::fill(gLastBuffer.begin(), gLastBuffer.end(), 0.0f);
+        if (band != r.band)
+        {
+            applyStretchBand(gST, band, quality);
+        }
+        if (t != r.appliedTempo)
+        {
+            gST.setTempo(t);
+        }
+        if (semi != r.appliedPitch)
+        {
+            gST.setPitchSemiTones(semi);
+        }
     }
+    r.band = band;
+    r.appliedTempo = t;
+    r.appliedPitch = semi;
+}
 
-    gStable.clear();
-    gProcessedSamples.store(0);
-    gWarmupNeeded.store(false);
+// tempo/pitch 목표가 원속인지 (우회 허용 시)
+static bool stretchBypassWanted()
+{
+    return gBypassEnabled.load() && std::fabs(gParamBox.tempo() - 1.0f) < BYPASS_TEMPO_EPS &&
+           std::fabs(gParamBox.pitch()) < BYPASS_PITCH_EPS;
+}
 
-    logLine("FFmpeg", "file closed");
+// FFmpeg 초기화 (once)
+static void initFFmpegOnce()
+{
+    std::call_once(gFFmpegInitOnce, []()
+                   {
+        av_log_set_level(AV_LOG_ERROR);
+        avformat_network_init();
+        logLine("FFmpeg", "initialized"); });
 }
 
-// FFmpeg 파일 열기
-static bool openFileInternal(const char *path)
+// SoundTouch 초기화
+static void initSoundTouch()
 {
-    initFFmpegOnce();
-    closeFileInternal(); // 기존 파일 있으면 정리
+    std::lock_guard<std::mutex> lock(gMutex);
 
-    if (!path)
-    {
-        logLine("FFmpeg", "openFileInternal: null path");
-        return false;
-    }
+    gST.setSampleRate(gSampleRate);
+    gST.setChannels(CHANNELS);
+    gST.setSetting(SETTING_TRANSPOSER_ALGORITHM, ST_TRANSPOSER_ALGORITHM);
+    gST.reserveBuffers(static_cast<uint>(framesForMs(ST_RESERVE_MS)));
+
+    // tempo / pitch 기본값 세팅 + 파라미터 튜닝 (디코더 시작 전 → 램프 상태도 기본값으로)
+    gParamBox.setTempo(DEFAULT_TEMPO);
+    gParamBox.setPitch(DEFAULT_PITCH);
+    applySoundTouchParams_unsafe();
+    gParamRamp = ParamRamp{};
+    gParamRamp.band = stretchBandOf(DEFAULT_TEMPO);
+    gParamRamp.quality = gStretchQuality.load();
+
+    gVolume.store(DEFAULT_VOL);
+    setPlayheadFrames(0);
+    gLastSnapshot.resetUnsafe(); // 디바이스 시작 전
+
+    logLine("SoundTouch", "initialized");
+}
 
-    if (avformat_open_input(&gFmtCtx, path, nullptr, nullptr) < 0)
+// FFmpeg 입력 열기 (format + codec + swr → 엔진 레이트 stereo float)
+//  - 메인 디코더와 루프 구간 캐시 리더가 같은 변환 규칙을 공유
+//  - 실패 시 열었던 컨텍스트를 모두 정리하고 false
+static bool openAudioInput(
+    const char *path,
+    AVFormatContext *&fmt,
+    AVCodecContext *&codec,
+    SwrContext *&swr,
+    int &streamIndex)
+{
+    if (avformat_open_input(&fmt, path, nullptr, nullptr) < 0)
     {
         logLine("FFmpeg", "open_input failed");
         return false;
     }
-    if (avformat_find_stream_info(gFmtCtx, nullptr) < 0)
+    if (avformat_find_stream_info(fmt, nullptr) < 0)
     {
         logLine("FFmpeg", "find_stream_info failed");
-        avformat_close_input(&gFmtCtx);
-        gFmtCtx = nullptr;
+        avformat_close_input(&fmt);
+        fmt = nullptr;
         return false;
     }
 
-    int streamIndex = av_find_best_stream(gFmtCtx, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
+    streamIndex = av_find_best_stream(fmt, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
     if (streamIndex < 0)
     {
         logLine("FFmpeg", "no audio stream");
-        avformat_close_input(&gFmtCtx);
-        gFmtCtx = nullptr;
+        avformat_close_input(&fmt);
+        fmt = nullptr;
         return false;
     }
-    gAudioStreamIndex = streamIndex;
-    AVStream *st = gFmtCtx->streams[gAudioStreamIndex];
+    AVStream *st = fmt->streams[streamIndex];
 
     const AVCodec *dec = avcodec_find_decoder(st->codecpar->codec_id);
     if (!dec)
     {
         logLine("FFmpeg", "decoder not found");
-        avformat_close_input(&gFmtCtx);
-        gFmtCtx = nullptr;
+        avformat_close_input(&fmt);
+        fmt = nullptr;
         return false;
     }
 
-    gCodecCtx = avcodec_alloc_context3(dec);
-    if (!gCodecCtx)
+    codec = avcodec_alloc_context3(dec);
+    if (!codec)
     {
         logLine("FFmpeg", "alloc_context failed");
-        avformat_close_input(&gFmtCtx);
-        gFmtCtx = nullptr;
+        avformat_close_input(&fmt);
+        fmt = nullptr;
         return false;
     }
 
-    if (avcodec_parameters_to_context(gCodecCtx, st->codecpar) < 0)
+    if (avcodec_parameters_to_context(codec, st->codecpar) < 0)
     {
         logLine("FFmpeg", "parameters_to_context failed");
-        avcodec_free_context(&gCodecCtx);
-        avformat_close_input(&gFmtCtx);
-        gCodecCtx = nullptr;
-        gFmtCtx = nullptr;
+        avcodec_free_context(&codec);
+        avformat_close_input(&fmt);
+        codec = nullptr;
+        fmt = nullptr;
         return false;
     }
 
-    if (avcodec_open2(gCodecCtx, dec, nullptr) < 0)
+    if (avcodec_open2(codec, dec, nullptr) < 0)
     {
         logLine("FFmpeg", "avcodec_open2 failed");
-        avcodec_free_context(&gCodecCtx);
-        avformat_close_input(&gFmtCtx);
-        gCodecCtx = nullptr;
-        gFmtCtx = nullptr;
+        avcodec_free_context(&codec);
+        avformat_close_input(&fmt);
+        codec = nullptr;
+        fmt = nullptr;
         return false;
     }
 
-    // SwrContext 설정 (모든 입력 → 44100Hz / stereo / float)
-    int64_t in_ch_layout = gCodecCtx->channel_layout;
+    // SwrContext 설정 (모든 입력 → 엔진 레이트 / stereo / float)
+    //  - 소스 레이트 == 엔진 레이트면 리샘플링 없이 포맷/채널 배치만 바꿈
+    int64_t in_ch_layout = codec->channel_layout;
     if (in_ch_layout == 0)
     {
-        in_ch_layout = av_get_default_channel_layout(gCodecCtx->channels);
+        in_ch_layout = av_get_default_channel_layout(codec->channels);
     }
 
-    gSwr = swr_alloc_set_opts(
+    swr = swr_alloc_set_opts(
         nullptr,
         AV_CH_LAYOUT_STEREO,
         AV_SAMPLE_FMT_FLT,
-        SAMPLE_RATE,
+        gSampleRate,
         in_ch_layout,
-        gCodecCtx->sample_fmt,
-        gCodecCtx->sample_rate,
+        codec->sample_fmt,
+        codec->sample_rate,
         0,
         nullptr);
 
-    if (!gSwr || swr_init(gSwr) < 0)
+    if (!swr || swr_init(swr) < 0)
     {
         logLine("FFmpeg", "swr_init failed");
-        if (gSwr)
+        if (swr)
         {
-            swr_free(&gSwr);
-            gSwr = nullptr;
+            swr_free(&swr);
+            swr = nullptr;
         }
-        avcodec_free_context(&gCodecCtx);
-        avformat_close_input(&gFmtCtx);
-        gCodecCtx = nullptr;
-        gFmtCtx = nullptr;
+        avcodec_free_context(&codec);
+        avformat_close_input(&fmt);
+        codec = nullptr;
+        fmt = nullptr;
         return false;
     }
 
-    // duration 계산
-    if (st->duration > 0 && st->time_base.num > 0)
-    {
-        gDurationMs = st->duration * av_q2d(st->time_base) * 1000.0;
-    }
-    else if (gFmtCtx->duration > 0)
+    return true;
+}
+
+// FFmpeg 입력 닫기
+static void closeAudioInput(AVFormatContext *&fmt, AVCodecContext *&codec, SwrContext *&swr)
+{
+    if (swr)
     {
-        gDurationMs = gFmtCtx->duration * 1000.0 / AV_TIME_BASE;
+        swr_free(&swr);
+        swr = nullptr;
     }
-    else
+    if (codec)
     {
-        gDurationMs = 0.0;
+        avcodec_free_context(&codec);
+        codec = nullptr;
     }
-
-    gProcessedSamples.store(0);
+    if (fmt)
     {
-        std::lock_guard<std::mutex> lock(gMutex);
-        gST.clear();
-        gST.flush();
-        std::fill(gLastBuffer.begin(), gLastBuffer.end(), 0.0f);
-        // tempo/pitch는 유지, 파라미터는 그대로 (seek/open 후에도 일관성 유지)
+        avformat_close_input(&fmt);
+        fmt = nullptr;
     }
-
-    gStable.clear();
-    gFileOpened.store(true);
-    gWarmupNeeded.store(true); // 새 파일 → MAOutputGuard 워밍업 필요
-
-    logLine("FFmpeg", "file opened");
-    return true;
 }
 
-// 디코더 쓰레드
-//  - FFmpeg → Swr → SoundTouch.putSamples()
-//  - SoundTouch.receiveSamples() → StableBuffer.push()
-//  - gPaused == true면 디코딩 잠시 쉼 (출력은 콜백에서 무음 처리)
-//  - StableBuffer가 충분히 차 있으면 back-pressure로 디코딩 속도 제어
-static void decodeThreadFunc()
+// ─────────────────────────────
+// 전체 파일 PCM 캐시
+//  - 파일 형식: PcmCacheHeader + 엔진 레이트 stereo float (interleaved)
+//  - 헤더 레이트가 현재 엔진 레이트와 다르면 무효 → 다시 디코드
+//  - 키(파일 이름)는 Dart가 정함 (미디어 SHA-1) → 앱 재시작 후에도 그대로 재사용
+//  - 캐시가 없으면 보조 입력으로 백그라운드 디코드 (.part에 쓰고 끝나면 rename)
+//  - 준비되면 디코더 스레드가 FFmpeg 스트리밍에서 메모리 공급으로 갈아탄다
+// ─────────────────────────────
+struct PcmCacheHeader
 {
-    AVPacket *pkt = av_packet_alloc();
-    AVFrame *frame = av_frame_alloc();
-
-    const int MAX_DST_SAMPLES = 4096;
-    std::vector<float> convBuffer(MAX_DST_SAMPLES * CHANNELS);
+    char magic[8];
+    uint32_t version;
+    uint32_t sampleRate;
+    uint32_t channels;
+    uint32_t reserved;
+    int64_t frames;
+};
 
-    // SoundTouch에서 StableBuffer로 옮길 임시 버퍼
-    std::vector<float> stDrainBuffer(ST_DRAIN_CHUNK_FRAMES * CHANNELS);
+static PcmCacheHeader makePcmCacheHeader(int64_t frames)
+{
+    PcmCacheHeader h{};
+    std::memcpy(h.magic, "JHPCMF32", sizeof(h.magic));
+    h.version = PCM_CACHE_VERSION;
+    h.sampleRate = gSampleRate;
+    h.channels = CHANNELS;
+    h.frames = frames;
+    return h;
+}
 
-    while (gDecodeRunning.load())
+// mmap된 캐시 파일 (읽기 전용, 불변 → 스레드 간 공유)
+class PcmStore
+{
+public:
+    ~PcmStore()
     {
-        // 재생이 일시정지거나 파일이 없으면 잠시 쉼
-        if (gPaused.load() || !gFileOpened.load())
+        if (base_)
         {
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
-            continue;
+            munmap(base_, bytes_);
         }
+    }
 
-        if (!gFmtCtx || !gCodecCtx || !gSwr || gAudioStreamIndex < 0)
+    // 헤더/크기가 맞지 않으면 nullptr (버전 변경·쓰다 만 파일)
+    static std::shared_ptr<const PcmStore> open(const std::string &file)
+    {
+        const int fd = ::open(file.c_str(), O_RDONLY);
+        if (fd < 0)
         {
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
-            continue;
+            return nullptr;
         }
 
-        // StableBuffer가 너무 많이 차 있으면 디코딩 속도 줄이기
-        if (gStable.size() > STABLE_HIGH_WATERMARK_FRAMES)
+        struct stat sb;
+        if (fstat(fd, &sb) != 0 || sb.st_size < static_cast<off_t>(sizeof(PcmCacheHeader)))
         {
-            std::this_thread::sleep_for(std::chrono::milliseconds(5));
-            continue;
+            ::close(fd);
+            return nullptr;
         }
 
-        int ret = av_read_frame(gFmtCtx, pkt);
-        if (ret < 0)
+        const size_t bytes = static_cast<size_t>(sb.st_size);
+        void *base = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (base == MAP_FAILED)
         {
-            // EOF 등: Loop OFF 가정, 잠시 쉼
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
-            continue;
+            return nullptr;
         }
 
-        if (pkt->stream_index != gAudioStreamIndex)
+        std::shared_ptr<PcmStore> s(new PcmStore());
+        s->base_ = base;
+        s->bytes_ = bytes;
+
+        const PcmCacheHeader want = makePcmCacheHeader(0);
+        PcmCacheHeader h;
+        std::memcpy(&h, base, sizeof(h));
+        const size_t frameBytes = CHANNELS * sizeof(float);
+        if (std::memcmp(h.magic, want.magic, sizeof(h.magic)) != 0 ||
+            h.version != want.version || h.sampleRate != want.sampleRate || h.channels != want.channels ||
+            h.frames <= 0 || bytes != sizeof(PcmCacheHeader) + static_cast<size_t>(h.frames) * frameBytes)
         {
-            av_packet_unref(pkt);
-            continue;
+            return nullptr;
         }
 
-        ret = avcodec_send_packet(gCodecCtx, pkt);
-        av_packet_unref(pkt);
-        if (ret < 0)
+        s->frames_ = h.frames;
+        s->data_ = reinterpret_cast<const float *>(static_cast<const char *>(base) + sizeof(PcmCacheHeader));
+        madvise(base, bytes, MADV_WILLNEED);
+        return s;
+    }
+
+    int64_t frames() const
+    {
+        return frames_;
+    }
+
+    const float *at(int64_t f) const
+    {
+        return data_ + f * CHANNELS;
+    }
+
+    // [start, start+frames) 복사, 범위 밖은 무음
+    void read(int64_t start, int frames, float *dst) const
+    {
+        std::memset(dst, 0, static_cast<size_t>(frames) * CHANNELS * sizeof(float));
+        const int64_t from = std::max<int64_t>(start, 0);
+        const int64_t to = std::min<int64_t>(start + frames, frames_);
+        if (to > from)
         {
-            continue;
+            std::memcpy(dst + (from - start) * CHANNELS, at(from),
+                        static_cast<size_t>(to - from) * CHANNELS * sizeof(float));
         }
+    }
 
-        while (ret >= 0)
-        {
-            ret = avcodec_receive_frame(gCodecCtx, frame);
-            if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
-            {
-                break;
-            }
-            if (ret < 0)
-            {
-                break;
-            }
+private:
+    PcmStore() = default;
 
-            uint8_t *outData[1] = {
-                reinterpret_cast<uint8_t *>(convBuffer.data())};
+    void *base_ = nullptr;
+    size_t bytes_ = 0;
+    int64_t frames_ = 0;
+    const float *data_ = nullptr;
+};
 
-            int outSamples = swr_convert(
-                gSwr,
-                outData,
-                MAX_DST_SAMPLES,
-                const_cast<const uint8_t **>(frame->data),
-                frame->nb_samples);
+// 파일별 캐시 관리 (open 시 start, close 시 stop)
+class PcmCache
+{
+public:
+    ~PcmCache()
+    {
+        stop();
+    }
 
-            if (outSamples > 0)
-            {
-                // 1) 변환한 샘플을 SoundTouch 입력 큐에 넣기
-                {
-                    std::lock_guard<std::mutex> lock(gMutex);
-                    gST.putSamples(convBuffer.data(), outSamples);
-                }
+    void start(const std::string &mediaPath, const std::string &cachePath, double durationMs)
+    {
+        stop();
+        if (cachePath.empty())
+        {
+            return;
+        }
 
-                // 2) SoundTouch에서 변조된 샘플을 StableBuffer로 이동
-                //    - StableBuffer가 가득 차 있으면
-                //      소비될 때까지 짧게 sleep 하면서 재시도
-                bool drainMore = true;
-                while (drainMore && gDecodeRunning.load() && !gPaused.load())
-                {
-                    int received = 0;
-                    {
-                        std::lock_guard<std::mutex> lock(gMutex);
-                        received = gST.receiveSamples(
-                            stDrainBuffer.data(),
-                            ST_DRAIN_CHUNK_FRAMES);
-                    }
-
-                    if (received <= 0)
-                    {
-                        // 현재 더 이상 꺼낼 샘플이 없음
-                        drainMore = false;
-                        break;
-                    }
-
-                    int remaining = received;
-                    int offsetFrames = 0;
-
-                    while (remaining > 0 && gDecodeRunning.load() && !gPaused.load())
-                    {
-                        int written = gStable.push(
-                            stDrainBuffer.data() + offsetFrames * CHANNELS,
-                            remaining);
-
-                        if (written <= 0)
-                        {
-                            // StableBuffer가 가득 찼으므로 소비될 때까지 잠시 대기
-                            std::this_thread::sleep_for(std::chrono::milliseconds(5));
-                            continue;
-                        }
-
-                        remaining -= written;
-                        offsetFrames += written;
-                    }
-
-                    // paused로 전환되거나 decodeRunning이 false가 되면
-                    // 남은 샘플은 버려도 괜찮다 (seek/정지/종료 처리 중)
-                }
-            }
+        if (std::shared_ptr<const PcmStore> s = PcmStore::open(cachePath))
+        {
+            publish(std::move(s), generation_.load());
+            logLine("PcmCache", "hit → serving from memory");
+            return;
+        }
+
+        const double frames = durationMs / 1000.0 * gSampleRate;
+        if (durationMs <= 0.0 || frames > static_cast<double>(framesForMs(PCM_CACHE_MAX_MS)))
+        {
+            logLine("PcmCache", "long/unknown duration → streaming decode");
+            return;
         }
+
+        const uint64_t gen = generation_.load();
+        builder_ = std::thread([this, mediaPath, cachePath, gen]()
+                               { build(mediaPath, cachePath, gen); });
     }
 
-    av_frame_free(&frame);
-    av_packet_free(&pkt);
-}
+    // 빌드 취소 + 캐시 해제 (디코더 스레드가 멈춘 뒤 호출)
+    void stop()
+    {
+        generation_.fetch_add(1);
+        if (builder_.joinable())
+        {
+            builder_.join();
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        store_.reset();
+        ready_.store(false);
+    }
 
-// miniaudio 콜백
-//  - MAOutputGuard: 워밍업 필요 시 StableBuffer가 충분히 찰 때까지 무음 출력
-//  - StableBuffer.pop() → 실제 출력
-//  - underflow 시 SoT 증가 없이 무음 출력
-static void data_callback(ma_device * /*pDevice*/, void *pOutput, const void * /*pInput*/, ma_uint32 frameCount)
-{
-    float *out = static_cast<float *>(pOutput);
+    // 준비된 캐시 (없으면 nullptr) — 디코더 루프에서 매번 불러도 싸게
+    std::shared_ptr<const PcmStore> ready()
+    {
+        if (!ready_.load(std::memory_order_acquire))
+        {
+            return nullptr;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        return store_;
+    }
 
-    // 정지 상태 또는 파일 미열림 상태에서는 항상 무음 + SoT 증가 없음
-    if (gPaused.load() || !gFileOpened.load())
+private:
+    void publish(std::shared_ptr<const PcmStore> s, uint64_t gen)
     {
-        std::memset(out, 0, frameCount * CHANNELS * sizeof(float));
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (generation_.load() != gen)
         {
-            std::lock_guard<std::mutex> lock(gMutex);
-            std::fill(gLastBuffer.begin(), gLastBuffer.end(), 0.0f);
+            return;
         }
-        return;
+        store_ = std::move(s);
+        ready_.store(true, std::memory_order_release);
     }
 
-    // MAOutputGuard: 새 파일/seek 직후 워밍업
-    if (gWarmupNeeded.load())
+    void build(const std::string &mediaPath, const std::string &cachePath, uint64_t gen)
+    {
+        AVFormatContext *fmt = nullptr;
+        AVCodecContext *codec = nullptr;
+        SwrContext *swr = nullptr;
+        int stream = -1;
+        if (!openAudioInput(mediaPath.c_str(), fmt, codec, swr, stream))
+        {
+            logLine("PcmCache", "build: open failed");
+            return;
+        }
+
+        const std::string partPath = cachePath + ".part";
+        std::FILE *fp = std::fopen(partPath.c_str(), "wb");
+        if (!fp)
+        {
+            logLine("PcmCache", "build: cannot create cache file");
+            closeAudioInput(fmt, codec, swr);
+            return;
+        }
+
+        const auto t0 = std::chrono::steady_clock::now();
+        PcmCacheHeader header = makePcmCacheHeader(0);
+        bool ok = std::fwrite(&header, sizeof(header), 1, fp) == 1;
+
+        AVPacket *pkt = av_packet_alloc();
+        AVFrame *frame = av_frame_alloc();
+        const int maxOut = 4096;
+        std::vector<float> conv(maxOut * CHANNELS);
+        uint8_t *outData[1] = {reinterpret_cast<uint8_t *>(conv.data())};
+        int64_t frames = 0;
+
+        auto emit = [&](int n)
+        {
+            if (n <= 0 || !ok)
+            {
+                return;
+            }
+            ok = std::fwrite(conv.data(), CHANNELS * sizeof(float), static_cast<size_t>(n), fp) ==
+                 static_cast<size_t>(n);
+            frames += n;
+            if (frames > framesForMs(PCM_CACHE_MAX_MS))
+            {
+                ok = false;
+            }
+        };
+        auto drainDecoder = [&]()
+        {
+            while (avcodec_receive_frame(codec, frame) >= 0)
+            {
+                emit(swr_convert(swr, outData, maxOut,
+                                 const_cast<const uint8_t **>(frame->data), frame->nb_samples));
+            }
+        };
+
+        while (ok && generation_.load() == gen && av_read_frame(fmt, pkt) >= 0)
+        {
+            if (pkt->stream_index != stream)
+            {
+                av_packet_unref(pkt);
+                continue;
+            }
+            const int ret = avcodec_send_packet(codec, pkt);
+            av_packet_unref(pkt);
+            if (ret >= 0)
+            {
+                drainDecoder();
+            }
+        }
+
+        // 디코더 / 리샘플러에 남은 꼬리
+        avcodec_send_packet(codec, nullptr);
+        drainDecoder();
+        int tail = 0;
+        while (ok && (tail = swr_convert(swr, outData, maxOut, nullptr, 0)) > 0)
+        {
+            emit(tail);
+        }
+
+        av_frame_free(&frame);
+        av_packet_free(&pkt);
+        closeAudioInput(fmt, codec, swr);
+
+        ok = ok && generation_.load() == gen && frames > 0;
+        if (ok)
+        {
+            header.frames = frames;
+            ok = std::fseek(fp, 0, SEEK_SET) == 0 &&
+                 std::fwrite(&header, sizeof(header), 1, fp) == 1 &&
+                 std::fflush(fp) == 0;
+        }
+        ok = (std::fclose(fp) == 0) && ok;
+
+        if (!ok || std::rename(partPath.c_str(), cachePath.c_str()) != 0)
+        {
+            std::remove(partPath.c_str());
+            logLine("PcmCache", "build cancelled/failed → streaming decode");
+            return;
+        }
+
+        std::shared_ptr<const PcmStore> s = PcmStore::open(cachePath);
+        if (!s)
+        {
+            return;
+        }
+        publish(std::move(s), gen);
+
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        std::printf("[PcmCache] built %lld frames in %.0fms\n", static_cast<long long>(frames), ms);
+    }
+
+    std::thread builder_;
+    std::mutex mutex_;
+    std::shared_ptr<const PcmStore> store_;
+    std::atomic<bool> ready_{false};
+    std::atomic<uint64_t> generation_{0};
+};
+
+static PcmCache gPcmCache;
+
+// FFmpeg 파일 닫기
+static void closeFileInternal()
+{
+    // 디코더 스레드 중지 (잠들어 있으면 깨워서 종료시킴)
+    gDecodeRunning.store(false);
+    gDecodeWaker.notify();
+    if (gDecodeThread.joinable())
+    {
+        gDecodeThread.join();
+    }
+
+    // FFmpeg 컨텍스트 / PCM 캐시 정리
+    closeAudioInput(gFmtCtx, gCodecCtx, gSwr);
+    gPcmCache.stop();
+
+    gAudioStreamIndex = -1;
+    gDurationMs = 0.0;
+    gFileOpened.store(false);
+    gScrubMode.store(SCRUB_OFF);
+    gScrubActive.store(false);
+    gFilePath.clear();
+    gStreamEnd.store(STREAM_PLAYING);
+    gEndOfStreamEvent.store(false);
+
+    // 루프는 파일 단위: 다음 파일의 디코더가 이전 구간을 이어받지 않도록 해제 명령을 남김
+    gLoopBox.post(LoopCommand{});
+    gLoopRemaining.store(0);
+
+    {
+        std::lock_guard<std::mutex> lock(gMutex);
+        gST.clear();
+        gST.flush();
+    }
+
+    gLastSnapshot.requestClear();
+    gStable.clear();
+    setPlayheadFrames(0);
+    gWarmupNeeded.store(false);
+
+    logLine("FFmpeg", "file closed");
+}
+
+// FFmpeg 파일 열기
+//  - pcmCachePath: 전체 PCM 캐시 파일 경로 (nullptr/빈 문자열 = 캐시 안 함)
+static bool openFileInternal(const char *path, const char *pcmCachePath)
+{
+    initFFmpegOnce();
+    closeFileInternal(); // 기존 파일 있으면 정리
+
+    if (!path)
+    {
+        logLine("FFmpeg", "openFileInternal: null path");
+        return false;
+    }
+
+    if (!openAudioInput(path, gFmtCtx, gCodecCtx, gSwr, gAudioStreamIndex))
+    {
+        return false;
+    }
+    AVStream *st = gFmtCtx->streams[gAudioStreamIndex];
+    gFilePath = path;
+
+    // duration 계산
+    if (st->duration > 0 && st->time_base.num > 0)
+    {
+        gDurationMs = st->duration * av_q2d(st->time_base) * 1000.0;
+    }
+    else if (gFmtCtx->duration > 0)
+    {
+        gDurationMs = gFmtCtx->duration * 1000.0 / AV_TIME_BASE;
+    }
+    else
+    {
+        gDurationMs = 0.0;
+    }
+
+    setPlayheadFrames(0);
+    {
+        std::lock_guard<std::mutex> lock(gMutex);
+        gST.clear();
+        gST.flush();
+        // tempo/pitch는 유지, 파라미터는 그대로 (seek/open 후에도 일관성 유지)
+    }
+    gLastSnapshot.requestClear();
+
+    gStable.clear();
+    gSeekServedSeq.store(gSeekBox.latest()); // 이전 파일의 seek 명령은 무효
+    gSeekStartNs.store(0);
+    gFileOpened.store(true);
+    // 부하가 커서 목표량이 늘어 있으면 워밍업도 그 절반까지 늘림
+    gWarmupFrames.store(std::max(static_cast<int>(framesForMs(gEngineActual.warmupMs)), gFillTarget.load() / 2));
+    gWarmupNeeded.store(true); // 새 파일 → MAOutputGuard 워밍업 필요
+
+    gPcmCache.start(path, pcmCachePath ? pcmCachePath : "", gDurationMs);
+
+    logLine("FFmpeg", "file opened");
+    return true;
+}
+
+// PcmRangeReader — 소스 구간 [start, start+frames)를 엔진 레이트 stereo float로 디코드
+//  - FFmpeg 컨텍스트는 빌려 씀 (스크럽: 메인 디코더 것, 루프 캐시: 보조 입력)
+//  - 직전 읽기의 끝에서 이어지면 seek 없이 계속 디코드 (순방향 스크럽/청크 연속 읽기)
+//  - 그 외에는 av_seek_frame 후 pts 기준으로 잘라 맞춤 (역방향/점프)
+//  - EOF 이후 구간은 0으로 채움
+class PcmRangeReader
+{
+public:
+    void bind(AVFormatContext *fmt, AVCodecContext *codec, SwrContext *swr, int stream)
+    {
+        fmt_ = fmt;
+        codec_ = codec;
+        swr_ = swr;
+        stream_ = stream;
+        invalidate();
+    }
+
+    // 전체 PCM 캐시가 있으면 디코드 없이 복사로 읽음
+    void useStore(std::shared_ptr<const PcmStore> store)
+    {
+        store_ = std::move(store);
+        invalidate();
+    }
+
+    void invalidate()
+    {
+        nextFrame = -1;
+        carry.clear();
+    }
+
+    void read(int64_t start, int frames, float *dst,
+              AVPacket *pkt, AVFrame *frame, std::vector<float> &conv)
+    {
+        if (store_)
+        {
+            store_->read(start, frames, dst);
+            return;
+        }
+
+        std::memset(dst, 0, static_cast<size_t>(frames) * CHANNELS * sizeof(float));
+        const int64_t end = start + frames;
+        int64_t filled = start; // 여기까지 채워짐
+        std::vector<float> nextCarry;
+
+        // [srcStart, srcStart+n) 중 요청 구간에 걸친 부분만 복사, 넘친 뒤쪽은 carry에 이어 붙임
+        auto take = [&](const float *src, int64_t srcStart, int n)
+        {
+            const int64_t from = std::max(srcStart, filled);
+            const int64_t to = std::min(srcStart + n, end);
+            if (to > from)
+            {
+                std::memcpy(dst + (from - start) * CHANNELS,
+                            src + (from - srcStart) * CHANNELS,
+                            static_cast<size_t>(to - from) * CHANNELS * sizeof(float));
+                filled = to;
+            }
+            if (srcStart + n > end)
+            {
+                const int64_t off = std::max<int64_t>(0, end - srcStart);
+                nextCarry.insert(nextCarry.end(), src + off * CHANNELS, src + static_cast<int64_t>(n) * CHANNELS);
+            }
+        };
+
+        int64_t pos = -1;
+        if (start == nextFrame)
+        {
+            if (!carry.empty())
+            {
+                take(carry.data(), start, static_cast<int>(carry.size() / CHANNELS));
+            }
+            pos = nextFrame + static_cast<int64_t>(carry.size() / CHANNELS);
+        }
+        else
+        {
+            AVStream *st = fmt_->streams[stream_];
+            const double startSec = static_cast<double>(start) / gSampleRate;
+            const int64_t ts = static_cast<int64_t>(startSec / av_q2d(st->time_base));
+            if (av_seek_frame(fmt_, stream_, ts, AVSEEK_FLAG_BACKWARD) < 0)
+            {
+                logLine("FFmpeg", "range reader: av_seek_frame failed");
+            }
+            avcodec_flush_buffers(codec_);
+            swr_convert(swr_, nullptr, 0, nullptr, 0);
+        }
+
+        bool eof = false;
+        while (filled < end && nextCarry.empty() && !eof)
+        {
+            if (av_read_frame(fmt_, pkt) < 0)
+            {
+                eof = true;
+                break;
+            }
+            if (pkt->stream_index != stream_)
+            {
+                av_packet_unref(pkt);
+                continue;
+            }
+            int ret = avcodec_send_packet(codec_, pkt);
+            av_packet_unref(pkt);
+
+            while (ret >= 0)
+            {
+                ret = avcodec_receive_frame(codec_, frame);
+                if (ret < 0)
+                {
+                    break;
+                }
+                if (pos < 0)
+                {
+                    const int64_t pts = frame->best_effort_timestamp;
+                    const double tb = av_q2d(fmt_->streams[stream_]->time_base);
+                    pos = pts != AV_NOPTS_VALUE
+                              ? static_cast<int64_t>(std::llround(pts * tb * gSampleRate))
+                              : start;
+                }
+
+                uint8_t *outData[1] = {reinterpret_cast<uint8_t *>(conv.data())};
+                const int n = swr_convert(swr_, outData, static_cast<int>(conv.size() / CHANNELS),
+                                          const_cast<const uint8_t **>(frame->data), frame->nb_samples);
+                if (n <= 0)
+                {
+                    continue;
+                }
+                take(conv.data(), pos, n);
+                pos += n;
+            }
+        }
+
+        if (eof)
+        {
+            invalidate();
+            return;
+        }
+        carry.swap(nextCarry);
+        nextFrame = end;
+    }
+
+private:
+    AVFormatContext *fmt_ = nullptr;
+    AVCodecContext *codec_ = nullptr;
+    SwrContext *swr_ = nullptr;
+    int stream_ = -1;
+    std::shared_ptr<const PcmStore> store_;
+
+    int64_t nextFrame = -1;   // 이어서 디코드하면 나올 소스 프레임 (-1 = 모름 → seek 필요)
+    std::vector<float> carry; // 직전 읽기에서 남은 샘플 (nextFrame부터 시작)
+};
+
+// equal-power 크로스페이드 한 프레임 (t: 0 → 1 = from → to)
+static inline void equalPowerMix(const float *from, const float *to, float t, float *dst)
+{
+    const float gOut = std::cos(t * static_cast<float>(M_PI) * 0.5f);
+    const float gIn = std::sin(t * static_cast<float>(M_PI) * 0.5f);
+    for (int ch = 0; ch < CHANNELS; ++ch)
+    {
+        dst[ch] = from[ch] * gOut + to[ch] * gIn;
+    }
+}
+
+// 루프 구간 소스 PCM [a - xfade, b) — 만든 뒤로는 불변 (디코더 ↔ 렌더 워커 공유)
+struct LoopSource
+{
+    int64_t a = 0;
+    int64_t b = 0;
+    int64_t xfade = 0;
+    std::vector<float> pcm;
+
+    int64_t start() const
+    {
+        return a - xfade;
+    }
+
+    const float *at(int64_t f) const
+    {
+        return pcm.data() + (f - start()) * CHANNELS;
+    }
+
+    // 반복 재생되는 소스의 j번째 프레임 (j = A 기준 오프셋, 음수/한 바퀴 이상도 주기로 접음)
+    //  - B-xfade ~ B는 A 앞쪽과 섞은 wrap 이음새
+    void periodicFrame(int64_t j, float *dst) const
+    {
+        const int64_t n = b - a;
+        const int64_t f = a + ((j % n) + n) % n;
+        if (f < b - xfade)
+        {
+            std::memcpy(dst, at(f), CHANNELS * sizeof(float));
+            return;
+        }
+        const int64_t k = f - (b - xfade);
+        const float t = (static_cast<float>(k) + 0.5f) / static_cast<float>(xfade);
+        equalPowerMix(at(f), at(a - xfade + k), t, dst);
+    }
+};
+
+// 한 바퀴 렌더 결과 (출력 프레임 기준, 끝 → 처음이 끊김 없이 이어지는 주기 신호)
+struct RenderedLoop
+{
+    int64_t a = 0;
+    int64_t b = 0;
+    float tempo = 1.0f;
+    float pitch = 0.0f;
+    int64_t frames = 0;
+    int64_t tailFade = 0; // 끝 부분 wrap 크로스페이드 길이 (출력 프레임)
+    std::vector<float> pcm;
+
+    static bool sameParam(float x, float y)
+    {
+        return std::fabs(x - y) < 1e-4f;
+    }
+
+    bool matches(int64_t na, int64_t nb, float t, float p) const
+    {
+        return a == na && b == nb && sameParam(tempo, t) && sameParam(pitch, p);
+    }
+
+    const float *at(int64_t i) const
+    {
+        return pcm.data() + i * CHANNELS;
+    }
+
+    // 소스 위치 ↔ 렌더 위치 (한 바퀴 안에서 선형 대응)
+    int64_t srcOf(int64_t i) const
+    {
+        return a + static_cast<int64_t>(static_cast<double>(i) * static_cast<double>(b - a) / static_cast<double>(frames));
+    }
+};
+
+// A/B 루프 상태 (디코더 스레드 로컬)
+//  - src: [a - xfade, b) 소스 PCM (a - xfade ~ a는 크로스페이드의 fade-in 재료)
+//  - replay: 라이브 디코드가 B-xfade에 닿으면 캐시에서 공급 시작
+//    → 그 사이 디코드돼 있던 라이브 샘플은 held에 보관 (마지막 바퀴 후 그대로 이어 붙임)
+//  - FFmpeg 입력은 replay 동안 B 근처에 멈춰 있으므로 루프를 빠져나갈 때 seek가 필요 없다
+//  - rendered: 현재 키의 렌더 캐시로 반복 중 (rpos = 렌더 위치), 마지막 바퀴/키 변경 시 SoundTouch로 복귀
+struct LoopState
+{
+    bool enabled = false;
+    int remaining = 0; // -1 = 무한, N = B 도달 N번 남음
+    int64_t a = 0;
+    int64_t b = 0;
+    int64_t xfade = 0;
+
+    std::shared_ptr<const LoopSource> src;
+
+    std::shared_ptr<const RenderedLoop> rendered;
+    int64_t rpos = 0;
+    float requestedTempo = -1.0f; // 마지막으로 렌더를 요청한 키
+    float requestedPitch = 0.0f;
+
+    bool replay = false;
+    bool passWraps = true; // 이번 바퀴 끝에서 A로 돌아가는지 (페이드 진입 전에 확정)
+    int64_t pos = 0;       // replay 공급 위치 (소스 프레임)
+
+    std::vector<float> held;
+    int64_t heldStart = 0;
+
+    bool hasCache() const
+    {
+        return src != nullptr;
+    }
+
+    bool sameRegion(int64_t na, int64_t nb) const
+    {
+        return b > a && na == a && nb == b;
+    }
+
+    int64_t fadeStart() const
+    {
+        return b - xfade;
+    }
+
+    // 이번 바퀴 끝에서 wrap할지 (마지막 바퀴면 B 이후로 계속 재생)
+    bool wrapsNow() const
+    {
+        return enabled && remaining != 1;
+    }
+};
+
+// 디코더 스레드 로컬 상태
+//  - srcFrame: 다음에 변환될 샘플의 소스 위치 (엔진 레이트 기준 프레임)
+//  - seek 직후에는 첫 프레임의 pts로 srcFrame을 확정하고
+//    dropSrcUntil 이전의 소스 샘플은 버린다 (프레임 단위 정확한 seek)
+//  - dropOutFrames: pre-roll로 SoundTouch에 먼저 넣은 구간에 해당하는 출력 (버림)
+//  - fadeFrom: 출력 경로 전환 시 이전 경로의 이어지는 출력 → 다음에 링으로 나갈 프레임과 크로스페이드
+//  - pcm: 전체 PCM 캐시로 갈아탔으면 FFmpeg 대신 여기서 srcFrame부터 공급 (seek = 위치 대입)
+//  - markedIoRatio/markedEpoch: 링에 마지막으로 알린 SoundTouch 출력/입력 비율 (tempo 변경·seek 시 새 마커)
+//  - bypass: tempo 1 / pitch 0이라 SoundTouch 없이 소스를 바로 링으로 (bypassTail = 해제 시 pre-roll 재료)
+struct DecodeCursor
+{
+    std::shared_ptr<const PcmStore> pcm;
+    int64_t srcFrame = 0;
+    bool srcFrameKnown = true;
+    int64_t dropSrcUntil = 0;
+    int64_t dropOutFrames = 0;
+    std::vector<float> fadeFrom;
+    int64_t fadePos = 0;
+    uint64_t seenSeekSeq = 0;
+    uint64_t seenLoopSeq = 0;
+    bool eosDrained = false; // EOF 꼬리까지 다 공급함 → seek 전까지 잠듦
+    double markedIoRatio = 0.0;
+    uint32_t markedEpoch = UINT32_MAX;
+    bool late = false; // 늦은 스트레치 모드: SoundTouch 대신 소스 링으로 공급
+    bool bypass = false;
+    std::vector<float> bypassTail; // 최근 소스 (원형)
+    int64_t bypassTailFrames = 0;  // 누적 기록 프레임
+    LoopState loop;
+};
+
+// 메인 FFmpeg 입력을 startFrame 근처 keyframe으로 되감고 디코더 상태를 비움
+//  - SoundTouch / StableBuffer는 건드리지 않는다 (호출자가 결정)
+//  - 첫 디코드 프레임의 pts로 srcFrame을 확정하고 startFrame 이전 샘플은 버림
+static void rewindInput(int64_t startFrame, DecodeCursor &cur)
+{
+    if (cur.pcm)
+    {
+        cur.srcFrame = startFrame;
+        cur.srcFrameKnown = true;
+        cur.dropSrcUntil = startFrame;
+        return;
+    }
+
+    AVStream *st = gFmtCtx->streams[gAudioStreamIndex];
+    const double startSec = static_cast<double>(startFrame) / gSampleRate;
+    const int64_t ts = static_cast<int64_t>(startSec / av_q2d(st->time_base));
+
+    if (av_seek_frame(gFmtCtx, gAudioStreamIndex, ts, AVSEEK_FLAG_BACKWARD) < 0)
+    {
+        logLine("FFmpeg", "av_seek_frame failed");
+    }
+
+    avcodec_flush_buffers(gCodecCtx);
+    if (gSwr)
+    {
+        swr_convert(gSwr, nullptr, 0, nullptr, 0);
+    }
+
+    cur.srcFrame = startFrame;
+    cur.srcFrameKnown = false; // 첫 디코드 프레임의 pts로 확정
+    cur.dropSrcUntil = startFrame;
+}
+
+// 디코더 스레드에서 seek 실행
+//  - 스레드 재시작 없이 FFmpeg/Swr/SoundTouch/StableBuffer를 한 번에 정합
+//  - 타겟보다 pre-roll만큼 앞에서부터 디코드해 SoundTouch를 미리 채우고
+//    그 구간의 출력은 버린다 → 타겟 위치의 첫 프레임이 바로 나온다
+static void executeSeek(double ms, DecodeCursor &cur)
+{
+    const double targetMs = std::max(0.0, ms);
+    const int64_t targetFrame = static_cast<int64_t>(std::llround(targetMs / 1000.0 * gSampleRate));
+
+    // 늦은 스트레치 워커가 step 중이면 끝날 때까지 기다렸다가 파이프라인 전체를 비운다
+    std::lock_guard<std::mutex> hold(gStretchStepMutex);
+
+    // SoundTouch를 비우고 새로 시작 → 진행 중인 램프는 바로 목표값으로
+    paramRampStep(true);
+
+    // 우회 중이고 계속 원속이면 SoundTouch를 채울 필요가 없다 (pre-roll 없음)
+    if (cur.bypass && (cur.late || !stretchBypassWanted()))
+    {
+        cur.bypass = false;
+        gStretchBypassed.store(false);
+        logLine("ST", "bypass off (seek)");
+    }
+    cur.bypassTailFrames = 0;
+
+    int64_t preroll = 0;
+    double ioRatio = 1.0;
+    {
+        std::lock_guard<std::mutex> lock(gMutex);
+        preroll = std::min<int64_t>(gST.getSetting(SETTING_INITIAL_LATENCY), framesForMs(SEEK_PREROLL_MAX_MS));
+        ioRatio = gST.getInputOutputSampleRatio();
+        gST.clear();
+    }
+    preroll = cur.bypass ? 0 : std::max<int64_t>(0, std::min(preroll, targetFrame));
+
+    rewindInput(targetFrame - preroll, cur);
+    const int64_t dropOut = static_cast<int64_t>(std::llround(static_cast<double>(preroll) * ioRatio));
+    if (cur.late)
+    {
+        // pre-roll 출력은 워커가 버림 (소스 링 epoch 변경과 함께 인계)
+        cur.dropOutFrames = 0;
+        gLateDropOut.store(dropOut);
+        gSourceRing.clear();
+    }
+    else
+    {
+        cur.dropOutFrames = dropOut;
+    }
+
+    // 루프 replay 중이었다면 라이브 경로로 복귀 (구간 캐시는 유지)
+    cur.loop.replay = false;
+    cur.loop.held.clear();
+    cur.loop.rendered.reset();
+    cur.fadeFrom.clear();
+    cur.fadePos = 0;
+    cur.eosDrained = false;
+    gStreamEnd.store(STREAM_PLAYING);
+    gEndOfStreamEvent.store(false);
+
+    gStable.clear();
+    gLastSnapshot.requestClear();
+
+    // SoT를 타겟 위치로 재설정 + 짧은 워밍업
+    //  - 새 링의 첫 출력부터 적용할 비율은 다음 공급 때 마커로 (markedEpoch 불일치)
+    setPlayheadFrames(static_cast<uint64_t>(targetFrame));
+    gWarmupFrames.store(SEEK_GUARD_MIN_FRAMES);
+    gWarmupNeeded.store(true);
+}
+
+// 새 seek 명령이 도착했는지 (디코더 스레드용)
+static inline bool seekPending(const DecodeCursor &cur)
+{
+    return gSeekBox.latest() != cur.seenSeekSeq;
+}
+
+// 디코더 → 링 (가득 차면 소비될 때까지 대기)
+//  - 출력 링은 콜백이, 소스 링은 늦은 스트레치 워커가 소비하며 깨워준다
+//  - 정지 중이면 st_play/seek/close가 깨울 때까지 무기한
+//  - 중단(seek/종료)되면 false
+static bool pushRing(StableBuffer &ring, const float *buf, int frames, const DecodeCursor &cur)
+{
+    int offsetFrames = 0;
+    int remaining = frames;
+    while (remaining > 0)
+    {
+        if (!gDecodeRunning.load() || seekPending(cur))
+        {
+            return false;
+        }
+
+        int written = ring.push(buf + offsetFrames * CHANNELS, remaining);
+        if (written <= 0)
+        {
+            gDecodeWaker.wait(gPaused.load() ? 0 : DECODER_SAFETY_WAIT_MS);
+            continue;
+        }
+
+        remaining -= written;
+        offsetFrames += written;
+    }
+    return true;
+}
+
+// 경로 전환 크로스페이드(fadeFrom)가 남아 있으면 buf 앞부분에 섞는다 (제자리)
+static void applyPathFade(DecodeCursor &cur, float *buf, int frames)
+{
+    if (cur.fadeFrom.empty())
+    {
+        return;
+    }
+
+    const int64_t fadeFrames = static_cast<int64_t>(cur.fadeFrom.size() / CHANNELS);
+    for (int i = 0; i < frames && cur.fadePos < fadeFrames; ++i, ++cur.fadePos)
+    {
+        const float t = (static_cast<float>(cur.fadePos) + 0.5f) / static_cast<float>(fadeFrames);
+        float *y = buf + i * CHANNELS;
+        equalPowerMix(cur.fadeFrom.data() + cur.fadePos * CHANNELS, y, t, y);
+    }
+    if (cur.fadePos >= fadeFrames)
+    {
+        cur.fadeFrom.clear();
+        cur.fadePos = 0;
+    }
+}
+
+// 출력 프레임 → StableBuffer (가득 차면 콜백이 소비할 때까지 대기)
+//  - 중단(seek/종료)되면 false
+static bool pushOutput(float *buf, int frames, DecodeCursor &cur)
+{
+    applyPathFade(cur, buf, frames);
+    return pushRing(gStable, buf, frames, cur);
+}
+
+// SoundTouch 출력 → StableBuffer 직접 이동 (중간 버퍼 없음)
+//  - gMutex 안에서 출력 FIFO의 연속 구간(ptrBegin)을 링에 바로 쓰고 쓴 만큼만 receiveSamples
+//  - 링 여유만큼만 옮기므로 잠금을 잡은 채 기다리지 않는다
+//  - keepFrames: 출력 FIFO 끝에 남겨 둘 프레임
+//  - 리턴: 옮긴 프레임 수, 꺼낼 출력이 없으면 0, 링이 가득이면 -1
+static int moveSoundTouchToRing(DecodeCursor &cur, int64_t maxFrames, int64_t keepFrames = 0)
+{
+    std::lock_guard<std::mutex> lock(gMutex);
+    const int avail = static_cast<int>(std::min<int64_t>(
+        {static_cast<int64_t>(gST.numSamples()) - keepFrames, maxFrames, ST_DRAIN_CHUNK_FRAMES}));
+    if (avail <= 0)
+    {
+        return 0;
+    }
+    const int n = std::min(avail, gStable.freeFrames());
+    if (n <= 0)
+    {
+        return -1;
+    }
+
+    float *out = gST.outputBegin();
+    applyPathFade(cur, out, n);
+    gStable.push(out, n);
+    gST.receiveSamples(static_cast<uint>(n));
+    gCopyBytesSaved.fetch_add(static_cast<uint64_t>(n) * CHANNELS * sizeof(float), std::memory_order_relaxed);
+    gCopySavedFrames.fetch_add(static_cast<uint64_t>(n), std::memory_order_relaxed);
+    return n;
+}
+
+// pre-roll 출력 버리기 — 복사 없이 SoundTouch 출력 FIFO에서 지운다
+static int64_t dropSoundTouchOutput(int64_t frames)
+{
+    std::lock_guard<std::mutex> lock(gMutex);
+    const uint n = static_cast<uint>(std::min<int64_t>(frames, gST.numSamples()));
+    return n > 0 ? static_cast<int64_t>(gST.receiveSamples(n)) : 0;
+}
+
+// SoundTouch에서 꺼낼 수 있는 출력을 모두 StableBuffer로 이동
+//  - StableBuffer가 가득 차 있으면
+//    콜백이 소비해서 깨워줄 때까지 잠든 뒤 재시도
+//  - 일시정지 중에도 꺼낸 샘플은 버리지 않는다 (resume 시 끊김 방지)
+//  - 새 seek가 도착하면 즉시 중단 (남은 샘플은 어차피 무효)
+//  - keepFrames: 출력 FIFO 끝에 이만큼은 남겨 둔다 (우회 진입 크로스페이드 재료)
+static void drainSoundTouch(DecodeCursor &cur, int64_t keepFrames = 0)
+{
+    while (gDecodeRunning.load() && !seekPending(cur))
+    {
+        // pre-roll 구간 출력은 버림
+        if (cur.dropOutFrames > 0)
+        {
+            const int64_t dropped = dropSoundTouchOutput(cur.dropOutFrames);
+            if (dropped <= 0)
+            {
+                break;
+            }
+            cur.dropOutFrames -= dropped;
+            continue;
+        }
+
+        const int moved = moveSoundTouchToRing(cur, ST_DRAIN_CHUNK_FRAMES, keepFrames);
+        if (moved == 0)
+        {
+            // 현재 더 이상 꺼낼 샘플이 없음
+            break;
+        }
+        if (moved < 0)
+        {
+            gDecodeWaker.wait(gPaused.load() ? 0 : DECODER_SAFETY_WAIT_MS);
+        }
+    }
+}
+
+// 다음에 SoundTouch에 넣을 소스 샘플이 StableBuffer에 들어갈 위치 (추정)
+//  - 이미 링에 쓴 양 + SoundTouch 안에 남은 출력/입력 (입력은 출력/입력 비율로 환산)
+static size_t ringPosOfNextInput()
+{
+    std::lock_guard<std::mutex> lock(gMutex);
+    const double ioRatio = gST.getInputOutputSampleRatio();
+    double pending = static_cast<double>(gST.numSamples());
+    if (ioRatio > 0.0)
+    {
+        pending += static_cast<double>(gST.numUnprocessedSamples()) * ioRatio;
+    }
+    return gStable.writePos() + static_cast<size_t>(std::llround(pending));
+}
+
+// 소스/출력 비율 마커 — 지금 넣을 입력이 출력될 링 위치부터 콜백의 SoT 전진 속도를 바꾼다
+//  - seek 등으로 링이 새로 시작됐으면 링 처음부터 (그 앞 출력이 없음)
+//  - 마커 큐가 가득 차면 다음 공급 때 다시 시도
+static void markPlaybackRate(double &markedIoRatio, uint32_t &markedEpoch)
+{
+    double ioRatio = 1.0;
+    {
+        std::lock_guard<std::mutex> lock(gMutex);
+        ioRatio = gST.getInputOutputSampleRatio();
+    }
+    const uint32_t epoch = gStable.epoch();
+    if (ioRatio <= 0.0 || (ioRatio == markedIoRatio && epoch == markedEpoch))
+    {
+        return;
+    }
+
+    RingMarker m;
+    m.ringPos = epoch == markedEpoch ? ringPosOfNextInput() : gStable.writePos();
+    m.rate = 1.0 / ioRatio;
+    m.epoch = epoch;
+    if (gRingMarkers.push(m))
+    {
+        markedIoRatio = ioRatio;
+        markedEpoch = epoch;
+    }
+}
+
+// 다음 입력 위치에 마커 (루프 wrap / 스트림 끝)
+//  - 늦은 스트레치 모드면 소스 링 기준 → 워커가 SoundTouch에 넣는 순간 출력 링 위치로 옮김
+//  - 큐가 가득 차면 false
+static bool markNextInput(RingMarker m, const DecodeCursor &cur)
+{
+    if (cur.late)
+    {
+        m.ringPos = gSourceRing.writePos();
+        m.epoch = gSourceRing.epoch();
+        return gSourceMarkers.push(m);
+    }
+    m.ringPos = ringPosOfNextInput();
+    m.epoch = gStable.epoch();
+    return gRingMarkers.push(m);
+}
+
+// ─────────────────────────────
+// LateStretcher — 늦은 스트레치 워커 (소스 링 → SoundTouch → StableBuffer)
+//  - 출력 링을 목표량(ahead, 워밍업 중이면 워밍업 분량)까지만 채움
+//    → tempo/pitch 램프와 비율 마커가 콜백 바로 앞에서 적용됨
+//  - 콜백이 목표량 아래로 읽어 가면 lock 없이 깨워줌, 안전망 타임아웃은 짧게
+//  - step 1회는 gStretchStepMutex 안에서 → seek/스크럽은 step 사이에만 끼어든다
+//  - 가능하면 높은 QoS (macOS user-interactive)로 실행
+// ─────────────────────────────
+class LateStretcher
+{
+public:
+    ~LateStretcher()
+    {
+        stop();
+    }
+
+    void start()
+    {
+        if (thread_.joinable())
+        {
+            return;
+        }
+        running_.store(true);
+        thread_ = std::thread([this]()
+                              { run(); });
+        logLine("LateStretch", "worker started");
+    }
+
+    void stop()
+    {
+        running_.store(false);
+        gStretchWaker.notify();
+        if (thread_.joinable())
+        {
+            thread_.join();
+            logLine("LateStretch", "worker stopped");
+        }
+    }
+
+private:
+    void run()
+    {
+#if defined(__APPLE__)
+        pthread_set_qos_class_self_np(QOS_CLASS_USER_INTERACTIVE, 0);
+#endif
+        in_.assign(LATE_STRETCH_CHUNK_FRAMES * CHANNELS, 0.0f);
+        seenEpoch_ = UINT32_MAX;
+        markedIoRatio_ = 0.0;
+        markedEpoch_ = UINT32_MAX;
+
+        while (running_.load())
+        {
+            bool worked = false;
+            {
+                std::lock_guard<std::mutex> hold(gStretchStepMutex);
+                worked = step();
+            }
+            if (!worked)
+            {
+                gStretchWaker.wait(gPaused.load() ? 0 : LATE_STRETCH_SAFETY_WAIT_MS);
+            }
+        }
+    }
+
+    static int aheadFrames()
+    {
+        const int req = gStretchAheadReq.load();
+        const int frames = req > 0 ? req : gDevicePeriodFrames.load() * LATE_STRETCH_AUTO_PERIODS;
+        return std::max(LATE_STRETCH_MIN_AHEAD_FRAMES, std::min(frames, static_cast<int>(framesForMs(LATE_STRETCH_MAX_AHEAD_MS))));
+    }
+
+    // 한 단계 진행했으면 true (false = 할 일 없음 → 대기)
+    bool step()
+    {
+        if (!gLateActive.load() || gScrubActive.load())
+        {
+            return false;
+        }
+
+        // seek 등으로 소스 링이 새로 시작됨 → pre-roll 출력 버림 수 인계
+        const uint32_t epoch = gSourceRing.epoch();
+        if (epoch != seenEpoch_)
+        {
+            seenEpoch_ = epoch;
+            dropOut_ = gLateDropOut.load();
+        }
+
+        const int target = std::max(aheadFrames(), gWarmupNeeded.load() ? warmupFrames() : 0);
+        gStretchTarget.store(target);
+        const int room = target - gStable.size();
+        if (room <= 0)
+        {
+            return false;
+        }
+
+        // 1) SoundTouch에 이미 나와 있는 출력부터
+        if (drainOutput(room) > 0)
+        {
+            return true;
+        }
+
+        // 2) 읽기 위치에 도달한 소스 마커 → 출력 링 위치로 (스트림 끝이면 꼬리까지 flush)
+        size_t limit = LATE_STRETCH_CHUNK_FRAMES;
+        RingMarker m;
+        while (gSourceMarkers.peek(epoch, m))
+        {
+            const size_t readPos = gSourceRing.readPos();
+            if (m.ringPos > readPos)
+            {
+                limit = std::min(limit, m.ringPos - readPos);
+                break;
+            }
+            gSourceMarkers.popFront();
+
+            if (m.endOfStream)
+            {
+                finishStream();
+                return true;
+            }
+            m.ringPos = ringPosOfNextInput();
+            m.epoch = gStable.epoch();
+            gRingMarkers.push(m);
+        }
+
+        // 3) 소스 한 청크 → SoundTouch (tempo/pitch 램프 한 칸 + 비율 마커)
+        if (gSourceRing.size() <= 0)
+        {
+            return false;
+        }
+        paramRampStep(false);
+        markPlaybackRate(markedIoRatio_, markedEpoch_);
+
+        const int got = gSourceRing.pop(in_.data(), static_cast<int>(limit));
+        if (got <= 0)
+        {
+            return false;
+        }
+        putSamplesTimed(in_.data(), got);
+        if (gSourceRing.size() < gSourceRing.lowWatermark())
+        {
+            gDecodeWaker.notifyFromAudio();
+        }
+        return true;
+    }
+
+    // SoundTouch 출력 → StableBuffer (최대 maxFrames), pre-roll 구간은 버림
+    //  - 출력 FIFO에서 링으로 바로 쓰고 쓴 만큼만 꺼낸다 (중간 버퍼 없음)
+    int drainOutput(int maxFrames)
+    {
+        std::lock_guard<std::mutex> lock(gMutex);
+        const int avail = static_cast<int>(std::min<int64_t>(
+            {static_cast<int64_t>(gST.numSamples()), maxFrames, ST_DRAIN_CHUNK_FRAMES}));
+        if (avail <= 0)
+        {
+            return 0;
+        }
+
+        if (dropOut_ > 0)
+        {
+            const int dropped = static_cast<int>(std::min<int64_t>(dropOut_, avail));
+            gST.receiveSamples(static_cast<uint>(dropped));
+            dropOut_ -= dropped;
+            return dropped;
+        }
+
+        const int pushed = gStable.push(gST.outputBegin(), avail);
+        gST.receiveSamples(static_cast<uint>(pushed));
+        gCopyBytesSaved.fetch_add(static_cast<uint64_t>(pushed) * CHANNELS * sizeof(float),
+                                  std::memory_order_relaxed);
+        gCopySavedFrames.fetch_add(static_cast<uint64_t>(pushed), std::memory_order_relaxed);
+        return pushed;
+    }
+
+    // 스트림 끝: SoundTouch 꼬리까지 링에 넣고 DRAINING (링이 비면 콜백이 완료 이벤트)
+    void finishStream()
+    {
+        {
+            std::lock_guard<std::mutex> lock(gMutex);
+            gST.flush();
+        }
+        while (drainOutput(gStable.capacity() - gStable.size()) > 0)
+        {
+        }
+        gStreamEnd.store(STREAM_DRAINING);
+        logLine("LateStretch", "end of stream drained");
+    }
+
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::vector<float> in_;
+    uint32_t seenEpoch_ = UINT32_MAX;
+    int64_t dropOut_ = 0;
+    double markedIoRatio_ = 0.0;
+    uint32_t markedEpoch_ = UINT32_MAX;
+};
+
+static LateStretcher gLateStretch;
+
+// ─────────────────────────────
+// tempo 1 / pitch 0 우회 — 원속 재생은 SoundTouch 없이 소스를 바로 링으로
+//  - 출력/입력 비율이 1이라 링 위치 마커·pre-roll 버림 분량이 소스 프레임과 같다
+//  - 우회 중에는 최근 소스를 원형으로 기록 → 해제 시 SoundTouch pre-roll 재료
+// ─────────────────────────────
+
+static void bypassRemember(DecodeCursor &cur, const float *src, int frames)
+{
+    const int64_t cap = framesForMs(SEEK_PREROLL_MAX_MS);
+    if (cap <= 0)
+    {
+        return;
+    }
+    if (cur.bypassTail.size() != static_cast<size_t>(cap) * CHANNELS)
+    {
+        cur.bypassTail.assign(static_cast<size_t>(cap) * CHANNELS, 0.0f);
+        cur.bypassTailFrames = 0;
+    }
+
+    // 용량보다 긴 블록은 끝부분만
+    if (frames > cap)
+    {
+        src += (frames - cap) * CHANNELS;
+        cur.bypassTailFrames += frames - cap;
+        frames = static_cast<int>(cap);
+    }
+    for (int done = 0; done < frames;)
+    {
+        const int64_t idx = cur.bypassTailFrames % cap;
+        const int n = static_cast<int>(std::min<int64_t>(frames - done, cap - idx));
+        std::memcpy(cur.bypassTail.data() + idx * CHANNELS, src + done * CHANNELS,
+                    static_cast<size_t>(n) * CHANNELS * sizeof(float));
+        done += n;
+        cur.bypassTailFrames += n;
+    }
+}
+
+// 기록된 최근 소스 중 마지막 frames개를 시간 순서로 dst에 (리턴: 실제 프레임 수)
+static int64_t bypassRecall(const DecodeCursor &cur, int64_t frames, std::vector<float> &dst)
+{
+    const int64_t cap = static_cast<int64_t>(cur.bypassTail.size() / CHANNELS);
+    const int64_t n = std::min({frames, cur.bypassTailFrames, cap});
+    dst.resize(static_cast<size_t>(std::max<int64_t>(0, n)) * CHANNELS);
+    for (int64_t done = 0; done < n;)
+    {
+        const int64_t idx = (cur.bypassTailFrames - n + done) % cap;
+        const int64_t k = std::min(n - done, cap - idx);
+        std::memcpy(dst.data() + done * CHANNELS, cur.bypassTail.data() + idx * CHANNELS,
+                    static_cast<size_t>(k) * CHANNELS * sizeof(float));
+        done += k;
+    }
+    return std::max<int64_t>(0, n);
+}
+
+// 우회로 넘어갈 수 있는지 — 램프가 원속에 도달했고 진행 중인 경로 전환/pre-roll이 없을 때
+static bool stretchBypassReady(const DecodeCursor &cur)
+{
+    const ParamRamp &r = gParamRamp;
+    return stretchBypassWanted() && r.step >= PARAM_RAMP_BLOCKS &&
+           std::fabs(r.appliedTempo - 1.0f) < BYPASS_TEMPO_EPS && std::fabs(r.appliedPitch) < BYPASS_PITCH_EPS &&
+           cur.fadeFrom.empty() && cur.dropOutFrames == 0 && !cur.loop.rendered;
+}
+
+// SoundTouch → 우회 (방금 넣은 블록 src까지 SoundTouch가 처리한 상태)
+//  - flush로 블록 끝까지의 출력을 모두 만든 뒤 마지막 크로스페이드 분량만 남기고 링으로
+//  - 남긴 출력(= 블록 끝 원본과 같은 위치)에서 원본으로 크로스페이드 → 이후는 원본 그대로
+static void enterStretchBypass(const float *src, int frames, DecodeCursor &cur)
+{
+    const int64_t fade = std::min<int64_t>(framesForMs(BYPASS_XFADE_MS), frames);
+    {
+        std::lock_guard<std::mutex> lock(gMutex);
+        gST.flush();
+    }
+    drainSoundTouch(cur, fade);
+    if (seekPending(cur) || !gDecodeRunning.load())
+    {
+        return;
+    }
+
+    int got = 0;
+    cur.fadeFrom.resize(static_cast<size_t>(fade) * CHANNELS);
+    {
+        std::lock_guard<std::mutex> lock(gMutex);
+        got = fade > 0 ? static_cast<int>(gST.receiveSamples(cur.fadeFrom.data(), static_cast<uint>(fade))) : 0;
+        gST.clear();
+    }
+    cur.fadeFrom.resize(static_cast<size_t>(got) * CHANNELS);
+    cur.fadePos = 0;
+
+    cur.bypass = true;
+    cur.bypassTailFrames = 0;
+    gStretchBypassed.store(true);
+    bypassRemember(cur, src, frames);
+
+    std::vector<float> mix(src + (frames - got) * CHANNELS, src + frames * CHANNELS);
+    pushOutput(mix.data(), got, cur);
+    logLine("ST", "tempo 1 / pitch 0 → bypass");
+}
+
+// 우회 → SoundTouch (목표 tempo/pitch가 원속에서 벗어남, 블록 src부터 SoundTouch로)
+//  - 램프 대신 새 목표값으로 바로 바꾸고 첫 출력을 원본과 크로스페이드
+//  - 기록해 둔 직전 원본으로 SoundTouch를 pre-roll → 블록 src의 첫 출력이 제자리에 나온다
+static void leaveStretchBypass(const float *src, int frames, DecodeCursor &cur)
+{
+    paramRampStep(true);
+
+    int64_t preroll = 0;
+    double ioRatio = 1.0;
+    {
+        std::lock_guard<std::mutex> lock(gMutex);
+        preroll = std::min<int64_t>(gST.getSetting(SETTING_INITIAL_LATENCY), framesForMs(SEEK_PREROLL_MAX_MS));
+        ioRatio = gST.getInputOutputSampleRatio();
+        gST.clear();
+    }
+    std::vector<float> prime;
+    preroll = bypassRecall(cur, preroll, prime);
+
+    cur.bypass = false;
+    gStretchBypassed.store(false);
+
+    // 아직 버릴 원본이 남아 있었다면 (pre-roll 중 해제) 크로스페이드 없이 함께 버림
+    if (cur.dropOutFrames == 0)
+    {
+        const int64_t fade = std::min<int64_t>(framesForMs(BYPASS_XFADE_MS), frames);
+        cur.fadeFrom.assign(src, src + fade * CHANNELS);
+        cur.fadePos = 0;
+    }
+    cur.dropOutFrames = static_cast<int64_t>(
+        std::llround(static_cast<double>(preroll + cur.dropOutFrames) * ioRatio));
+
+    markPlaybackRate(cur.markedIoRatio, cur.markedEpoch);
+    if (preroll > 0)
+    {
+        putSamplesTimed(prime.data(), static_cast<int>(preroll));
+        drainSoundTouch(cur);
+    }
+    logLine("ST", "bypass → SoundTouch");
+}
+
+// 우회 중 공급: 원본 → 링 (크로스페이드 중인 앞부분만 복사해서 섞음)
+static void feedBypass(const float *src, int frames, DecodeCursor &cur)
+{
+    markPlaybackRate(cur.markedIoRatio, cur.markedEpoch);
+    bypassRemember(cur, src, frames);
+
+    // seek/루프 pre-roll 출력 버림 (원속이라 소스 프레임 그대로)
+    const int skip = static_cast<int>(std::min<int64_t>(cur.dropOutFrames, frames));
+    cur.dropOutFrames -= skip;
+    src += skip * CHANNELS;
+    frames -= skip;
+    if (frames <= 0)
+    {
+        return;
+    }
+
+    const int mixFrames = cur.fadeFrom.empty()
+                              ? 0
+                              : static_cast<int>(std::min<int64_t>(
+                                    static_cast<int64_t>(cur.fadeFrom.size() / CHANNELS) - cur.fadePos, frames));
+    if (mixFrames > 0)
+    {
+        std::vector<float> mix(src, src + mixFrames * CHANNELS);
+        if (!pushOutput(mix.data(), mixFrames, cur))
+        {
+            return;
+        }
+    }
+    pushRing(gStable, src + mixFrames * CHANNELS, frames - mixFrames, cur);
+}
+
+// 소스 샘플 → SoundTouch → StableBuffer
+//  - 라이브 디코드 / 루프 캐시 replay가 같은 경로로 공급
+//  - 원속(tempo 1 / pitch 0)이면 SoundTouch를 우회해 원본을 그대로 링으로
+static void feedSoundTouch(const float *src, int frames, DecodeCursor &cur)
+{
+    if (frames <= 0)
+    {
+        return;
+    }
+
+    // 늦은 스트레치 모드: 소스 링으로만 (SoundTouch는 워커가)
+    if (cur.late)
+    {
+        pushRing(gSourceRing, src, frames, cur);
+        gStretchWaker.notifyFromAudio();
+        return;
+    }
+
+    // 우회 중: 목표가 계속 원속이면 원본 그대로, 바뀌었으면 이 블록부터 SoundTouch로
+    if (cur.bypass)
+    {
+        if (stretchBypassWanted())
+        {
+            feedBypass(src, frames, cur);
+            return;
+        }
+        leaveStretchBypass(src, frames, cur);
+        if (seekPending(cur) || !gDecodeRunning.load())
+        {
+            return;
+        }
+    }
+
+    // 0) tempo/pitch 램프 한 칸 + 비율이 바뀌었으면 이 입력부터의 비율을 링에 표시
+    paramRampStep(false);
+    markPlaybackRate(cur.markedIoRatio, cur.markedEpoch);
+
+    // 1) 소스 샘플을 SoundTouch 입력 큐에 넣기 (스트레치 비용 = 거버너 부하)
+    putSamplesTimed(src, frames);
+
+    // 2) 변조된 샘플을 StableBuffer로 (원속에 도달했으면 여기서 우회로 전환)
+    if (stretchBypassReady(cur))
+    {
+        enterStretchBypass(src, frames, cur);
+        return;
+    }
+    drainSoundTouch(cur);
+}
+
+// ─────────────────────────────
+// A/B 루프 — 구간 캐시 replay + 크로스페이드 wrap
+// ─────────────────────────────
+
+// 구간 한 바퀴를 독립 SoundTouch로 렌더 (렌더 워커 스레드)
+//  - 주기 신호(이음새 포함 소스)를 초기 지연이 지나 안정될 때까지 반복 공급하고
+//    바퀴 길이의 배수 위치에서 한 바퀴를 잘라낸다 → 처음이 소스 A에 정렬
+//  - 끝 부분은 '처음 바로 앞' 출력과 크로스페이드 → 반복 재생 시 이음새 없음
+static std::shared_ptr<RenderedLoop> renderLoopCycle(const LoopSource &src, float tempo, float pitch,
+                                                     const std::function<bool()> &cancelled)
+{
+    SoundTouch st;
+    st.setSampleRate(gSampleRate);
+    st.setChannels(CHANNELS);
+    st.setSetting(SETTING_TRANSPOSER_ALGORITHM, ST_TRANSPOSER_ALGORITHM);
+    configureSoundTouch(st, tempo, pitch, false);
+
+    const double outPerIn = st.getInputOutputSampleRatio();
+    const int64_t cycleIn = src.b - src.a;
+    const int64_t cycleOut = std::max<int64_t>(2, std::llround(static_cast<double>(cycleIn) * outPerIn));
+    const int64_t tail = std::min<int64_t>(std::llround(static_cast<double>(src.xfade) * outPerIn), cycleOut / 2);
+    const int64_t settle = std::llround(st.getSetting(SETTING_INITIAL_LATENCY) * outPerIn) + tail;
+    const int64_t begin = cycleOut * std::max<int64_t>(1, (settle + cycleOut - 1) / cycleOut);
+    const int64_t need = begin + cycleOut;
+    const int64_t maxIn = static_cast<int64_t>(static_cast<double>(need) / outPerIn) + cycleIn + gSampleRate;
+
+    std::vector<float> out;
+    out.reserve(static_cast<size_t>(need + ST_DRAIN_CHUNK_FRAMES) * CHANNELS);
+    std::vector<float> in(LOOP_FEED_CHUNK_FRAMES * CHANNELS);
+    std::vector<float> recv(ST_DRAIN_CHUNK_FRAMES * CHANNELS);
+
+    for (int64_t j = 0; static_cast<int64_t>(out.size() / CHANNELS) < need; j += LOOP_FEED_CHUNK_FRAMES)
+    {
+        if (cancelled() || j > maxIn)
+        {
+            return nullptr;
+        }
+        for (int i = 0; i < LOOP_FEED_CHUNK_FRAMES; ++i)
+        {
+            src.periodicFrame(j + i, in.data() + i * CHANNELS);
+        }
+        st.putSamples(in.data(), LOOP_FEED_CHUNK_FRAMES);
+
+        int got = 0;
+        while ((got = static_cast<int>(st.receiveSamples(recv.data(), ST_DRAIN_CHUNK_FRAMES))) > 0)
+        {
+            out.insert(out.end(), recv.begin(), recv.begin() + got * CHANNELS);
+        }
+    }
+
+    auto R = std::make_shared<RenderedLoop>();
+    R->a = src.a;
+    R->b = src.b;
+    R->tempo = tempo;
+    R->pitch = pitch;
+    R->frames = cycleOut;
+    R->tailFade = tail;
+    R->pcm.assign(out.begin() + begin * CHANNELS, out.begin() + need * CHANNELS);
+
+    for (int64_t k = 0; k < tail; ++k)
+    {
+        float *y = R->pcm.data() + (cycleOut - tail + k) * CHANNELS;
+        const float t = (static_cast<float>(k) + 0.5f) / static_cast<float>(tail);
+        equalPowerMix(y, out.data() + (begin - tail + k) * CHANNELS, t, y);
+    }
+    return R;
+}
+
+// 루프 렌더 워커 — 디코더/오디오 스레드와 별개 코어에서 렌더
+//  - schedule: 대기열을 새 키 목록으로 교체 (앞쪽 우선, 이미 렌더된 키는 건너뜀)
+//  - reset: 진행 중 렌더 취소 + 결과 폐기 (구간 변경 / 디코더 종료)
+//  - 결과는 불변 shared_ptr로 넘겨주므로 디코더는 잠금 없이 읽는다
+class LoopRenderWorker
+{
+public:
+    ~LoopRenderWorker()
+    {
+        stop();
+    }
+
+    void schedule(const std::shared_ptr<const LoopSource> &src,
+                  const std::vector<std::pair<float, float>> &keys)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            jobs_.clear();
+            for (const auto &k : keys)
+            {
+                if (!findLocked(src->a, src->b, k.first, k.second))
+                {
+                    jobs_.push_back(Job{src, k.first, k.second});
+                }
+            }
+            if (jobs_.empty())
+            {
+                return;
+            }
+            if (!thread_.joinable())
+            {
+                stop_ = false;
+                thread_ = std::thread([this]()
+                                      { run(); });
+            }
+        }
+        cv_.notify_one();
+    }
+
+    std::shared_ptr<const RenderedLoop> find(int64_t a, int64_t b, float tempo, float pitch)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return findLocked(a, b, tempo, pitch);
+    }
+
+    void reset()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        jobs_.clear();
+        done_.clear();
+        generation_.fetch_add(1);
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+            jobs_.clear();
+            done_.clear();
+            generation_.fetch_add(1);
+        }
+        cv_.notify_all();
+        if (thread_.joinable())
+        {
+            thread_.join();
+        }
+    }
+
+private:
+    struct Job
+    {
+        std::shared_ptr<const LoopSource> src;
+        float tempo;
+        float pitch;
+    };
+
+    std::shared_ptr<const RenderedLoop> findLocked(int64_t a, int64_t b, float tempo, float pitch) const
+    {
+        for (const auto &r : done_)
+        {
+            if (r->matches(a, b, tempo, pitch))
+            {
+                return r;
+            }
+        }
+        return nullptr;
+    }
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stop_)
+        {
+            if (jobs_.empty())
+            {
+                cv_.wait(lock);
+                continue;
+            }
+
+            Job job = std::move(jobs_.front());
+            jobs_.pop_front();
+            if (findLocked(job.src->a, job.src->b, job.tempo, job.pitch))
+            {
+                continue;
+            }
+            const uint64_t gen = generation_.load();
+
+            lock.unlock();
+            std::shared_ptr<RenderedLoop> r = renderLoopCycle(
+                *job.src, job.tempo, job.pitch,
+                [this, gen]()
+                { return generation_.load() != gen; });
+            lock.lock();
+
+            if (r && generation_.load() == gen)
+            {
+                done_.push_back(std::move(r));
+                if (done_.size() > LOOP_RENDER_KEEP)
+                {
+                    done_.pop_front();
+                }
+                std::printf("[Loop] rendered cycle tempo=%.3f pitch=%.2f\n", job.tempo, job.pitch);
+            }
+        }
+    }
+
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Job> jobs_;
+    std::deque<std::shared_ptr<const RenderedLoop>> done_;
+    std::atomic<uint64_t> generation_{0};
+    bool stop_ = false;
+};
+
+static LoopRenderWorker gLoopRender;
+
+static inline int loopReportedRemaining(const LoopState &L)
+{
+    return L.enabled ? L.remaining : 0;
+}
+
+// 한 바퀴가 B에 도달: 남은 횟수 차감, wrap하지 않으면 루프 종료
+//  - 돌려준 마커 위치가 출력되는 순간 SoT(wrap이면 A로)와 남은 반복을 콜백이 갱신
+//  - 위치는 호출자가 정함 (렌더 캐시 = 출력 링 쓰기 위치, 그 외 = 다음 입력 위치)
+static RingMarker loopPassEnd(LoopState &L, bool wraps)
+{
+    if (L.remaining > 0)
+    {
+        --L.remaining;
+    }
+    if (!wraps || L.remaining == 0)
+    {
+        L.enabled = false;
+    }
+
+    RingMarker m;
+    m.srcFrame = wraps ? L.a : -1;
+    m.loopEvent = true;
+    m.loopRemaining = loopReportedRemaining(L);
+    return m;
+}
+
+// 구간 [a - xfade, b) PCM을 보조 입력으로 디코드해 캐시
+//  - 메인 디코더 위치는 건드리지 않는다
+//  - 너무 긴 구간은 캐시하지 않음 (라이브 되감기로 대체)
+static void loopBuildCache(LoopState &L, int64_t a, int64_t b, const DecodeCursor &cur,
+                           AVPacket *pkt, AVFrame *frame, std::vector<float> &conv)
+{
+    L.a = a;
+    L.b = b;
+    L.xfade = std::min<int64_t>({framesForMs(LOOP_XFADE_MS), a, (b - a) / 2});
+    L.src.reset();
+    L.rendered.reset();
+    L.requestedTempo = -1.0f;
+    gLoopRender.reset();
+
+    const int64_t frames = b - (a - L.xfade);
+    if (frames > framesForMs(LOOP_CACHE_MAX_MS) || gFilePath.empty())
+    {
+        logLine("Loop", "region not cached (too long) → live rewind at B");
+        return;
+    }
+
+    auto src = std::make_shared<LoopSource>();
+    src->a = a;
+    src->b = b;
+    src->xfade = L.xfade;
+    src->pcm.resize(static_cast<size_t>(frames) * CHANNELS);
+
+    // 전체 PCM 캐시가 있으면 복사만
+    if (cur.pcm)
+    {
+        cur.pcm->read(src->start(), static_cast<int>(frames), src->pcm.data());
+        L.src = std::move(src);
+        logLine("Loop", "region cached (from PCM cache)");
+        return;
+    }
+
+    AVFormatContext *fmt = nullptr;
+    AVCodecContext *codec = nullptr;
+    SwrContext *swr = nullptr;
+    int stream = -1;
+    if (!openAudioInput(gFilePath.c_str(), fmt, codec, swr, stream))
+    {
+        logLine("Loop", "region reader open failed → live rewind at B");
+        return;
+    }
+
+    PcmRangeReader reader;
+    reader.bind(fmt, codec, swr, stream);
+    reader.read(src->start(), static_cast<int>(frames), src->pcm.data(), pkt, frame, conv);
+
+    closeAudioInput(fmt, codec, swr);
+    L.src = std::move(src);
+    logLine("Loop", "region cached");
+}
+
+// 현재 tempo/pitch (+ tempo 이웃) 렌더를 워커에 요청 — 키가 바뀔 때만
+static void loopRequestRenders(LoopState &L)
+{
+    // 늦은 스트레치 모드는 SoundTouch를 콜백 직전에 돌리므로 렌더 캐시를 쓰지 않음
+    if (!L.src || !L.enabled || L.b - L.a > framesForMs(LOOP_RENDER_MAX_MS) || gLateActive.load())
+    {
+        return;
+    }
+
+    const float tempo = gParamBox.tempo();
+    const float pitch = gParamBox.pitch();
+    if (RenderedLoop::sameParam(tempo, L.requestedTempo) && RenderedLoop::sameParam(pitch, L.requestedPitch))
+    {
+        return;
+    }
+    L.requestedTempo = tempo;
+    L.requestedPitch = pitch;
+
+    std::vector<std::pair<float, float>> keys{{tempo, pitch}};
+    for (float d : {-LOOP_RENDER_TEMPO_STEP, LOOP_RENDER_TEMPO_STEP})
+    {
+        const float t = std::max(0.5f, std::min(1.7f, tempo + d));
+        if (!RenderedLoop::sameParam(t, tempo))
+        {
+            keys.emplace_back(t, pitch);
+        }
+    }
+    gLoopRender.schedule(L.src, keys);
+}
+
+static void loopApply(const LoopCommand &cmd, DecodeCursor &cur,
+                      AVPacket *pkt, AVFrame *frame, std::vector<float> &conv)
+{
+    LoopState &L = cur.loop;
+
+    if (!cmd.enabled)
+    {
+        // replay 중이면 이번 바퀴를 B까지 마저 재생하고 held로 자연스럽게 이어짐
+        L.enabled = false;
+        L.remaining = 0;
+        return;
+    }
+
+    const int64_t a = static_cast<int64_t>(std::llround(std::max(0.0, cmd.aMs) / 1000.0 * gSampleRate));
+    const int64_t b = static_cast<int64_t>(std::llround(std::max(0.0, cmd.bMs) / 1000.0 * gSampleRate));
+    const int remaining = cmd.repeat <= 0 ? -1 : cmd.repeat;
+
+    if (!L.sameRegion(a, b))
+    {
+        // 재생 중이던 캐시가 무효 → 지금 들리는 위치에서 라이브 경로로 재정렬
+        if (L.replay)
+        {
+            executeSeek(static_cast<double>(audiblePlayheadFrames()) / gSampleRate * 1000.0, cur);
+        }
+        loopBuildCache(L, a, b, cur, pkt, frame, conv);
+    }
+
+    L.enabled = true;
+    L.remaining = remaining;
+    loopRequestRenders(L);
+}
+
+// 렌더 캐시의 from 위치부터 이어지는 출력을 전환 크로스페이드 재료로
+static void loopFadeFromRendered(DecodeCursor &cur, const RenderedLoop &R, int64_t from)
+{
+    const int64_t n = std::min<int64_t>(framesForMs(LOOP_XFADE_MS), R.frames);
+    cur.fadeFrom.resize(static_cast<size_t>(n) * CHANNELS);
+    for (int64_t k = 0; k < n; ++k)
+    {
+        std::memcpy(cur.fadeFrom.data() + k * CHANNELS, R.at((from + k) % R.frames), CHANNELS * sizeof(float));
+    }
+    cur.fadePos = 0;
+}
+
+// SoundTouch → 렌더 캐시 (wrap 직후, 소스가 A에 있을 때)
+//  - SoundTouch 안에 남은 wrap 이전 출력은 A 이후 소스를 더 넣어 끝까지 꺼내 링으로 보내고
+//  - 그 뒤에 이어지는 출력(= A 이후)은 렌더 캐시 앞부분과 크로스페이드한다
+static void loopEnterRendered(DecodeCursor &cur, std::shared_ptr<const RenderedLoop> R,
+                              std::vector<float> &chunk)
+{
+    LoopState &L = cur.loop;
+    const LoopSource &S = *L.src;
+
+    int64_t pendingOut = std::max<int64_t>(
+        0, static_cast<int64_t>(ringPosOfNextInput()) - static_cast<int64_t>(gStable.writePos()));
+    const int64_t drop = std::min(cur.dropOutFrames, pendingOut);
+    const int64_t fadeFrames = std::min<int64_t>(framesForMs(LOOP_XFADE_MS), R->frames / 2);
+    const int64_t want = pendingOut + fadeFrames;
+    pendingOut -= drop;
+    cur.dropOutFrames -= drop;
+
+    for (int64_t fed = 0; fed < gSampleRate;)
+    {
+        {
+            std::lock_guard<std::mutex> lock(gMutex);
+            if (static_cast<int64_t>(gST.numSamples()) >= want)
+            {
+                break;
+            }
+        }
+        for (int i = 0; i < LOOP_FEED_CHUNK_FRAMES; ++i)
+        {
+            S.periodicFrame(fed + i, chunk.data() + i * CHANNELS);
+        }
+        std::lock_guard<std::mutex> lock(gMutex);
+        gST.putSamples(chunk.data(), LOOP_FEED_CHUNK_FRAMES);
+        fed += LOOP_FEED_CHUNK_FRAMES;
+    }
+
+    auto receive = [&](float *dst, int64_t frames) -> int
+    {
+        std::lock_guard<std::mutex> lock(gMutex);
+        return static_cast<int>(gST.receiveSamples(dst, static_cast<uint>(frames)));
+    };
+
+    for (int64_t left = drop; left > 0;)
+    {
+        const int64_t got = dropSoundTouchOutput(left);
+        if (got <= 0)
+        {
+            break;
+        }
+        left -= got;
+    }
+    for (int64_t left = pendingOut; left > 0 && gDecodeRunning.load() && !seekPending(cur);)
+    {
+        const int moved = moveSoundTouchToRing(cur, left);
+        if (moved == 0)
+        {
+            break;
+        }
+        if (moved < 0)
+        {
+            gDecodeWaker.wait(gPaused.load() ? 0 : DECODER_SAFETY_WAIT_MS);
+            continue;
+        }
+        left -= moved;
+    }
+    if (seekPending(cur) || !gDecodeRunning.load())
+    {
+        return;
+    }
+
+    cur.fadeFrom.resize(static_cast<size_t>(fadeFrames) * CHANNELS);
+    const int got = fadeFrames > 0 ? receive(cur.fadeFrom.data(), fadeFrames) : 0;
+    cur.fadeFrom.resize(static_cast<size_t>(std::max(0, got)) * CHANNELS);
+    cur.fadePos = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(gMutex);
+        gST.clear();
+    }
+    L.rendered = std::move(R);
+    L.rpos = 0;
+    logLine("Loop", "steady loop → rendered cycle");
+}
+
+// 렌더 캐시 → SoundTouch (마지막 바퀴 / 해제 / 새 키의 렌더가 아직 없음)
+//  - 같은 소스 위치에서 SoundTouch를 주기 신호로 pre-roll (출력은 버림)
+//  - 첫 출력은 렌더 캐시의 이어지는 구간과 크로스페이드
+static void loopLeaveRendered(DecodeCursor &cur, std::vector<float> &chunk)
+{
+    LoopState &L = cur.loop;
+    const LoopSource &S = *L.src;
+    const RenderedLoop &R = *L.rendered;
+
+    const int64_t srcPos = std::min(R.srcOf(L.rpos), L.b - 1);
+    loopFadeFromRendered(cur, R, L.rpos);
+    L.rendered.reset();
+    L.pos = srcPos;
+    L.passWraps = srcPos >= L.fadeStart() ? true : L.wrapsNow();
+
+    // SoundTouch를 비우고 새로 시작 → 진행 중인 램프는 바로 목표값으로
+    paramRampStep(true);
+
+    int64_t preroll = 0;
+    double ioRatio = 1.0;
+    {
+        std::lock_guard<std::mutex> lock(gMutex);
+        preroll = std::min<int64_t>(gST.getSetting(SETTING_INITIAL_LATENCY), framesForMs(SEEK_PREROLL_MAX_MS));
+        ioRatio = gST.getInputOutputSampleRatio();
+        gST.clear();
+    }
+    cur.dropOutFrames = static_cast<int64_t>(std::llround(static_cast<double>(preroll) * ioRatio));
+
+    for (int64_t done = 0; done < preroll;)
+    {
+        const int n = static_cast<int>(std::min<int64_t>(LOOP_FEED_CHUNK_FRAMES, preroll - done));
+        for (int i = 0; i < n; ++i)
+        {
+            S.periodicFrame(srcPos - L.a - preroll + done + i, chunk.data() + i * CHANNELS);
+        }
+        feedSoundTouch(chunk.data(), n, cur);
+        done += n;
+    }
+    logLine("Loop", "rendered cycle → SoundTouch");
+}
+
+// 렌더 캐시 반복 — 링에 복사만 (정상 반복 중 SoundTouch 연산 없음)
+static void loopRenderedStep(DecodeCursor &cur, std::vector<float> &chunk)
+{
+    LoopState &L = cur.loop;
+    const RenderedLoop &R = *L.rendered;
+    const float tempo = gParamBox.tempo();
+    const float pitch = gParamBox.pitch();
+
+    if (!R.matches(L.a, L.b, tempo, pitch))
+    {
+        // 이웃 렌더가 준비돼 있으면 같은 위치로 옮겨 타고, 없으면 SoundTouch로
+        std::shared_ptr<const RenderedLoop> next = gLoopRender.find(L.a, L.b, tempo, pitch);
+        if (!next)
+        {
+            loopLeaveRendered(cur, chunk);
+            return;
+        }
+        loopFadeFromRendered(cur, R, L.rpos);
+        L.rpos = static_cast<int64_t>(static_cast<double>(L.rpos) * static_cast<double>(next->frames) /
+                                      static_cast<double>(R.frames)) % next->frames;
+        L.rendered = std::move(next);
+        return;
+    }
+
+    // 마지막 바퀴 / 해제: 끝 페이드 전에 SoundTouch로 넘겨 B 이후로 이어지게
+    if (!L.wrapsNow() && L.rpos < R.frames - R.tailFade)
+    {
+        loopLeaveRendered(cur, chunk);
+        return;
+    }
+
+    // 크로스페이드가 없으면 렌더 캐시에서 링으로 바로 (섞을 때만 chunk에 복사)
+    const int n = static_cast<int>(std::min<int64_t>(LOOP_FEED_CHUNK_FRAMES, R.frames - L.rpos));
+    bool pushed = false;
+    if (cur.fadeFrom.empty())
+    {
+        pushed = pushRing(gStable, R.at(L.rpos), n, cur);
+    }
+    else
+    {
+        std::memcpy(chunk.data(), R.at(L.rpos), static_cast<size_t>(n) * CHANNELS * sizeof(float));
+        pushed = pushOutput(chunk.data(), n, cur);
+    }
+    if (!pushed)
+    {
+        return;
+    }
+    L.rpos += n;
+    gLoopRenderedFrames.fetch_add(static_cast<uint64_t>(n), std::memory_order_relaxed);
+
+    if (L.rpos >= R.frames)
+    {
+        L.rpos = 0;
+        RingMarker m = loopPassEnd(L, true);
+        m.ringPos = gStable.writePos();
+        m.epoch = gStable.epoch();
+        gRingMarkers.push(m);
+    }
+}
+
+static void loopReplayStep(DecodeCursor &cur, std::vector<float> &chunk)
+{
+    LoopState &L = cur.loop;
+    loopRequestRenders(L);
+
+    if (L.rendered)
+    {
+        loopRenderedStep(cur, chunk);
+        return;
+    }
+
+    const LoopSource &S = *L.src;
+    const int64_t fadeStart = L.fadeStart();
+
+    if (L.pos < fadeStart)
+    {
+        L.passWraps = L.wrapsNow();
+    }
+
+    const int n = static_cast<int>(std::min<int64_t>(LOOP_FEED_CHUNK_FRAMES, L.b - L.pos));
+    for (int i = 0; i < n; ++i)
+    {
+        const int64_t f = L.pos + i;
+        float *y = chunk.data() + i * CHANNELS;
+
+        if (L.passWraps)
+        {
+            S.periodicFrame(f - L.a, y);
+        }
+        else
+        {
+            std::memcpy(y, S.at(f), CHANNELS * sizeof(float));
+        }
+    }
+
+    feedSoundTouch(chunk.data(), n, cur);
+    if (seekPending(cur) || !gDecodeRunning.load())
+    {
+        return;
+    }
+    L.pos += n;
+
+    if (L.pos < L.b)
+    {
+        return;
+    }
+
+    const bool wraps = L.passWraps;
+    markNextInput(loopPassEnd(L, wraps), cur);
+
+    if (wraps)
+    {
+        L.pos = L.a;
+
+        // 다음 바퀴도 반복이고 현재 키의 렌더가 준비돼 있으면 렌더 캐시로
+        if (L.wrapsNow() && !cur.late && !cur.bypass)
+        {
+            std::shared_ptr<const RenderedLoop> R = gLoopRender.find(L.a, L.b, gParamBox.tempo(), gParamBox.pitch());
+            if (R)
+            {
+                loopEnterRendered(cur, std::move(R), chunk);
+            }
+        }
+        return;
+    }
+
+    // 루프 종료: 보관해 둔 라이브 샘플 중 B 이후부터 이어서, 이후 FFmpeg 디코드 재개
+    L.replay = false;
+    const int64_t heldFrames = static_cast<int64_t>(L.held.size() / CHANNELS);
+    if (L.heldStart + heldFrames > L.b)
+    {
+        const int64_t off = L.b - L.heldStart;
+        feedSoundTouch(L.held.data() + off * CHANNELS, static_cast<int>(heldFrames - off), cur);
+    }
+    L.held.clear();
+    cur.dropSrcUntil = std::max(cur.dropSrcUntil, L.b);
+}
+
+// 라이브 디코드 샘플 공급 ([srcStart, srcStart+frames))
+//  - replay 중이면 held에 보관만
+//  - 루프 구간의 B-xfade에 닿으면 그 앞까지만 공급하고 replay로 전환
+//  - 캐시 없는 긴 구간은 B까지 공급 후 FFmpeg 입력만 A로 되감기
+static void feedLive(const float *src, int64_t srcStart, int frames, DecodeCursor &cur)
+{
+    LoopState &L = cur.loop;
+
+    if (L.replay)
+    {
+        L.held.insert(L.held.end(), src, src + static_cast<size_t>(frames) * CHANNELS);
+        return;
+    }
+
+    const int64_t srcEnd = srcStart + frames;
+    if (!L.enabled || srcStart >= L.b || srcEnd <= L.fadeStart())
+    {
+        feedSoundTouch(src, frames, cur);
+        return;
+    }
+
+    if (L.hasCache())
+    {
+        const int64_t cut = std::max(srcStart, L.fadeStart());
+        const int head = static_cast<int>(cut - srcStart);
+        feedSoundTouch(src, head, cur);
+
+        L.held.assign(src + static_cast<size_t>(head) * CHANNELS, src + static_cast<size_t>(frames) * CHANNELS);
+        L.heldStart = cut;
+        L.pos = cut;
+        L.passWraps = L.wrapsNow();
+        L.replay = true;
+        return;
+    }
+
+    // 긴 구간: B에 닿을 때까지는 그대로
+    if (srcEnd < L.b)
+    {
+        feedSoundTouch(src, frames, cur);
+        return;
+    }
+
+    const int head = static_cast<int>(L.b - srcStart);
+    feedSoundTouch(src, head, cur);
+
+    const bool wraps = L.wrapsNow();
+    markNextInput(loopPassEnd(L, wraps), cur);
+    if (wraps)
+    {
+        rewindInput(L.a, cur); // 이 패킷의 나머지 프레임은 flush로 버려짐
+        return;
+    }
+    feedSoundTouch(src + static_cast<size_t>(head) * CHANNELS, frames - head, cur);
+}
+
+// ─────────────────────────────
+// 스크럽 — 디코드된 PCM 창에서 짧은 그레인을 겹쳐 이어 붙이는 가변 속도 재생
+//  - 디코더 스레드 전용 (메인 FFmpeg 컨텍스트를 그대로 빌려 씀)
+//  - SoundTouch를 거치지 않는다: 그레인 자체가 원래 속도/피치로 재생되고
+//    재생 위치만 velocity × hop씩 이동 → 빠르게 돌려도 소리가 뭉개지지 않음
+//  - 역방향은 창 앞쪽으로 청크를 거꾸로 디코드해 붙이고, 그레인을 뒤집어 읽는다
+//  - 스크럽 종료 시 현재 위치로 executeSeek → 일반 재생 경로로 복귀
+// ─────────────────────────────
+
+// 스크럽 상태 (디코더 스레드 로컬)
+struct ScrubState
+{
+    bool active = false;
+    bool following = false; // 마지막 모드가 FOLLOW였는지 (종료 위치 = 타겟)
+    double playhead = 0.0;  // 소스 프레임 (소수점 = 다음 그레인 시작 위치)
+    float gain = 0.0f;     // fade in/out 용 현재 게인
+
+    // 디코드된 PCM 창: [winStart, winStart + winFrames)
+    std::vector<float> win;
+    int64_t winStart = 0;
+    int64_t winFrames = 0;
+
+    std::vector<float> hann;  // SCRUB_GRAIN_FRAMES
+    std::vector<float> ola;   // overlap-add 누적 (SCRUB_GRAIN_FRAMES)
+    std::vector<float> chunk; // 청크 디코드 임시 버퍼
+    std::vector<float> out;   // hop 출력
+    PcmRangeReader reader;
+
+    ScrubState()
+        : hann(SCRUB_GRAIN_FRAMES),
+          ola(SCRUB_GRAIN_FRAMES * CHANNELS, 0.0f),
+          chunk(SCRUB_CHUNK_FRAMES * CHANNELS),
+          out(SCRUB_HOP_FRAMES * CHANNELS)
+    {
+        // periodic Hann: hop = N/2에서 합이 정확히 1
+        for (int i = 0; i < SCRUB_GRAIN_FRAMES; ++i)
+        {
+            hann[i] = 0.5f - 0.5f * std::cos(2.0f * static_cast<float>(M_PI) * i / SCRUB_GRAIN_FRAMES);
+        }
+    }
+
+    inline float sampleAt(int64_t f, int ch) const
+    {
+        const int64_t i = f - winStart;
+        if (i < 0 || i >= winFrames)
+        {
+            return 0.0f;
+        }
+        return win[static_cast<size_t>(i * CHANNELS + ch)];
+    }
+};
+
+static inline int64_t durationFrames()
+{
+    return static_cast<int64_t>(gDurationMs / 1000.0 * gSampleRate);
+}
+
+// PCM 창이 [lo, hi)를 덮도록 청크 단위로 디코드해서 늘림
+//  - 멀리 점프했으면 창을 버리고 새로 채움
+//  - 최대 길이를 넘으면 진행 방향의 반대쪽을 잘라냄
+static void scrubEnsureWindow(ScrubState &s, int64_t lo, int64_t hi, int dir,
+                              AVPacket *pkt, AVFrame *frame, std::vector<float> &conv)
+{
+    lo = std::max<int64_t>(0, lo);
+    const int64_t winEnd = s.winStart + s.winFrames;
+
+    if (s.winFrames == 0 || hi < s.winStart - SCRUB_CHUNK_FRAMES || lo > winEnd + SCRUB_CHUNK_FRAMES)
+    {
+        s.winStart = std::max<int64_t>(0, lo - SCRUB_CHUNK_FRAMES / 2);
+        s.winFrames = 0;
+        s.win.clear();
+    }
+
+    // 뒤쪽 확장 (순방향: reader가 이어서 디코드 → seek 없음)
+    while (s.winStart + s.winFrames < hi)
+    {
+        s.reader.read(s.winStart + s.winFrames, SCRUB_CHUNK_FRAMES, s.chunk.data(), pkt, frame, conv);
+        s.win.insert(s.win.end(), s.chunk.begin(), s.chunk.end());
+        s.winFrames += SCRUB_CHUNK_FRAMES;
+    }
+
+    // 앞쪽 확장 (역방향: 청크를 거꾸로 하나씩 디코드)
+    while (s.winStart > 0 && s.winStart > lo)
+    {
+        const int64_t newStart = std::max<int64_t>(0, s.winStart - SCRUB_CHUNK_FRAMES);
+        const int n = static_cast<int>(s.winStart - newStart);
+        s.reader.read(newStart, n, s.chunk.data(), pkt, frame, conv);
+        s.win.insert(s.win.begin(), s.chunk.begin(), s.chunk.begin() + n * CHANNELS);
+        s.winStart = newStart;
+        s.winFrames += n;
+    }
+
+    // 최대 길이 초과분 정리 (청크 단위)
+    while (s.winFrames > framesForMs(SCRUB_WINDOW_MAX_MS))
+    {
+        if (dir >= 0 && lo - s.winStart >= SCRUB_CHUNK_FRAMES)
+        {
+            s.win.erase(s.win.begin(), s.win.begin() + SCRUB_CHUNK_FRAMES * CHANNELS);
+            s.winStart += SCRUB_CHUNK_FRAMES;
+            s.winFrames -= SCRUB_CHUNK_FRAMES;
+        }
+        else if (dir < 0 && s.winStart + s.winFrames - hi >= SCRUB_CHUNK_FRAMES)
+        {
+            s.win.resize(s.win.size() - SCRUB_CHUNK_FRAMES * CHANNELS);
+            s.winFrames -= SCRUB_CHUNK_FRAMES;
+        }
+        else
+        {
+            break;
+        }
+    }
+}
+
+// 스크럽 진입: 현재 SoT 위치에서 시작, 일반 재생 버퍼는 비움
+static void scrubEnter(ScrubState &s, const DecodeCursor &cur)
+{
+    std::lock_guard<std::mutex> hold(gStretchStepMutex); // 늦은 스트레치 워커 step 사이에만
+    s.active = true;
+    s.playhead = static_cast<double>(audiblePlayheadFrames());
+    s.gain = 0.0f;
+    std::fill(s.ola.begin(), s.ola.end(), 0.0f);
+    s.win.clear();
+    s.winFrames = 0;
+    s.reader.bind(gFmtCtx, gCodecCtx, gSwr, gAudioStreamIndex); // 메인 디코더가 쓰던 위치와 무관
+    s.reader.useStore(cur.pcm);
+
+    if (cur.late)
+    {
+        // 워커가 스크럽 종료 직후 옛 SoundTouch 출력을 내보내지 않도록
+        std::lock_guard<std::mutex> lock(gMutex);
+        gST.clear();
+        gSourceRing.clear();
+    }
+    gStable.clear();
+    gLastSnapshot.requestClear();
+    gWarmupNeeded.store(false);
+    gScrubActive.store(true);
+    logLine("Scrub", "enter");
+}
+
+// 스크럽 종료: 마지막 위치로 일반 재생 경로를 다시 맞춤
+//  - 드래그(FOLLOW)였으면 추종 중이던 playhead 대신 손을 뗀 타겟 위치로
+static void scrubExit(ScrubState &s, DecodeCursor &cur)
+{
+    s.active = false;
+    gScrubActive.store(false);
+    const double exitMs = s.following ? gScrubTargetMs.load() : s.playhead / gSampleRate * 1000.0;
+    executeSeek(exitMs, cur);
+    logLine("Scrub", "exit");
+}
+
+// 스크럽 1 step (hop 1개 생성)
+//  - return false: 스크럽 중이 아님 → 일반 디코드 경로로
+static bool scrubStep(ScrubState &s, DecodeCursor &cur,
+                      AVPacket *pkt, AVFrame *frame, std::vector<float> &conv)
+{
+    const int mode = gScrubMode.load();
+    if (mode == SCRUB_OFF)
+    {
+        if (s.active)
+        {
+            scrubExit(s, cur);
+            return true;
+        }
+        return false;
+    }
+
+    if (!gFileOpened.load() || !gFmtCtx || !gCodecCtx || !gSwr || gAudioStreamIndex < 0)
+    {
+        gDecodeWaker.wait(0);
+        return true;
+    }
+
+    if (!s.active)
+    {
+        scrubEnter(s, cur);
+    }
+
+    // 링에는 짧게만 쌓는다 (콜백이 low watermark 아래에서 매번 깨워 줌)
+    if (gStable.size() >= SCRUB_AHEAD_FRAMES)
+    {
+        gDecodeWaker.wait(DECODER_SAFETY_WAIT_MS);
+        return true;
+    }
+
+    // 속도 결정
+    s.following = mode == SCRUB_FOLLOW;
+    double v = 0.0;
+    if (mode == SCRUB_FOLLOW)
+    {
+        const double target = gScrubTargetMs.load() / 1000.0 * gSampleRate;
+        v = (target - s.playhead) / (SCRUB_FOLLOW_TAU_SEC * gSampleRate);
+    }
+    else
+    {
+        v = gScrubVelocity.load();
+    }
+    v = std::max(-SCRUB_MAX_SPEED, std::min(SCRUB_MAX_SPEED, v));
+
+    // 파일 양 끝에서는 멈춤
+    const int64_t endFrame = durationFrames();
+    if ((v < 0.0 && s.playhead <= 0.0) || (v > 0.0 && endFrame > 0 && s.playhead >= endFrame))
+    {
+        v = 0.0;
+    }
+
+    const float targetGain = std::fabs(v) >= SCRUB_MIN_SPEED ? 1.0f : 0.0f;
+    if (targetGain == 0.0f && s.gain == 0.0f)
+    {
+        // 멈춰 있음: 새 velocity/target이 올 때까지 잠듦
+        gDecodeWaker.wait(0);
+        return true;
+    }
+
+    // 그레인 1개: playhead에서 진행 방향으로 GRAIN 프레임 (역방향은 거꾸로 읽기)
+    const int dir = v < 0.0 ? -1 : 1;
+    const int64_t p = static_cast<int64_t>(std::llround(s.playhead));
+    const int64_t lo = dir > 0 ? p : p - SCRUB_GRAIN_FRAMES;
+    const int64_t hi = dir > 0 ? p + SCRUB_GRAIN_FRAMES : p + 1;
+    scrubEnsureWindow(s, lo, hi, dir, pkt, frame, conv);
+
+    for (int k = 0; k < SCRUB_GRAIN_FRAMES; ++k)
+    {
+        const int64_t f = p + static_cast<int64_t>(dir) * k;
+        const float w = s.hann[k];
+        for (int ch = 0; ch < CHANNELS; ++ch)
+        {
+            s.ola[k * CHANNELS + ch] += s.sampleAt(f, ch) * w;
+        }
+    }
+
+    // 앞쪽 hop 출력 (게인은 hop 동안 선형 ramp) + 누적 버퍼 shift
+    const float g0 = s.gain;
+    const float dg = (targetGain - g0) / SCRUB_HOP_FRAMES;
+    for (int k = 0; k < SCRUB_HOP_FRAMES; ++k)
+    {
+        const float g = g0 + dg * (k + 1);
+        for (int ch = 0; ch < CHANNELS; ++ch)
+        {
+            s.out[k * CHANNELS + ch] = s.ola[k * CHANNELS + ch] * g;
+        }
+    }
+    s.gain = targetGain;
+    std::memmove(s.ola.data(), s.ola.data() + SCRUB_HOP_FRAMES * CHANNELS,
+                 SCRUB_HOP_FRAMES * CHANNELS * sizeof(float));
+    std::fill(s.ola.begin() + SCRUB_HOP_FRAMES * CHANNELS, s.ola.end(), 0.0f);
+
+    s.playhead += v * SCRUB_HOP_FRAMES;
+    s.playhead = std::max(0.0, s.playhead);
+    if (endFrame > 0)
+    {
+        s.playhead = std::min(static_cast<double>(endFrame), s.playhead);
+    }
+
+    gStable.push(s.out.data(), SCRUB_HOP_FRAMES); // AHEAD < 용량 → 항상 들어감
+    setPlayheadFrames(static_cast<uint64_t>(s.playhead));
+    return true;
+}
+
+// 디코더 쓰레드 (파일이 열려 있는 동안 1개만 유지)
+//  - FFmpeg → Swr → SoundTouch.putSamples()
+//  - SoundTouch.receiveSamples() → StableBuffer.push()
+//  - seek는 SeekMailbox로 받아 이 스레드 안에서 실행 (join/재생성 없음)
+//  - 스크럽 모드에서는 FFmpeg → 그레인 OLA → StableBuffer (SoundTouch 우회)
+//  - gPaused == true면 워밍업 분량만 미리 채우고 잠듦 (출력은 콜백에서 무음 처리)
+//  - StableBuffer가 충분히 차 있으면 back-pressure로 디코딩 속도 제어
+// 변환된 소스 샘플 공급 (pre-roll 시작점 이전 샘플은 버림 — keyframe 단위 seek 보정)
+static void feedConverted(DecodeCursor &cur, const float *pcm, int frames)
+{
+    const int skip = static_cast<int>(
+        std::max<int64_t>(0, std::min<int64_t>(cur.dropSrcUntil - cur.srcFrame, frames)));
+    cur.srcFrame += frames;
+
+    if (skip >= frames)
+    {
+        return;
+    }
+
+    feedLive(pcm + skip * CHANNELS, cur.srcFrame - (frames - skip), frames - skip, cur);
+}
+
+// Swr 출력을 SoundTouch 입력 FIFO에 바로 쓰는 경로
+//  - 늦은 스트레치 / 원속 우회 / pre-roll 버림 / 루프 구간 처리가 필요 없는 프레임만 (나머지는 feedConverted)
+//  - convBuffer → SoundTouch 입력 복사 한 번을 줄인다
+//  - 처리했으면 true
+static bool feedConvertedDirect(DecodeCursor &cur, AVFrame *frame)
+{
+    const LoopState &L = cur.loop;
+    if (cur.late || cur.bypass || cur.dropSrcUntil > cur.srcFrame || L.replay || stretchBypassWanted())
+    {
+        return false;
+    }
+    const int maxOut = swr_get_out_samples(gSwr, frame->nb_samples);
+    if (maxOut <= 0 || (L.enabled && cur.srcFrame < L.b && cur.srcFrame + maxOut > L.fadeStart()))
+    {
+        return false;
+    }
+
+    paramRampStep(false);
+    markPlaybackRate(cur.markedIoRatio, cur.markedEpoch);
+
+    int n = 0;
+    int64_t costNs = 0;
+    {
+        std::lock_guard<std::mutex> lock(gMutex);
+        uint8_t *outData[1] = {reinterpret_cast<uint8_t *>(gST.inputSpan(static_cast<uint>(maxOut)))};
+        n = swr_convert(gSwr, outData, maxOut, const_cast<const uint8_t **>(frame->data), frame->nb_samples);
+        if (n > 0)
+        {
+            const int64_t t0 = steadyNowNs();
+            gST.commitInput(static_cast<uint>(n));
+            costNs = steadyNowNs() - t0;
+        }
+    }
+    if (n > 0)
+    {
+        gGovernor.onStretch(costNs, n, gParamRamp.appliedTempo);
+        gCopyBytesSaved.fetch_add(static_cast<uint64_t>(n) * CHANNELS * sizeof(float), std::memory_order_relaxed);
+        cur.srcFrame += n;
+    }
+
+    drainSoundTouch(cur);
+    return true;
+}
+
+// 코덱에서 나올 수 있는 프레임을 모두 받아 Swr 변환 → 공급
+static void receiveAndFeed(DecodeCursor &cur, AVFrame *frame, std::vector<float> &conv)
+{
+    while (!seekPending(cur))
+    {
+        const int ret = avcodec_receive_frame(gCodecCtx, frame);
+        if (ret < 0)
+        {
+            // EAGAIN / EOF / 오류 모두 이번 패킷은 끝
+            break;
+        }
+
+        // seek 직후 첫 프레임: pts로 소스 위치 확정
+        if (!cur.srcFrameKnown)
+        {
+            const int64_t pts = frame->best_effort_timestamp;
+            if (pts != AV_NOPTS_VALUE)
+            {
+                const double tb = av_q2d(gFmtCtx->streams[gAudioStreamIndex]->time_base);
+                cur.srcFrame = static_cast<int64_t>(std::llround(pts * tb * gSampleRate));
+            }
+            cur.srcFrameKnown = true;
+        }
+
+        if (feedConvertedDirect(cur, frame))
+        {
+            continue;
+        }
+
+        uint8_t *outData[1] = {
+            reinterpret_cast<uint8_t *>(conv.data())};
+
+        const int outSamples = swr_convert(
+            gSwr,
+            outData,
+            static_cast<int>(conv.size() / CHANNELS),
+            const_cast<const uint8_t **>(frame->data),
+            frame->nb_samples);
+
+        if (outSamples > 0)
+        {
+            feedConverted(cur, conv.data(), outSamples);
+        }
+    }
+}
+
+// 스트림 끝 drain
+//  - 코덱(NULL 패킷) → Swr 지연분 → SoundTouch flush 순서로 남은 샘플을 모두 링에 넣고
+//    DRAINING으로 표시 → 링이 비면 콜백이 완료 이벤트를 올린다
+//  - 중간에 seek가 오거나 루프 되감기로 입력이 살아나면 표시하지 않고 그대로 복귀
+static void drainEndOfStream(DecodeCursor &cur, AVFrame *frame, std::vector<float> &conv)
+{
+    if (!cur.pcm)
+    {
+        avcodec_send_packet(gCodecCtx, nullptr);
+        receiveAndFeed(cur, frame, conv);
+
+        uint8_t *outData[1] = {reinterpret_cast<uint8_t *>(conv.data())};
+        int n = 0;
+        while (!seekPending(cur) && cur.srcFrameKnown &&
+               (n = swr_convert(gSwr, outData, static_cast<int>(conv.size() / CHANNELS), nullptr, 0)) > 0)
+        {
+            feedConverted(cur, conv.data(), n);
+        }
+    }
+
+    if (seekPending(cur) || !gDecodeRunning.load() || !cur.srcFrameKnown || cur.loop.replay)
+    {
+        return;
+    }
+
+    // 늦은 스트레치 모드: 소스 링 끝에 표시만 → 워커가 거기까지 넣은 뒤 flush (큐가 가득이면 다음에 재시도)
+    if (cur.late)
+    {
+        RingMarker m;
+        m.endOfStream = true;
+        if (markNextInput(m, cur))
+        {
+            cur.eosDrained = true;
+            gStretchWaker.notify();
+            logLine("Decoder", "end of stream queued for late stretch");
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(gMutex);
+        gST.flush();
+    }
+    drainSoundTouch(cur);
+    if (seekPending(cur) || !gDecodeRunning.load())
+    {
+        return;
+    }
+
+    cur.eosDrained = true;
+    gStreamEnd.store(STREAM_DRAINING);
+    logLine("Decoder", "end of stream drained");
+}
+
+// ─────────────────────────────
+// JitterController — 출력 링 목표량 (gFillTarget) 적응
+//  - 디코더 작업 블록마다 소요 시간을 재서 최근 최대치(서서히 감쇠)를 프레임으로 환산
+//    → 디코더가 깨어나 블록 하나를 만드는 동안 콜백이 소비하는 양 = 최소한 남아 있어야 할 양
+//  - underrun(콜백 카운트)이 보이면 즉시 늘리고, 조용하면 천천히 줄임
+//  - 변경 이력은 FFI로 조회 (원인 + 당시 블록 비용)
+// ─────────────────────────────
+class JitterController
+{
+public:
+    enum Reason : int32_t
+    {
+        UNDERRUN = 1,
+        COST = 2,
+        SHRINK = 3,
+        BOUNDS = 4,
+    };
+
+    struct Change
+    {
+        int64_t timeNs = 0;
+        int32_t target = 0;
+        int32_t reason = 0;
+        int64_t costPeakUs = 0;
+    };
+
+    // FFI: 0 = 기본 (하한 JITTER_MIN_FRAMES, 상한 링 high watermark)
+    void setBounds(int minFrames, int maxFrames)
+    {
+        minReq_.store(std::max(0, minFrames));
+        maxReq_.store(std::max(0, maxFrames));
+    }
+
+    // 디코더 스레드: 작업 블록 1개 (소요 시간, 출력 링에 넣은 프레임)
+    void onBlock(int64_t elapsedNs, int64_t frames)
+    {
+        if (frames > 0)
+        {
+            const int64_t costFrames = elapsedNs * gSampleRate / 1000000000;
+            costPeakFrames_ = std::max(costFrames, costPeakFrames_ - costPeakFrames_ / 256);
+            costPeakNs_ = std::max(elapsedNs, costPeakNs_ - costPeakNs_ / 256);
+        }
+        update();
+    }
+
+    int copyHistory(int64_t *out, int maxEntries)
+    {
+        std::lock_guard<std::mutex> lock(historyMu_);
+        const size_t count = std::min(historyCount_, static_cast<size_t>(std::max(0, maxEntries)));
+        for (size_t i = 0; i < count; ++i)
+        {
+            const Change &c = history_[(historyHead_ + JITTER_HISTORY - count + i) % JITTER_HISTORY];
+            out[i * 4 + 0] = c.timeNs / 1000;
+            out[i * 4 + 1] = c.target;
+            out[i * 4 + 2] = c.reason;
+            out[i * 4 + 3] = c.costPeakUs;
+        }
+        return static_cast<int>(count);
+    }
+
+private:
+    void update()
+    {
+        const int period = std::max(1, gDevicePeriodFrames.load());
+        const int hi = maxReq_.load() > 0 ? std::min(maxReq_.load(), gStable.highWatermark()) : gStable.highWatermark();
+        const int lo = std::min(hi, std::max(minReq_.load() > 0 ? minReq_.load() : JITTER_MIN_FRAMES, period * 2));
+        const int64_t costFloor = (costPeakFrames_ + period) * JITTER_COST_SAFETY;
+        const int floor = static_cast<int>(std::max<int64_t>(lo, std::min<int64_t>(hi, costFloor)));
+        const int target = gFillTarget.load();
+        const int64_t now = steadyNowNs();
+
+        const uint32_t underruns = gUnderrunCount.load(std::memory_order_relaxed);
+        if (underruns != seenUnderruns_)
+        {
+            seenUnderruns_ = underruns;
+            const int grown = std::min(hi, static_cast<int>(target * JITTER_GROW) + period);
+            lastGrowNs_ = now;
+            if (grown > target)
+            {
+                set(grown, UNDERRUN, now);
+                return;
+            }
+        }
+
+        if (target < floor)
+        {
+            lastGrowNs_ = now;
+            set(floor, COST, now);
+        }
+        else if (target > hi || target < lo)
+        {
+            set(std::max(lo, std::min(target, hi)), BOUNDS, now);
+        }
+        else if (target > floor && now - lastGrowNs_ >= static_cast<int64_t>(JITTER_HOLD_MS) * 1000000 &&
+                 now - lastShrinkNs_ >= static_cast<int64_t>(JITTER_SHRINK_STEP_MS) * 1000000)
+        {
+            lastShrinkNs_ = now;
+            set(std::max(floor, static_cast<int>(target * JITTER_SHRINK)), SHRINK, now);
+        }
+    }
+
+    void set(int target, Reason reason, int64_t now)
+    {
+        gFillTarget.store(target);
+        Change c;
+        c.timeNs = now;
+        c.target = target;
+        c.reason = reason;
+        c.costPeakUs = costPeakNs_ / 1000;
+        {
+            std::lock_guard<std::mutex> lock(historyMu_);
+            history_[historyHead_] = c;
+            historyHead_ = (historyHead_ + 1) % JITTER_HISTORY;
+            historyCount_ = std::min(historyCount_ + 1, JITTER_HISTORY);
+        }
+        static const char *const kReason[] = {"", "underrun", "cost", "shrink", "bounds"};
+        std::printf("[Jitter] target %d frames (%.1fms) %s, block cost peak %.2fms\n", target,
+                    target * 1000.0 / gSampleRate, kReason[reason], costPeakNs_ / 1e6);
+    }
+
+    // 디코더 스레드 소유
+    int64_t costPeakFrames_ = 0;
+    int64_t costPeakNs_ = 0;
+    uint32_t seenUnderruns_ = 0;
+    int64_t lastGrowNs_ = 0;
+    int64_t lastShrinkNs_ = 0;
+
+    std::atomic<int> minReq_{0};
+    std::atomic<int> maxReq_{0};
+
+    std::mutex historyMu_;
+    Change history_[JITTER_HISTORY];
+    size_t historyHead_ = 0;
+    size_t historyCount_ = 0;
+};
+
+static JitterController gJitter;
+
+// 디코더 루프 한 바퀴 = 작업 블록 1개 (스코프 끝에서 비용 기록)
+struct JitterBlock
+{
+    explicit JitterBlock(bool enabled)
+        : enabled(enabled), t0(steadyNowNs()), pos0(gStable.writePos()) {}
+
+    ~JitterBlock()
+    {
+        if (enabled)
+        {
+            gJitter.onBlock(steadyNowNs() - t0, static_cast<int64_t>(gStable.writePos() - pos0));
+        }
+    }
+
+    bool enabled;
+    int64_t t0;
+    size_t pos0;
+};
+
+static void decodeThreadFunc()
+{
+    AVPacket *pkt = av_packet_alloc();
+    AVFrame *frame = av_frame_alloc();
+
+    const int MAX_DST_SAMPLES = 4096;
+    std::vector<float> convBuffer(MAX_DST_SAMPLES * CHANNELS);
+
+    // SoundTouch에서 StableBuffer로 옮길 임시 버퍼
+
+    // 루프 캐시 replay 청크 (크로스페이드 적용 후 SoundTouch로)
+    std::vector<float> loopChunk(LOOP_FEED_CHUNK_FRAMES * CHANNELS);
+
+    DecodeCursor cur;
+    cur.seenSeekSeq = gSeekServedSeq.load();
+    cur.pcm = gPcmCache.ready(); // 캐시 적중이면 처음부터 메모리 공급
+    ScrubState scrub;
+
+    while (gDecodeRunning.load())
+    {
+        // seek 명령 처리 (burst면 최신 타겟 하나만 실행됨)
+        double seekMs = 0.0;
+        if (gSeekBox.fetch(cur.seenSeekSeq, seekMs))
+        {
+            if (scrub.active)
+            {
+                // 스크럽 중 seek = playhead 이동 (창은 다음 step에서 다시 맞춤)
+                scrub.playhead = std::max(0.0, seekMs) / 1000.0 * gSampleRate;
+            }
+            else if (gFileOpened.load() && gFmtCtx && gCodecCtx && gAudioStreamIndex >= 0)
+            {
+                executeSeek(seekMs, cur);
+            }
+            gSeekServedSeq.store(cur.seenSeekSeq);
+            gDecoderEvents.push(EV_SEEK_COMPLETE, static_cast<int64_t>(std::llround(seekMs)), steadyNowNs());
+            gEventWaker.notify();
+            continue;
+        }
+
+        // A/B 루프 설정 변경 (구간이 바뀌면 여기서 캐시를 새로 디코드)
+        LoopCommand loopCmd;
+        if (gLoopBox.fetch(cur.seenLoopSeq, loopCmd))
+        {
+            if (gFileOpened.load() && gFmtCtx && gCodecCtx && gAudioStreamIndex >= 0)
+            {
+                loopApply(loopCmd, cur, pkt, frame, convBuffer);
+            }
+            continue;
+        }
+
+        // 스크럽 모드 (FF/RW · 드래그)
+        if (scrubStep(scrub, cur, pkt, frame, convBuffer))
+        {
+            continue;
+        }
+
+        // 늦은 스트레치 모드 전환: 지금 들리는 위치로 seek하면서 파이프라인을 새 구조로 다시 채움
+        if (gLateStretchReq.load() != cur.late)
+        {
+            cur.late = !cur.late;
+            gLateActive.store(cur.late);
+            if (cur.late)
+            {
+                gLateStretch.start();
+            }
+            if (gFileOpened.load() && gFmtCtx && gCodecCtx && gAudioStreamIndex >= 0)
+            {
+                executeSeek(static_cast<double>(audiblePlayheadFrames()) / gSampleRate * 1000.0, cur);
+            }
+            if (!cur.late)
+            {
+                gLateStretch.stop();
+                gSourceRing.clear();
+            }
+            logLine("Decoder", cur.late ? "late stretch on" : "late stretch off");
+            continue;
+        }
+
+        // 파일이 없으면 st_play/seek/close가 깨울 때까지 잠듦
+        if (!gFileOpened.load())
+        {
+            gDecodeWaker.wait(0);
+            continue;
+        }
+
+        // 디코더가 채우는 링 (늦은 스트레치 모드면 소스 링, 출력 링은 워커가 채움)
+        //  - 늦은 스트레치 모드는 seek pre-roll도 워커가 소스에서 걸러내므로 정지 중에도 넉넉히 채움
+        const StableBuffer &feedRing = cur.late ? gSourceRing : gStable;
+        const int pausedFill = cur.late ? feedRing.highWatermark() : warmupFrames();
+
+        // 일시정지 중에는 워밍업 분량만 미리 채워 두고 잠듦 (resume 즉시 출력)
+        if (gPaused.load() && feedRing.size() >= pausedFill)
+        {
+            gDecodeWaker.wait(0);
+            continue;
+        }
+
+        if (!gFmtCtx || !gCodecCtx || !gSwr || gAudioStreamIndex < 0)
+        {
+            gDecodeWaker.wait(0);
+            continue;
+        }
+
+        // 링이 충분히 차 있으면 소비 쪽(콜백/워커)이 low watermark 신호를 줄 때까지 잠듦
+        //  - 일반 모드는 적응 목표량까지만 (늦은 스트레치 소스 링은 용량 기준)
+        const int fillLimit = cur.late ? feedRing.highWatermark() : gFillTarget.load();
+        if (feedRing.size() > fillLimit)
+        {
+            gDecodeWaker.wait(DECODER_SAFETY_WAIT_MS);
+            continue;
+        }
+
+        // 이번 작업 블록의 비용 측정 → 목표량 조절 (일반 모드만)
+        JitterBlock jitterBlock(!cur.late);
+
+        // 루프 구간 반복 중: FFmpeg 대신 구간 캐시에서 공급 (입력은 B 근처에 멈춰 있음)
+        if (cur.loop.replay)
+        {
+            loopReplayStep(cur, loopChunk);
+            continue;
+        }
+
+        // 전체 PCM 캐시가 준비됐으면 현재 소스 위치에서 그대로 갈아탐 (이후 FFmpeg 입력은 안 씀)
+        if (!cur.pcm && cur.srcFrameKnown)
+        {
+            cur.pcm = gPcmCache.ready();
+            if (cur.pcm)
+            {
+                logLine("Decoder", "switched to PCM cache");
+            }
+        }
+
+        if (cur.pcm)
+        {
+            const int64_t start = std::max(cur.srcFrame, cur.dropSrcUntil);
+            if (start >= cur.pcm->frames())
+            {
+                // EOF: 꼬리까지 흘려보낸 뒤 seek/close가 깨울 때까지 잠듦
+                if (!cur.eosDrained)
+                {
+                    drainEndOfStream(cur, frame, convBuffer);
+                    continue;
+                }
+                gDecodeWaker.wait(0);
+                continue;
+            }
+            const int n = static_cast<int>(std::min<int64_t>(MAX_DST_SAMPLES, cur.pcm->frames() - start));
+            cur.srcFrame = start + n;
+            feedLive(cur.pcm->at(start), start, n, cur);
+            continue;
+        }
+
+        int ret = av_read_frame(gFmtCtx, pkt);
+        if (ret < 0)
+        {
+            // EOF 등: 꼬리까지 흘려보낸 뒤 seek/close가 깨울 때까지 잠듦
+            if (!cur.eosDrained)
+            {
+                drainEndOfStream(cur, frame, convBuffer);
+                continue;
+            }
+            gDecodeWaker.wait(0);
+            continue;
+        }
+
+        if (pkt->stream_index != gAudioStreamIndex)
+        {
+            av_packet_unref(pkt);
+            continue;
+        }
+
+        ret = avcodec_send_packet(gCodecCtx, pkt);
+        av_packet_unref(pkt);
+        if (ret < 0)
+        {
+            continue;
+        }
+
+        receiveAndFeed(cur, frame, convBuffer);
+    }
+
+    // 파일 단위 렌더는 더 이상 쓸 일이 없음
+    gLoopRender.reset();
+
+    // 늦은 스트레치 워커도 파일과 함께 정리 (다음 디코더가 요청을 보고 다시 시작)
+    gLateStretch.stop();
+    gLateActive.store(false);
+    gSourceRing.clear();
+    gStretchBypassed.store(false);
+
+    av_frame_free(&frame);
+    av_packet_free(&pkt);
+}
+
+// miniaudio 콜백
+//  - MAOutputGuard: 워밍업 필요 시 StableBuffer가 충분히 찰 때까지 무음 출력
+//  - StableBuffer.pop() → 실제 출력
+//  - underflow 시 SoT 증가 없이 무음 출력
+// 콜백 1회 실행 시간을 재서 worst-case만 기록 (모든 return 경로 공통)
+struct CallbackTimer
+{
+    explicit CallbackTimer(ma_uint32 frameCount) : frames(frameCount) {}
+
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    ma_uint32 frames;
+
+    ~CallbackTimer()
+    {
+        const uint64_t ns = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - t0)
+                .count());
+
+        uint64_t prev = gCbMaxNs.load(std::memory_order_relaxed);
+        while (ns > prev && !gCbMaxNs.compare_exchange_weak(prev, ns, std::memory_order_relaxed))
+        {
+        }
+        gCbCount.fetch_add(1, std::memory_order_relaxed);
+
+        // period 대비 실행 시간 (‰) — 거버너의 콜백 부하
+        if (frames > 0)
+        {
+            const int load = static_cast<int>(ns * static_cast<uint64_t>(gSampleRate) / (frames * 1000000ULL));
+            int prevLoad = gCbLoadPeak.load(std::memory_order_relaxed);
+            while (load > prevLoad && !gCbLoadPeak.compare_exchange_weak(prevLoad, load, std::memory_order_relaxed))
+            {
+            }
+        }
+    }
+};
+
+// 콜백 출력 기록 → 지금 들리는 소스 위치 (콜백 스레드 전용)
+//  - 블록마다 (누적 출력 프레임, 블록 끝 SoT)를 남기고
+//    출력 장치 지연만큼 앞선 시점의 SoT를 선형 보간
+//  - 루프 wrap처럼 소스가 튄 블록은 보간하지 않고 직전 값 유지
+class PlayheadHistory
+{
+public:
+    void reset(double src)
+    {
+        head_ = 0;
+        count_ = 0;
+        append(0, src);
+    }
+
+    void append(uint32_t frames, double src)
+    {
+        outTotal_ += frames;
+        if (count_ == CAP)
+        {
+            head_ = (head_ + 1) % CAP;
+            --count_;
+        }
+        const int i = (head_ + count_) % CAP;
+        out_[i] = outTotal_;
+        src_[i] = src;
+        ++count_;
+    }
+
+    double at(int64_t lagFrames) const
+    {
+        const int64_t target = static_cast<int64_t>(outTotal_) - std::max<int64_t>(0, lagFrames);
+        for (int k = count_ - 1; k >= 0; --k)
+        {
+            const int i = (head_ + k) % CAP;
+            if (static_cast<int64_t>(out_[i]) > target)
+            {
+                continue;
+            }
+            if (k == count_ - 1)
+            {
+                return src_[i];
+            }
+
+            const int j = (head_ + k + 1) % CAP;
+            const double span = static_cast<double>(out_[j] - out_[i]);
+            const double ds = src_[j] - src_[i];
+            if (span <= 0.0 || ds < 0.0 || ds > span * MAX_RATE)
+            {
+                return src_[i];
+            }
+            return src_[i] + ds * (static_cast<double>(target - static_cast<int64_t>(out_[i])) / span);
+        }
+        return count_ > 0 ? src_[head_] : 0.0;
+    }
+
+private:
+    static constexpr int CAP = 64;
+    static constexpr double MAX_RATE = 4.0; // 이보다 빠르게 전진하면 불연속으로 본다
+    uint64_t out_[CAP] = {};
+    double src_[CAP] = {};
+    int head_ = 0;
+    int count_ = 0;
+    uint64_t outTotal_ = 0;
+};
+
+// 콜백의 SoT 진행 (콜백 스레드 전용)
+//  - 출력 프레임 × rate(소스/출력)로 전진, 소수점 이하는 carry로 넘김
+//  - 외부 대입(gPlayheadSeq 변경)을 보면 carry/기록을 버리고 그 위치에서 다시 시작
+class PlayheadClock
+{
+public:
+    void begin()
+    {
+        const uint64_t seq = gPlayheadSeq.load(std::memory_order_acquire);
+        if (seq != seq_)
+        {
+            seq_ = seq;
+            carry_ = 0.0;
+            history_.reset(static_cast<double>(gProcessedSamples.load()));
+        }
+    }
+
+    void advance(size_t frames)
+    {
+        carry_ += static_cast<double>(frames) * rate_;
+        const double whole = std::floor(carry_);
+        carry_ -= whole;
+        gProcessedSamples.fetch_add(static_cast<uint64_t>(whole));
+    }
+
+    // ringLate: 마커 위치를 이미 지나 출력한 프레임 수
+    void anchor(int64_t srcFrame, size_t ringLate)
+    {
+        carry_ = 0.0;
+        gProcessedSamples.store(static_cast<uint64_t>(
+            srcFrame + std::llround(static_cast<double>(ringLate) * rate_)));
+    }
+
+    void setRate(double rate)
+    {
+        rate_ = rate;
+    }
+
+    void end(uint32_t frames)
+    {
+        history_.append(frames, static_cast<double>(gProcessedSamples.load()) + carry_);
+        const double audible = history_.at(gDeviceLatencyFrames.load(std::memory_order_relaxed));
+        gAudibleSamples.store(static_cast<uint64_t>(std::llround(std::max(0.0, audible))),
+                              std::memory_order_release);
+        gAudibleSeq.store(seq_, std::memory_order_release);
+    }
+
+private:
+    PlayheadHistory history_;
+    uint64_t seq_ = UINT64_MAX;
+    double carry_ = 0.0;
+    double rate_ = 1.0;
+};
+
+static PlayheadClock gPlayheadClock;
+
+// 콜백 1회 = 출력 블록 1개 (무음 포함) → 모든 return 경로에서 기록
+struct PlayheadBlock
+{
+    ma_uint32 frames;
+
+    explicit PlayheadBlock(ma_uint32 n) : frames(n)
+    {
+        gPlayheadClock.begin();
+    }
+
+    ~PlayheadBlock()
+    {
+        gPlayheadClock.end(frames);
+    }
+};
+
+static void data_callback(ma_device * /*pDevice*/, void *pOutput, const void * /*pInput*/, ma_uint32 frameCount)
+{
+    CallbackTimer cbTimer(frameCount);
+    PlayheadBlock playhead(frameCount);
+    float *out = static_cast<float *>(pOutput);
+
+    // 휴면 해제 후 첫 콜백 → wake 지연 기록
+    int64_t wakeStart = gWakeStartNs.load(std::memory_order_relaxed);
+    if (wakeStart != 0 && gWakeStartNs.compare_exchange_strong(wakeStart, 0))
+    {
+        gLastWakeLatencyNs.store(steadyNowNs() - wakeStart, std::memory_order_relaxed);
+    }
+
+    // 정지 상태 / 파일 미열림 / seek 실행 대기 중에는 항상 무음 + SoT 증가 없음
+    //  - seek 진행 중 링에 남은 옛 위치의 샘플이 새어 나가지 않도록
+    //  - 스크럽은 정지 상태에서도 들린다 (드래그 미리듣기)
+    const bool scrubbing = gScrubActive.load(std::memory_order_acquire);
+    if ((gPaused.load() && !scrubbing) || !gFileOpened.load() ||
+        gSeekServedSeq.load(std::memory_order_acquire) != gSeekBox.latest())
+    {
+        std::memset(out, 0, frameCount * CHANNELS * sizeof(float));
+        gLastSnapshot.publishSilence();
+        return;
+    }
+
+    // MAOutputGuard: 새 파일/seek 직후 워밍업
+    if (gWarmupNeeded.load())
+    {
+        int buffered = gStable.size();
+        if (buffered < warmupFrames())
+        {
+            // 아직 충분히 버퍼가 쌓이지 않았으므로 무음 출력 + SoT 증가 없음
+            std::memset(out, 0, frameCount * CHANNELS * sizeof(float));
+            gLastSnapshot.publishSilence();
+            return;
+        }
+        else
+        {
+            // 충분히 버퍼가 쌓였으면 Guard 해제 후 정상 재생
+            gWarmupNeeded.store(false);
+        }
+    }
+
+    // StableBuffer에서 샘플 꺼내기
+    int received = gStable.pop(out, static_cast<int>(frameCount));
+
+    // low watermark 아래로 내려가면 잠든 디코더를 깨움 (lock 없음)
+    //  - 스트림 끝까지 다 넣은 뒤에는 깨울 이유가 없음
+    //  - 늦은 스트레치 모드: 목표량 아래면 워커를 깨움 (디코더는 워커가 깨움)
+    const int streamEnd = gStreamEnd.load(std::memory_order_acquire);
+    if (gLateActive.load(std::memory_order_relaxed))
+    {
+        if (streamEnd == STREAM_PLAYING && gStable.size() < gStretchTarget.load(std::memory_order_relaxed))
+        {
+            gStretchWaker.notifyFromAudio();
+        }
+    }
+    else if (streamEnd == STREAM_PLAYING && gStable.size() < gFillTarget.load(std::memory_order_relaxed) * 2 / 3)
+    {
+        gDecodeWaker.notifyFromAudio();
+    }
+
+    // 꼬리까지 다 나갔으면 완료 이벤트 (1회)
+    if (streamEnd == STREAM_DRAINING && !scrubbing && gStable.size() == 0)
+    {
+        int expected = STREAM_DRAINING;
+        if (gStreamEnd.compare_exchange_strong(expected, STREAM_ENDED))
+        {
+            gEndOfStreamEvent.store(true);
+            gAudioEvents.push(EV_END_OF_STREAM, 0, steadyNowNs());
+            gEventWaker.notifyFromAudio();
+        }
+    }
+
+    // underrun: 재생 중인데 링이 모자람 → 시작 시점에 1회만 알림
+    static bool sUnderrun = false; // 콜백 스레드 전용
+    const bool shortBlock = received < static_cast<int>(frameCount) && streamEnd == STREAM_PLAYING;
+    if (shortBlock && !sUnderrun)
+    {
+        gUnderrunCount.fetch_add(1, std::memory_order_relaxed);
+        gAudioEvents.push(EV_UNDERRUN, static_cast<int64_t>(frameCount) - std::max(received, 0), steadyNowNs());
+        gEventWaker.notifyFromAudio();
+    }
+    sUnderrun = shortBlock;
+
+    // underflow → SoT 증가 없이 무음 출력
+    if (received <= 0)
+    {
+        std::memset(out, 0, frameCount * CHANNELS * sizeof(float));
+        gLastSnapshot.publishSilence();
+        return;
+    }
+
+    // 최근 출력 버퍼 publish (lock 없음)
+    //  - seek/close 직후 초기화 요청이 남아 있으면 이번 블록은 무음으로 대체
+    if (gLastSnapshot.clearPending())
+    {
+        gLastSnapshot.publishSilence();
+    }
+    else
+    {
+        gLastSnapshot.publish(out, received);
+    }
+
+    // 볼륨 적용 (유효 샘플에만)
+    const float vol = gVolume.load();
+    int totalValidSamples = received * CHANNELS;
+    for (int i = 0; i < totalValidSamples; ++i)
+    {
+        out[i] *= vol;
+    }
+
+    // 부족분 무음 패딩 (SoT에는 포함 안 됨)
+    if (received < static_cast<int>(frameCount))
+    {
+        int padStart = received * CHANNELS;
+        int padSamples = static_cast<int>(frameCount) * CHANNELS - padStart;
+        std::memset(out + padStart, 0, padSamples * sizeof(float));
+    }
+
+    // SoT: 실제 출력된 유효 프레임만 소스 타임라인으로 환산해 누적
+    //  - 링 위치 마커 (tempo 비율 / 루프 wrap): 블록 안의 해당 위치에서 나눠 적용
+    //  - 스크럽 중에는 디코더가 playhead를 직접 기록
+    if (!scrubbing)
+    {
+        const size_t readEnd = gStable.readPos();
+        size_t pos = readEnd - static_cast<size_t>(received);
+        gRingMarkers.consumeUpTo(
+            readEnd, gStable.epoch(),
+            [&pos](const RingMarker &m, size_t /*readEnd*/)
+            {
+                if (m.ringPos > pos)
+                {
+                    gPlayheadClock.advance(m.ringPos - pos);
+                    pos = m.ringPos;
+                }
+                if (m.rate > 0.0)
+                {
+                    gPlayheadClock.setRate(m.rate);
+                }
+                if (m.srcFrame >= 0)
+                {
+                    gPlayheadClock.anchor(m.srcFrame, pos - m.ringPos);
+                }
+                if (m.loopEvent)
+                {
+                    gLoopRemaining.store(m.loopRemaining, std::memory_order_relaxed);
+                    gAudioEvents.push(EV_LOOP_WRAP, m.loopRemaining, steadyNowNs());
+                    gEventWaker.notifyFromAudio();
+                }
+            });
+        gPlayheadClock.advance(readEnd - pos);
+    }
+
+    // seek(또는 seek 후 play) → 첫 오디오 출력 latency 기록
+    int64_t seekStart = gSeekStartNs.load(std::memory_order_relaxed);
+    if (seekStart != 0)
+    {
+        const int64_t startedAt = seekStart;
+        if (gSeekStartNs.compare_exchange_strong(seekStart, 0))
+        {
+            gLastSeekLatencyNs.store(steadyNowNs() - startedAt, std::memory_order_relaxed);
+        }
+    }
+}
+
+// 출력 장치 지연 = miniaudio 내부 버퍼 (period × periods) + 포맷 변환기 지연
+//  - 장치 레이트 기준 값을 엔진 레이트 프레임으로 환산 (보통 같은 레이트)
+static void updateDeviceLatency()
+{
+    const double deviceRate = gDevice.playback.internalSampleRate > 0
+                                  ? static_cast<double>(gDevice.playback.internalSampleRate)
+                                  : static_cast<double>(gSampleRate);
+    const double buffered = static_cast<double>(gDevice.playback.internalPeriodSizeInFrames) *
+                            static_cast<double>(std::max<ma_uint32>(1, gDevice.playback.internalPeriods));
+    const double converter = static_cast<double>(ma_data_converter_get_output_latency(&gDevice.playback.converter));
+    const int frames = static_cast<int>(std::llround((buffered + converter) * gSampleRate / deviceRate));
+    gDeviceLatencyFrames.store(frames);
+    gDevicePeriodFrames.store(static_cast<int>(std::llround(
+        static_cast<double>(gDevice.playback.internalPeriodSizeInFrames) * gSampleRate / deviceRate)));
+    std::printf("[AudioChain] output latency %d frames (%.1fms)\n", frames, frames * 1000.0 / gSampleRate);
+}
+
+// miniaudio 디바이스 알림 (출력 장치 변경 / 인터럽션 등, miniaudio 내부 스레드)
+static void device_notification(const ma_device_notification *n)
+{
+    if (n->type == ma_device_notification_type_started || n->type == ma_device_notification_type_stopped)
+    {
+        return; // 우리가 직접 시작/정지한 것
+    }
+    if (n->type == ma_device_notification_type_rerouted)
+    {
+        updateDeviceLatency();
+    }
+    gDeviceChangeType.store(static_cast<int>(n->type));
+    gEventWaker.notify();
+}
+
+// ─────────────────────────────
+// 이벤트 알림 스레드 (non-RT)
+//  - 콜백/디코더 큐와 디바이스 알림을 모아 Dart SendPort로 전달
+//  - 메시지: [kind, value, timestampUs] (int64 배열, steady clock)
+//  - 재생 중에는 gPositionTickHz 주기로 위치 tick, 정지 상태가 되면 마지막 위치 1회 후 잠듦
+// ─────────────────────────────
+static void postEngineEvent(Dart_PostCObjectFn post, Dart_Port port, const EngineEvent &e)
+{
+    Dart_CObject kind;
+    kind.type = Dart_CObject_kInt64;
+    kind.value.as_int64 = e.kind;
+    Dart_CObject value;
+    value.type = Dart_CObject_kInt64;
+    value.value.as_int64 = e.value;
+    Dart_CObject time;
+    time.type = Dart_CObject_kInt64;
+    time.value.as_int64 = e.timeNs / 1000;
+
+    Dart_CObject *items[3] = {&kind, &value, &time};
+    Dart_CObject msg;
+    msg.type = Dart_CObject_kArray;
+    msg.value.as_array.length = 3;
+    msg.value.as_array.values = items;
+    post(port, &msg);
+}
+
+static void eventThreadFunc(Dart_PostCObjectFn post, Dart_Port port)
+{
+    bool wasTicking = false;
+    int64_t lastTickNs = 0;
+
+    while (gEventRunning.load())
     {
-        int buffered = gStable.size();
-        if (buffered < GUARD_MIN_FRAMES)
+        EngineEvent e;
+        while (gDecoderEvents.pop(e))
         {
-            // 아직 충분히 버퍼가 쌓이지 않았으므로 무음 출력 + SoT 증가 없음
-            std::memset(out, 0, frameCount * CHANNELS * sizeof(float));
-            {
-                std::lock_guard<std::mutex> lock(gMutex);
-                std::fill(gLastBuffer.begin(), gLastBuffer.end(), 0.0f);
-            }
-            return;
+            postEngineEvent(post, port, e);
         }
-        else
+        while (gAudioEvents.pop(e))
         {
-            // 충분히 버퍼가 쌓였으면 Guard 해제 후 정상 재생
-            gWarmupNeeded.store(false);
+            postEngineEvent(post, port, e);
         }
-    }
-
-    // StableBuffer에서 샘플 꺼내기
-    int received = gStable.pop(out, static_cast<int>(frameCount));
 
-    // underflow → SoT 증가 없이 무음 출력
-    if (received <= 0)
-    {
-        std::memset(out, 0, frameCount * CHANNELS * sizeof(float));
+        const int deviceChange = gDeviceChangeType.exchange(-1);
+        if (deviceChange >= 0)
         {
-            std::lock_guard<std::mutex> lock(gMutex);
-            std::fill(gLastBuffer.begin(), gLastBuffer.end(), 0.0f);
+            postEngineEvent(post, port, EngineEvent{EV_DEVICE_CHANGE, deviceChange, steadyNowNs()});
+        }
+        const int idleEvent = gDeviceIdleEvent.exchange(-1);
+        if (idleEvent >= 0)
+        {
+            postEngineEvent(post, port, EngineEvent{EV_DEVICE_IDLE, idleEvent, steadyNowNs()});
         }
-        return;
-    }
-
-    // 최근 출력 버퍼 업데이트
-    {
-        std::lock_guard<std::mutex> lock(gMutex);
-
-        int copyFrames = std::min<int>(received, BUF_FRAMES);
-        std::memcpy(
-            gLastBuffer.data(),
-            out,
-            copyFrames * CHANNELS * sizeof(float));
 
-        if (copyFrames < BUF_FRAMES)
+        const int hz = gPositionTickHz.load();
+        const bool ticking = hz > 0 && gFileOpened.load() && (!gPaused.load() || gScrubActive.load());
+        const int64_t periodNs = hz > 0 ? 1000000000LL / hz : 0;
+        const int64_t now = steadyNowNs();
+        if ((ticking && now - lastTickNs >= periodNs) || (wasTicking && !ticking))
         {
-            std::memset(
-                gLastBuffer.data() + copyFrames * CHANNELS,
-                0,
-                (BUF_FRAMES - copyFrames) * CHANNELS * sizeof(float));
+            const int64_t ms = static_cast<int64_t>(
+                std::llround(static_cast<double>(audiblePlayheadFrames()) / gSampleRate * 1000.0));
+            postEngineEvent(post, port, EngineEvent{EV_POSITION, ms, now});
+            lastTickNs = now;
         }
-    }
+        wasTicking = ticking;
 
-    // 볼륨 적용 (유효 샘플에만)
-    const float vol = gVolume.load();
-    int totalValidSamples = received * CHANNELS;
-    for (int i = 0; i < totalValidSamples; ++i)
-    {
-        out[i] *= vol;
+        gEventWaker.wait(ticking ? static_cast<int>(std::max<int64_t>(1, (lastTickNs + periodNs - steadyNowNs()) / 1000000)) : 0);
     }
+}
 
-    // 부족분 무음 패딩 (SoT에는 포함 안 됨)
-    if (received < static_cast<int>(frameCount))
+static void stopEventThread()
+{
+    gEventRunning.store(false);
+    gEventWaker.notify();
+    if (gEventThread.joinable())
     {
-        int padStart = received * CHANNELS;
-        int padSamples = static_cast<int>(frameCount) * CHANNELS - padStart;
-        std::memset(out + padStart, 0, padSamples * sizeof(float));
+        gEventThread.join();
     }
-
-    // SoT: 실제 출력된 유효 프레임만 누적
-    gProcessedSamples += static_cast<uint64_t>(received);
 }
 
 // miniaudio 초기화
@@ -774,8 +4838,13 @@ static bool initAudioDevice()
     ma_device_config config = ma_device_config_init(ma_device_type_playback);
     config.playback.format = ma_format_f32;
     config.playback.channels = CHANNELS;
-    config.sampleRate = SAMPLE_RATE;
+    config.sampleRate = 0; // 장치 네이티브 레이트 → 변환기에서 리샘플링 없음
+    config.periodSizeInFrames = static_cast<ma_uint32>(std::max(0, gEngineConfig.periodFrames));
+    config.periods = static_cast<ma_uint32>(std::max(0, gEngineConfig.periods));
+    config.performanceProfile = gEngineConfig.lowLatency ? ma_performance_profile_low_latency
+                                                         : ma_performance_profile_conservative;
     config.dataCallback = data_callback;
+    config.notificationCallback = device_notification;
     config.pUserData = nullptr;
 
     if (ma_device_init(nullptr, &config, &gDevice) != MA_SUCCESS)
@@ -784,78 +4853,181 @@ static bool initAudioDevice()
         return false;
     }
 
-    logLine("AudioChain", "device ready (44100Hz/2ch)");
+    gSampleRate = gDevice.sampleRate > 0 ? static_cast<int>(gDevice.sampleRate) : DEFAULT_SAMPLE_RATE;
+    std::printf("[AudioChain] device ready (%dHz/2ch)\n", gSampleRate);
+    updateDeviceLatency();
     return true;
 }
 
-// 내부 seek
-//  - FFmpeg/Codec/Swr/SoundTouch/StableBuffer/SoT/gWarmupNeeded를
-//    한 번에 초기화하여 Step3C-04 정합성 보장
-static void seekInternal(double ms)
+// 장치 협상 결과로 링/워밍업 확정 (콜백·디코더 시작 전)
+//  - 링은 장치 버퍼의 4배 이상 (한 번에 여러 period를 당겨가도 underrun 없이)
+//  - 워밍업은 high watermark 이하 (정지 중 프리필이 back-pressure에 막히지 않게)
+static void applyEngineConfig()
 {
-    if (!gFileOpened.load() || !gFmtCtx || !gCodecCtx || gAudioStreamIndex < 0)
-    {
-        logLine("FFmpeg", "seekInternal: no file");
-        return;
-    }
+    EngineConfig &a = gEngineActual;
+    a = gEngineConfig;
+    a.periodFrames = static_cast<int>(gDevice.playback.internalPeriodSizeInFrames);
+    a.periods = static_cast<int>(gDevice.playback.internalPeriods);
+
+    const int deviceBuffer = gDeviceLatencyFrames.load();
+    a.ringFrames = std::max({a.ringFrames, STABLE_CAP_MIN_FRAMES, deviceBuffer * 4});
+    a.ringFrames = std::min(a.ringFrames, STABLE_CAP_MAX_FRAMES);
+    gStable.reallocate(a.ringFrames);
+    gSourceRing.reallocate(a.ringFrames);
+    a.ringFrames = gStable.capacity();
+
+    gFillTarget.store(gStable.highWatermark()); // 여유가 확인되면 JitterController가 줄임
+
+    const int maxWarmupMs = static_cast<int>(static_cast<int64_t>(gStable.highWatermark()) * 1000 / gSampleRate);
+    a.warmupMs = std::max(1, std::min(a.warmupMs, maxWarmupMs));
+
+    std::printf("[AudioChain] profile period=%d x%d (%s) ring=%d warmup=%dms\n",
+                a.periodFrames, a.periods, a.lowLatency ? "low-latency" : "conservative",
+                a.ringFrames, a.warmupMs);
+}
 
-    logLine("FFmpeg", "seekInternal called");
+// ─────────────────────────────
+// IdleMonitor — 정지 중 장치 휴면
+//  - 정지(스크럽 아님) 상태가 gIdleStopMs 이상 이어지면 ma_device_stop → 콜백이 더 이상 불리지 않음
+//  - 디코더/워커/알림 스레드는 정지 중 이미 무기한 대기 → 장치만 세우면 엔진 전체가 잠든다
+//  - StableBuffer / SoundTouch / 재생 위치는 그대로 → 재개는 ma_device_start 한 번 (wakeAudioDevice)
+// ─────────────────────────────
+static DecoderWaker gIdleWaker;
 
-    bool wasPaused = gPaused.load();
-    gPaused.store(true);
+// 사용자 요청이 있을 때마다 (재생/정지/스크럽) 휴면 타이머 재시작
+static void markEngineActive()
+{
+    gLastActiveNs.store(steadyNowNs());
+    gIdleWaker.notify();
+}
 
-    // 디코더 스레드 잠시 중단
-    gDecodeRunning.store(false);
-    if (gDecodeThread.joinable())
+// FFI 스레드: 휴면 중이면 장치 재시작 (링 내용 그대로 → 첫 콜백부터 바로 출력)
+static void wakeAudioDevice()
+{
     {
-        if (std::this_thread::get_id() == gDecodeThread.get_id())
+        std::lock_guard<std::mutex> lock(gDeviceStateMutex);
+        gLastActiveNs.store(steadyNowNs());
+        if (gDeviceIdle.load())
         {
-            // 이론상 같은 스레드에서 호출되진 않지만, 안전장치
+            gWakeStartNs.store(steadyNowNs());
+            if (ma_device_start(&gDevice) != MA_SUCCESS)
+            {
+                gWakeStartNs.store(0);
+                logLine("Idle", "device restart failed");
+                return;
+            }
+            gDeviceIdle.store(false);
+            gDeviceIdleEvent.store(0);
+            gEventWaker.notify();
+            logLine("Idle", "device resumed");
         }
-        else
+    }
+    gIdleWaker.notify();
+}
+
+class IdleMonitor
+{
+public:
+    ~IdleMonitor()
+    {
+        stop();
+    }
+
+    void start()
+    {
+        if (thread_.joinable())
         {
-            gDecodeThread.join();
+            return;
         }
+        running_.store(true);
+        markEngineActive();
+        thread_ = std::thread([this]()
+                              { run(); });
     }
 
-    AVStream *st = gFmtCtx->streams[gAudioStreamIndex];
-    double sec = ms / 1000.0;
-    int64_t ts = static_cast<int64_t>(sec / av_q2d(st->time_base));
+    void stop()
+    {
+        running_.store(false);
+        gIdleWaker.notify();
+        if (thread_.joinable())
+        {
+            thread_.join();
+        }
+    }
 
-    if (av_seek_frame(gFmtCtx, gAudioStreamIndex, ts, AVSEEK_FLAG_BACKWARD) < 0)
+private:
+    static bool idleEligible()
     {
-        logLine("FFmpeg", "av_seek_frame failed");
+        return gPaused.load() && gScrubMode.load() == SCRUB_OFF && !gScrubActive.load();
     }
 
-    avcodec_flush_buffers(gCodecCtx);
-    if (gSwr)
+    void run()
     {
-        swr_convert(gSwr, nullptr, 0, nullptr, 0);
+        while (running_.load())
+        {
+            const int idleMs = gIdleStopMs.load();
+            int waitMs = 0; // 휴면 중 / 재생 중 / 정책 꺼짐 → 요청이 올 때까지 잠듦
+            if (idleMs > 0 && !gDeviceIdle.load() && idleEligible())
+            {
+                const int64_t leftNs = gLastActiveNs.load() + static_cast<int64_t>(idleMs) * 1000000 - steadyNowNs();
+                if (leftNs <= 0)
+                {
+                    enterIdle(idleMs);
+                    continue;
+                }
+                waitMs = static_cast<int>(std::max<int64_t>(1, leftNs / 1000000));
+            }
+            gIdleWaker.wait(waitMs);
+        }
     }
 
+    // 타이머가 지나는 사이 st_play가 끼어들 수 있으므로 lock 안에서 다시 확인
+    static void enterIdle(int idleMs)
     {
-        std::lock_guard<std::mutex> lock(gMutex);
-        gST.clear();
-        gST.flush();
-        std::fill(gLastBuffer.begin(), gLastBuffer.end(), 0.0f);
-        // tempo/pitch 설정은 유지. 파라미터는 그대로.
+        std::lock_guard<std::mutex> lock(gDeviceStateMutex);
+        if (gDeviceIdle.load() || !idleEligible() ||
+            steadyNowNs() - gLastActiveNs.load() < static_cast<int64_t>(idleMs) * 1000000)
+        {
+            return;
+        }
+        if (ma_device_stop(&gDevice) != MA_SUCCESS)
+        {
+            logLine("Idle", "device stop failed");
+            gLastActiveNs.store(steadyNowNs()); // 다음 주기에 다시 시도
+            return;
+        }
+        gDeviceIdle.store(true);
+        gDeviceIdleEvent.store(1);
+        gEventWaker.notify();
+        std::printf("[Idle] device stopped after %dms paused\n", idleMs);
     }
 
-    gStable.clear();
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+};
 
-    // SoT를 타겟 위치로 재설정
-    uint64_t targetSamples = static_cast<uint64_t>((ms / 1000.0) * SAMPLE_RATE);
-    gProcessedSamples.store(targetSamples);
+static IdleMonitor gIdleMonitor;
 
-    // Seek 이후에는 다시 워밍업 필요
-    gWarmupNeeded.store(true);
+// 내부 seek
+//  - SeekMailbox에 타겟만 올리고 디코더 스레드를 깨운다 (join/재생성 없음)
+//  - 실제 FFmpeg/Codec/Swr/SoundTouch/StableBuffer/SoT 정합은
+//    디코더 스레드의 executeSeek()가 한 번에 수행 (Step3C-04 정합성 유지)
+//  - 콜백은 seek가 실행될 때까지 무음 → 옛 위치 샘플이 새어 나가지 않음
+static void seekInternal(double ms)
+{
+    if (!gFileOpened.load() || !gDecodeThread.joinable())
+    {
+        logLine("FFmpeg", "seekInternal: no file");
+        return;
+    }
 
-    // 디코더 다시 시작
-    gDecodeRunning.store(true);
-    gDecodeThread = std::thread(decodeThreadFunc);
+    // UI가 바로 읽는 위치는 즉시 타겟으로 (디코더가 실행 시 다시 확정)
+    const double targetMs = std::max(0.0, ms);
+    setPlayheadFrames(static_cast<uint64_t>(std::llround(targetMs / 1000.0 * gSampleRate)));
 
-    // 원래 재생/일시정지 상태 복원
-    gPaused.store(wasPaused);
+    gSeekStartNs.store(steadyNowNs());
+    gSeekBox.post(targetMs);
+    gDecodeWaker.notify();
 }
 
 // ─────────────────────────────
@@ -873,14 +5045,16 @@ extern "C"
 
         logLine("FFI", "st_create called");
 
-        initSoundTouch();
-
+        // 장치 레이트를 먼저 정해야 SoundTouch/디코더가 그 레이트로 설정됨
         if (!initAudioDevice())
         {
             logLine("FFI", "audio device init failed");
             return;
         }
 
+        applyEngineConfig();
+        initSoundTouch();
+
         if (ma_device_start(&gDevice) == MA_SUCCESS)
         {
             gDeviceStarted.store(true);
@@ -889,6 +5063,8 @@ extern "C"
 
             gPaused.store(true);
             gWarmupNeeded.store(false);
+            gDeviceIdle.store(false);
+            gIdleMonitor.start();
 
             logLine("FFI", "playback device started");
         }
@@ -908,6 +5084,9 @@ extern "C"
         logLine("FFI", "st_dispose called");
 
         closeFileInternal();
+        gLoopRender.stop();
+        gIdleMonitor.stop();
+        stopEventThread();
 
         if (gDeviceStarted.load())
         {
@@ -919,11 +5098,11 @@ extern "C"
             std::lock_guard<std::mutex> lock(gMutex);
             gST.clear();
             gST.flush();
-            std::fill(gLastBuffer.begin(), gLastBuffer.end(), 0.0f);
         }
 
+        gLastSnapshot.resetUnsafe(); // 디바이스 해제 후 → writer 없음
         gStable.clear();
-        gProcessedSamples.store(0);
+        setPlayheadFrames(0);
         gWarmupNeeded.store(false);
 
         gRunning.store(false);
@@ -933,7 +5112,10 @@ extern "C"
         logLine("FFI", "disposed");
     }
 
-    bool st_openFile(const char *path)
+    // 전체 PCM 캐시와 함께 열기
+    //  - cachePath: 캐시 파일 경로 (미디어 해시 기반, 있으면 재사용 / 없으면 백그라운드 생성)
+    //  - 긴 파일이나 nullptr이면 st_openFile과 동일 (스트리밍 디코드)
+    bool st_openFileCached(const char *path, const char *cachePath)
     {
         if (!gEngineCreated.load())
         {
@@ -947,7 +5129,7 @@ extern "C"
             return false;
         }
 
-        if (!openFileInternal(path))
+        if (!openFileInternal(path, cachePath))
         {
             logLine("FFI", "st_openFile: open failed");
             return false;
@@ -963,26 +5145,45 @@ extern "C"
         return true;
     }
 
+    bool st_openFile(const char *path)
+    {
+        return st_openFileCached(path, nullptr);
+    }
+
+    // 마지막 seek → 첫 오디오 출력까지 걸린 시간 (ms, 측정값 없으면 -1)
+    double st_getLastSeekLatencyMs()
+    {
+        const int64_t ns = gLastSeekLatencyNs.load();
+        return ns < 0 ? -1.0 : static_cast<double>(ns) / 1.0e6;
+    }
+
+    // 디코더가 최신 타겟만 실행하느라 건너뛴 seek 명령 수
+    int64_t st_getSeeksCoalesced()
+    {
+        return static_cast<int64_t>(gSeekBox.coalesced());
+    }
+
+    // 디코더 스레드가 잠에서 깨어난 누적 횟수 (idle wakeup 검증용)
+    int64_t st_getDecoderWakeups()
+    {
+        return static_cast<int64_t>(gDecodeWaker.wakeups());
+    }
+
     void st_close()
     {
         logLine("FFI", "st_close called");
         closeFileInternal();
     }
 
+    // tempo / pitch: 목표값만 우편함에 (적용은 디코더가 다음 처리 블록부터 램프)
     void st_set_tempo(float t)
     {
-        std::lock_guard<std::mutex> lock(gMutex);
-        gTempo.store(t);
-        applySoundTouchParams_unsafe();
-        std::printf("[ST] tempo=%.3f\n", t);
+        gParamBox.setTempo(t);
     }
 
     void st_set_pitch_semitones(float semi)
     {
-        std::lock_guard<std::mutex> lock(gMutex);
-        gPitch.store(semi);
-        applySoundTouchParams_unsafe();
-        std::printf("[ST] pitch=%.3f\n", semi);
+        gParamBox.setPitch(semi);
     }
 
     void st_set_volume(float v)
@@ -996,7 +5197,7 @@ extern "C"
 
     double st_get_playback_time()
     {
-        double sec = static_cast<double>(gProcessedSamples.load()) / static_cast<double>(SAMPLE_RATE);
+        double sec = static_cast<double>(audiblePlayheadFrames()) / static_cast<double>(gSampleRate);
         return sec;
     }
 
@@ -1005,9 +5206,10 @@ extern "C"
         return gDurationMs;
     }
 
+    // 지금 들리는 소스 위치 (tempo 무관, 출력 장치 지연 보정)
     double st_getPositionMs()
     {
-        double sec = static_cast<double>(gProcessedSamples.load()) / static_cast<double>(SAMPLE_RATE);
+        double sec = static_cast<double>(audiblePlayheadFrames()) / static_cast<double>(gSampleRate);
         return sec * 1000.0;
     }
 
@@ -1016,29 +5218,304 @@ extern "C"
         seekInternal(ms);
     }
 
+    // 네이티브 A/B 루프 설정
+    //  - repeat: 0 = 무한, N = B에 N번 도달하면 종료 (마지막 바퀴는 B 이후로 그대로 이어짐)
+    //  - wrap은 디코더가 소스 샘플 단위로 처리 (seek / 무음 / SoundTouch flush 없음)
+    void st_setLoop(double aMs, double bMs, int repeat)
+    {
+        if (!(bMs > aMs) || aMs < 0.0)
+        {
+            logLine("FFI", "st_setLoop: invalid region → clear");
+            gLoopBox.post(LoopCommand{});
+            gLoopRemaining.store(0);
+            gDecodeWaker.notify();
+            return;
+        }
+
+        LoopCommand cmd;
+        cmd.enabled = true;
+        cmd.aMs = aMs;
+        cmd.bMs = bMs;
+        cmd.repeat = repeat;
+        gLoopBox.post(cmd);
+        gLoopRemaining.store(repeat <= 0 ? -1 : repeat);
+        gDecodeWaker.notify();
+    }
+
+    // 루프 해제 (반복 중이면 이번 바퀴는 B까지 듣고 그대로 이어서 재생)
+    void st_clearLoop()
+    {
+        gLoopBox.post(LoopCommand{});
+        gLoopRemaining.store(0);
+        gDecodeWaker.notify();
+    }
+
+    // 남은 반복 (-1 = 무한, 0 = 루프 없음/소진) — wrap이 실제로 들린 시점에 갱신
+    int st_getLoopRemaining()
+    {
+        return gLoopRemaining.load();
+    }
+
+    // 트랙 끝까지 재생됨 (1회성: 읽으면 해제)
+    //  - SoundTouch 꼬리까지 디바이스로 다 나간 뒤에 true, seek/새 파일이면 리셋
+    bool st_consumeEndOfStream()
+    {
+        return gEndOfStreamEvent.exchange(false);
+    }
+
+    // 엔진 이벤트 채널 연결
+    //  - port: Dart ReceivePort.sendPort.nativePort (0 = 해제)
+    //  - postCObject: NativeApi.postCObject
+    void st_setEventPort(int64_t port, void *postCObject)
+    {
+        stopEventThread();
+        if (port == 0 || !postCObject)
+        {
+            logLine("FFI", "event port cleared");
+            return;
+        }
+
+        gEventRunning.store(true);
+        gEventThread = std::thread(eventThreadFunc, reinterpret_cast<Dart_PostCObjectFn>(postCObject),
+                                   static_cast<Dart_Port>(port));
+        logLine("FFI", "event port set");
+    }
+
+    // 늦은 스트레치 모드 (링에는 소스 PCM, SoundTouch는 출력 직전 워커가)
+    //  - aheadFrames: 출력 링을 콜백보다 앞서 채워 둘 프레임 수 (0 = 장치 period × 2)
+    //  - 전환은 디코더가 지금 들리는 위치로 seek하며 적용
+    void st_setLateStretch(bool enabled, int aheadFrames)
+    {
+        gStretchAheadReq.store(std::max(0, aheadFrames));
+        gLateStretchReq.store(enabled);
+        gDecodeWaker.notify();
+        gStretchWaker.notify();
+    }
+
+    // 늦은 스트레치 워커가 지금 맞추는 출력 링 앞섬 (프레임, 모드 꺼짐 = 0)
+    int st_getStretchAheadFrames()
+    {
+        return gLateActive.load() ? gStretchTarget.load() : 0;
+    }
+
+    // 장치 프로필 요청 (st_create 전에만, 이미 생성됐으면 false)
+    //  - periodFrames / periods: 0 = miniaudio 기본, lowLatency: 성능 프로필
+    //  - ringFrames: 출력 링 용량 (2의 거듭제곱으로 올림), warmupMs: 재생 시작 전 채울 분량
+    bool st_setEngineConfig(int periodFrames, int periods, bool lowLatency, int ringFrames, int warmupMs)
+    {
+        if (gEngineCreated.load())
+        {
+            logLine("FFI", "st_setEngineConfig: engine already created");
+            return false;
+        }
+        gEngineConfig.periodFrames = std::max(0, periodFrames);
+        gEngineConfig.periods = std::max(0, periods);
+        gEngineConfig.lowLatency = lowLatency;
+        gEngineConfig.ringFrames = ringFrames > 0 ? ringFrames : STABLE_CAP_FRAMES;
+        gEngineConfig.warmupMs = warmupMs > 0 ? warmupMs : GUARD_MIN_MS;
+        return true;
+    }
+
+    // 협상된 장치 프로필
+    //  - out: [periodFrames, periods, lowLatency, ringFrames, warmupMs, sampleRate, latencyFrames]
+    //  - 리턴: 채운 개수 (st_create 전이면 요청값)
+    int st_getEngineConfig(int32_t *out, int maxCount)
+    {
+        if (!out || maxCount <= 0)
+        {
+            return 0;
+        }
+        const EngineConfig &c = gEngineCreated.load() ? gEngineActual : gEngineConfig;
+        const int32_t values[] = {c.periodFrames, c.periods, c.lowLatency ? 1 : 0, c.ringFrames,
+                                  c.warmupMs, gSampleRate, gDeviceLatencyFrames.load()};
+        const int n = std::min(maxCount, static_cast<int>(sizeof(values) / sizeof(values[0])));
+        std::memcpy(out, values, static_cast<size_t>(n) * sizeof(int32_t));
+        return n;
+    }
+
+    // 현재 SoundTouch 품질 단계 (0 = 최고, CPU 부하 시 거버너가 올림)
+    int st_getStretchQuality()
+    {
+        return gStretchQuality.load();
+    }
+
+    // 품질 단계 변경 이력 (오래된 것부터)
+    //  - out: 항목마다 [timestampUs, fromLevel, toLevel, stretchLoad‰, callbackLoad‰, underrun(0/1)]
+    //  - 리턴: 채운 항목 수
+    int st_getQualityHistory(int64_t *out, int maxEntries)
+    {
+        if (!out || maxEntries <= 0)
+        {
+            return 0;
+        }
+        return gGovernor.copyHistory(out, maxEntries);
+    }
+
+    // tempo 1 / pitch 0에서 SoundTouch 우회 허용 (기본 켬) / 지금 우회 중인지
+    void st_setStretchBypass(bool enabled)
+    {
+        gBypassEnabled.store(enabled);
+        gDecodeWaker.notify();
+    }
+
+    bool st_isStretchBypassed()
+    {
+        return gStretchBypassed.load();
+    }
+
+    // 디코더 → SoundTouch → 출력 링 경로에서 중간 버퍼 복사 없이 옮긴 누적 바이트 (진단용)
+    int64_t st_getCopyBytesSaved()
+    {
+        return static_cast<int64_t>(gCopyBytesSaved.load(std::memory_order_relaxed));
+    }
+
+    // 위 누적 바이트를 재생 오디오 1초당으로 환산 (바이트/초, 아직 측정 전이면 0)
+    //  - 분모: SoundTouch 출력 FIFO에서 링으로 바로 들어간 프레임 (일반/늦은 스트레치 drain 경로)
+    //  - 분자: 그 출력 + 디코더가 SoundTouch 입력 FIFO에 바로 쓴 입력 → tempo가 낮을수록 입력 쪽 몫이 줄어듦
+    double st_getCopyBytesSavedPerSecond()
+    {
+        const uint64_t frames = gCopySavedFrames.load(std::memory_order_relaxed);
+        if (frames == 0 || gSampleRate <= 0)
+        {
+            return 0.0;
+        }
+        return static_cast<double>(gCopyBytesSaved.load(std::memory_order_relaxed)) * gSampleRate /
+               static_cast<double>(frames);
+    }
+
+    // 출력 링 적응 목표량 범위 (프레임, 0 = 기본)
+    void st_setFillBounds(int minFrames, int maxFrames)
+    {
+        gJitter.setBounds(minFrames, maxFrames);
+    }
+
+    int st_getFillTarget()
+    {
+        return gFillTarget.load();
+    }
+
+    // 목표량 변경 이력 (오래된 것부터)
+    //  - out: 항목마다 [timestampUs, targetFrames, reason(1 underrun/2 cost/3 shrink/4 bounds), blockCostPeakUs]
+    //  - 리턴: 채운 항목 수
+    int st_getFillHistory(int64_t *out, int maxEntries)
+    {
+        if (!out || maxEntries <= 0)
+        {
+            return 0;
+        }
+        return gJitter.copyHistory(out, maxEntries);
+    }
+
+    // 정지 중 장치 휴면 정책 (ms, 0 = 끔)
+    //  - 끄면 휴면 중인 장치도 바로 깨움
+    void st_setIdlePolicy(int idleStopMs)
+    {
+        gIdleStopMs.store(std::max(0, idleStopMs));
+        if (idleStopMs <= 0 && gEngineCreated.load())
+        {
+            wakeAudioDevice();
+        }
+        gIdleWaker.notify();
+    }
+
+    bool st_isDeviceIdle()
+    {
+        return gDeviceIdle.load();
+    }
+
+    // 마지막 휴면 해제 → 첫 콜백까지 걸린 시간
+    double st_getLastWakeLatencyMs()
+    {
+        return static_cast<double>(gLastWakeLatencyNs.load()) / 1e6;
+    }
+
+    // 엔진 샘플레이트 (= 출력 장치 네이티브 레이트, st_create 이후 고정)
+    int st_getSampleRate()
+    {
+        return gSampleRate;
+    }
+
+    // 재생 중 위치 tick 주기 (Hz, 0 = 끔)
+    void st_setPositionTickHz(int hz)
+    {
+        gPositionTickHz.store(std::max(0, std::min(hz, 240)));
+        gEventWaker.notify();
+    }
+
+    // 렌더 캐시에서 SoundTouch 없이 내보낸 누적 출력 프레임 (진단용)
+    int64_t st_getLoopRenderedFrames()
+    {
+        return static_cast<int64_t>(gLoopRenderedFrames.load(std::memory_order_relaxed));
+    }
+
+    // 스크럽 속도 지정 (FF/RW 홀드)
+    //  - v: 원속 대비 배수, 음수 = 역방향, 0 = 제자리 (무음, 스크럽 유지)
+    //  - 끝내려면 st_scrubEnd()
+    void st_scrubSetVelocity(double v)
+    {
+        if (!gFileOpened.load())
+        {
+            return;
+        }
+        gScrubVelocity.store(v);
+        gScrubMode.store(SCRUB_VELOCITY);
+        wakeAudioDevice(); // 정지 중 스크럽도 들려야 함
+        gDecodeWaker.notify();
+    }
+
+    // 스크럽 타겟 지정 (파형 드래그)
+    //  - 디코더가 타겟을 향해 속도를 자동으로 조절하며 따라감 (seek 없음)
+    void st_scrubToMs(double ms)
+    {
+        if (!gFileOpened.load())
+        {
+            return;
+        }
+        gScrubTargetMs.store(std::max(0.0, ms));
+        gScrubMode.store(SCRUB_FOLLOW);
+        wakeAudioDevice();
+        gDecodeWaker.notify();
+    }
+
+    // 스크럽 종료 → 마지막 위치에서 일반 재생(또는 정지) 상태로 복귀
+    void st_scrubEnd()
+    {
+        if (gScrubMode.exchange(SCRUB_OFF) != SCRUB_OFF)
+        {
+            gDecodeWaker.notify();
+            markEngineActive();
+        }
+    }
+
+    bool st_isScrubbing()
+    {
+        return gScrubActive.load();
+    }
+
     void st_copyLastBuffer(float *dst, int maxFrames)
     {
         if (!dst || maxFrames <= 0)
             return;
-        int frames = std::min<int>(maxFrames, BUF_FRAMES);
 
-        std::memcpy(
-            dst,
-            gLastBuffer.data(),
-            frames * CHANNELS * sizeof(float));
+        gLastSnapshot.copyTo(dst, maxFrames);
     }
 
     double st_getRmsLevel()
     {
-        double sum = 0.0;
-        int N = BUF_FRAMES * CHANNELS;
+        return gLastSnapshot.rms();
+    }
 
-        for (int i = 0; i < N; ++i)
-        {
-            float v = gLastBuffer[i];
-            sum += static_cast<double>(v) * static_cast<double>(v);
-        }
-        return std::sqrt(sum / static_cast<double>(N));
+    // 콜백 worst-case 실행 시간 (µs) — 호출 시 통계를 리셋하려면 reset=true
+    double st_getCallbackMaxUs(bool reset)
+    {
+        const uint64_t ns = reset ? gCbMaxNs.exchange(0) : gCbMaxNs.load();
+        return static_cast<double>(ns) / 1000.0;
+    }
+
+    // 지금까지 실행된 콜백 횟수
+    int64_t st_getCallbackCount()
+    {
+        return static_cast<int64_t>(gCbCount.load());
     }
 
     void st_feed_pcm(float * /*data*/, int /*frames*/)
@@ -1053,7 +5530,20 @@ extern "C"
             return;
         }
         logLine("FFI", "st_play called");
+
+        // 휴면 중이면 장치부터 재시작 (링은 정지 전 프리필 그대로)
+        wakeAudioDevice();
+
+        // 정지 중 seek했다면 latency는 play 시점부터 측정
+        if (gSeekStartNs.load() != 0)
+        {
+            gSeekStartNs.store(steadyNowNs());
+        }
+
         gPaused.store(false);
+        gDecodeWaker.notify();
+        gStretchWaker.notify();
+        gEventWaker.notify();
     }
 
     void st_pause()
@@ -1064,6 +5554,8 @@ extern "C"
         }
         logLine("FFI", "st_pause called");
         gPaused.store(true);
+        markEngineActive(); // 휴면 타이머 시작
+        gEventWaker.notify();
     }
 
 } // extern "C"
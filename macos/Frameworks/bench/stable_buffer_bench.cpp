@@ -0,0 +1,329 @@
+// ─────────────────────────────
+// stable_buffer_bench — StableBuffer push/pop 마이크로벤치
+//  - 예전 mutex 링(MutexStableBuffer)과 엔진의 lock-free SPSC 링(StableBuffer)을
+//    같은 조건으로 돌려 비교한다
+//  - producer 스레드 1개가 블록 단위로 push (디코더 스레드 역할)
+//  - consumer 스레드 1개가 콜백 크기로 pop (miniaudio 콜백 역할), pop 1회마다 시간 측정
+//  - 출력: 처리량(Mframes/s), pop 지연 p50 / p99 / p99.9 / 최악값
+//
+// 빌드/실행 (엔진과 별개, 외부 의존성 없음):
+//   c++ -std=c++17 -O2 -pthread macos/Frameworks/bench/stable_buffer_bench.cpp -o stable_buffer_bench
+//   ./stable_buffer_bench [총 프레임(M, 기본 64)] [pop 프레임(기본 512)] [push 프레임(기본 1024)]
+//
+// SPSC 쪽은 엔진과 같은 stable_buffer.h를 include — 엔진 클래스가 바뀌면 벤치도 그대로 따라감
+// mutex 쪽은 lock-free 전환 이전 리비전을 비교 기준으로 고정해 둔 복사본
+// ─────────────────────────────
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../stable_buffer.h"
+
+// ─────────────────────────────
+// MutexStableBuffer — 예전 구현 (mutex + 프레임 단위 % 복사, 비교 기준으로 고정)
+// ─────────────────────────────
+class MutexStableBuffer
+{
+public:
+    MutexStableBuffer()
+    {
+        buffer_.resize(STABLE_CAP_FRAMES * STABLE_CHANNELS, 0.0f);
+        clear();
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        head_ = 0;
+        tail_ = 0;
+        count_ = 0;
+        std::fill(buffer_.begin(), buffer_.end(), 0.0f);
+    }
+
+    int push(const float *src, int frames)
+    {
+        if (!src || frames <= 0)
+            return 0;
+
+        std::lock_guard<std::mutex> lock(mu_);
+
+        int freeFrames = STABLE_CAP_FRAMES - count_;
+        if (freeFrames <= 0)
+        {
+            return 0;
+        }
+
+        int framesToWrite = std::min(frames, freeFrames);
+
+        for (int f = 0; f < framesToWrite; ++f)
+        {
+            for (int c = 0; c < STABLE_CHANNELS; ++c)
+            {
+                buffer_[head_ * STABLE_CHANNELS + c] = src[f * STABLE_CHANNELS + c];
+            }
+            head_ = (head_ + 1) % STABLE_CAP_FRAMES;
+        }
+        count_ += framesToWrite;
+        return framesToWrite;
+    }
+
+    int pop(float *dst, int maxFrames)
+    {
+        if (!dst || maxFrames <= 0)
+            return 0;
+
+        std::lock_guard<std::mutex> lock(mu_);
+
+        if (count_ <= 0)
+            return 0;
+
+        int framesToRead = std::min(maxFrames, count_);
+        for (int f = 0; f < framesToRead; ++f)
+        {
+            for (int c = 0; c < STABLE_CHANNELS; ++c)
+            {
+                dst[f * STABLE_CHANNELS + c] = buffer_[tail_ * STABLE_CHANNELS + c];
+            }
+            tail_ = (tail_ + 1) % STABLE_CAP_FRAMES;
+        }
+        count_ -= framesToRead;
+        return framesToRead;
+    }
+
+private:
+    std::vector<float> buffer_;
+    int head_ = 0;
+    int tail_ = 0;
+    int count_ = 0;
+    mutable std::mutex mu_;
+};
+
+// ─────────────────────────────
+// 측정
+//  - 1단계(처리량): producer/consumer 모두 쉬지 않고 돌림, pop에 시계 안 붙임
+//  - 2단계(지연): producer는 계속 쉬지 않고 push, consumer는 pop 1회마다 시간 측정
+//    → mutex 버전은 producer가 lock을 쥔 동안 pop이 막히는 시간이 그대로 드러남
+//  - 지연은 log2 + 8단계 히스토그램에 누적 (pop 수억 번이어도 메모리 고정), max는 정확값
+// ─────────────────────────────
+using Clock = std::chrono::steady_clock;
+
+class LatencyHistogram
+{
+public:
+    void add(uint64_t ns)
+    {
+        ++buckets_[bucketOf(ns)];
+        ++count_;
+        maxNs_ = std::max(maxNs_, ns);
+    }
+
+    // p 분위가 들어 있는 버킷의 상한 (ns)
+    uint64_t percentile(double p) const
+    {
+        if (count_ == 0)
+            return 0;
+        const uint64_t want = static_cast<uint64_t>(p * static_cast<double>(count_ - 1)) + 1;
+        uint64_t seen = 0;
+        for (int b = 0; b < NUM_BUCKETS; ++b)
+        {
+            seen += buckets_[b];
+            if (seen >= want)
+                return std::min(upperOf(b), maxNs_);
+        }
+        return maxNs_;
+    }
+
+    uint64_t count() const { return count_; }
+    uint64_t maxNs() const { return maxNs_; }
+
+private:
+    static constexpr int SUB = 8; // 2배 구간당 8칸 → 상대 오차 12.5% 이내
+    static constexpr int NUM_BUCKETS = 64 * SUB;
+
+    static int bucketOf(uint64_t ns)
+    {
+        if (ns < SUB)
+            return static_cast<int>(ns);
+        int msb = 63;
+        while (!(ns >> msb))
+            --msb;
+        const int sub = static_cast<int>((ns >> (msb - 3)) & (SUB - 1));
+        return (msb - 2) * SUB + sub;
+    }
+
+    static uint64_t upperOf(int b)
+    {
+        if (b < SUB)
+            return static_cast<uint64_t>(b);
+        const int msb = b / SUB + 2;
+        const uint64_t sub = static_cast<uint64_t>(b % SUB);
+        return ((SUB + sub + 1) << (msb - 3)) - 1;
+    }
+
+    uint64_t buckets_[NUM_BUCKETS] = {};
+    uint64_t count_ = 0;
+    uint64_t maxNs_ = 0;
+};
+
+struct BenchResult
+{
+    double mframesPerSec = 0.0;
+    uint64_t timedPops = 0;
+    uint64_t emptyPops = 0;
+    uint64_t p50Ns = 0;
+    uint64_t p99Ns = 0;
+    uint64_t p999Ns = 0;
+    uint64_t maxNs = 0;
+    bool orderOk = true;
+};
+
+// producer는 프레임 번호를 샘플 값으로 채우고, consumer는 순서를 확인한다
+//  (값이 float이므로 2^24 주기로 감아서 정확히 표현되게 함)
+static inline float frameTag(uint64_t frame)
+{
+    return static_cast<float>(frame & 0xFFFFFF);
+}
+
+// totalFrames를 producer → ring → consumer로 흘려 보내고 걸린 시간(초)을 리턴
+//  - hist가 있으면 pop마다 지연을 기록 (빈 pop 포함: mutex 버전은 빈 pop도 lock을 잡음)
+template <class Ring>
+static double runOnce(uint64_t totalFrames, int popFrames, int pushFrames,
+                      LatencyHistogram *hist, BenchResult &r)
+{
+    Ring ring;
+    std::atomic<bool> go{false};
+
+    std::thread producer([&] {
+        std::vector<float> block(static_cast<size_t>(pushFrames) * STABLE_CHANNELS);
+        uint64_t written = 0;
+        while (!go.load(std::memory_order_acquire))
+            std::this_thread::yield();
+        while (written < totalFrames)
+        {
+            const int want = static_cast<int>(std::min<uint64_t>(pushFrames, totalFrames - written));
+            for (int f = 0; f < want; ++f)
+            {
+                const float v = frameTag(written + f);
+                for (int c = 0; c < STABLE_CHANNELS; ++c)
+                    block[f * STABLE_CHANNELS + c] = v;
+            }
+            int off = 0;
+            while (off < want)
+            {
+                const int n = ring.push(block.data() + off * STABLE_CHANNELS, want - off);
+                if (n == 0)
+                    std::this_thread::yield(); // 가득 참 → 디코더처럼 양보
+                off += n;
+            }
+            written += static_cast<uint64_t>(want);
+        }
+    });
+
+    std::vector<float> out(static_cast<size_t>(popFrames) * STABLE_CHANNELS);
+
+    go.store(true, std::memory_order_release);
+    const auto t0 = Clock::now();
+
+    uint64_t read = 0;
+    while (read < totalFrames)
+    {
+        int n;
+        if (hist)
+        {
+            const auto a = Clock::now();
+            n = ring.pop(out.data(), popFrames);
+            const auto b = Clock::now();
+            hist->add(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(b - a).count()));
+        }
+        else
+        {
+            n = ring.pop(out.data(), popFrames);
+        }
+
+        if (n == 0)
+        {
+            if (hist)
+                ++r.emptyPops;
+            std::this_thread::yield(); // 빈 링 → 콜백이 다음 주기를 기다리는 것과 같은 양보
+            continue;
+        }
+        for (int f = 0; f < n && r.orderOk; ++f)
+        {
+            if (out[f * STABLE_CHANNELS] != frameTag(read + f))
+                r.orderOk = false;
+        }
+        read += static_cast<uint64_t>(n);
+    }
+
+    const auto t1 = Clock::now();
+    producer.join();
+    return std::chrono::duration<double>(t1 - t0).count();
+}
+
+template <class Ring>
+static BenchResult runBench(uint64_t totalFrames, int popFrames, int pushFrames)
+{
+    BenchResult r;
+
+    const double sec = runOnce<Ring>(totalFrames, popFrames, pushFrames, nullptr, r);
+    r.mframesPerSec = static_cast<double>(totalFrames) / sec / 1e6;
+
+    LatencyHistogram hist;
+    runOnce<Ring>(totalFrames, popFrames, pushFrames, &hist, r);
+    r.timedPops = hist.count();
+    r.p50Ns = hist.percentile(0.50);
+    r.p99Ns = hist.percentile(0.99);
+    r.p999Ns = hist.percentile(0.999);
+    r.maxNs = hist.maxNs();
+    return r;
+}
+
+static void report(const char *name, const BenchResult &r)
+{
+    std::printf("[Bench] %-6s %8.1f Mframes/s  pops=%llu (empty %llu)  "
+                "pop ns p50<=%llu p99<=%llu p99.9<=%llu max=%llu  order=%s\n",
+                name,
+                r.mframesPerSec,
+                static_cast<unsigned long long>(r.timedPops),
+                static_cast<unsigned long long>(r.emptyPops),
+                static_cast<unsigned long long>(r.p50Ns),
+                static_cast<unsigned long long>(r.p99Ns),
+                static_cast<unsigned long long>(r.p999Ns),
+                static_cast<unsigned long long>(r.maxNs),
+                r.orderOk ? "ok" : "BROKEN");
+}
+
+int main(int argc, char **argv)
+{
+    const uint64_t totalFrames = (argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 64ull) * 1000000ull;
+    const int popFrames = argc > 2 ? std::atoi(argv[2]) : 512;
+    const int pushFrames = argc > 3 ? std::atoi(argv[3]) : 1024;
+
+    if (totalFrames == 0 || popFrames <= 0 || pushFrames <= 0)
+    {
+        std::fprintf(stderr, "usage: %s [Mframes] [popFrames] [pushFrames]\n", argv[0]);
+        return 2;
+    }
+
+    std::printf("[Bench] StableBuffer cap=%d ch=%d frames=%llu pop=%d push=%d hw_threads=%u\n",
+                STABLE_CAP_FRAMES, STABLE_CHANNELS,
+                static_cast<unsigned long long>(totalFrames), popFrames, pushFrames,
+                std::thread::hardware_concurrency());
+
+    const BenchResult mutexRes = runBench<MutexStableBuffer>(totalFrames, popFrames, pushFrames);
+    report("mutex", mutexRes);
+
+    const BenchResult spscRes = runBench<StableBuffer>(totalFrames, popFrames, pushFrames);
+    report("spsc", spscRes);
+
+    return (mutexRes.orderOk && spscRes.orderOk) ? 0 : 1;
+}
@@ -0,0 +1,198 @@
+// ─────────────────────────────────────────────────────────────
+//  StableBuffer — 재생용 중앙 링버퍼
+//
+//  audio_chain_miniaudio.cpp에서만 쓰는 헤더.
+//  엔진 밖 의존성이 없어 bench/stable_buffer_bench.cpp도 이 클래스를
+//  그대로 include해서 측정한다 (벤치가 엔진과 다른 코드를 재는 일 없음).
+// ─────────────────────────────────────────────────────────────
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// ─────────────────────────────
+// 링 포맷
+// ─────────────────────────────
+static constexpr int STABLE_CHANNELS = 2; // 인터리브 채널 수 (엔진 CHANNELS와 같아야 함)
+static constexpr int STABLE_CAP_FRAMES = 16384; // StableBuffer 기본 용량 (프레임 단위, 장치 프로필로 변경)
+
+// ─────────────────────────────
+// StableBuffer — 재생용 링버퍼 (프레임 단위, lock-free SPSC)
+//  - FFmpeg+SoundTouch가 push (producer, 디코더 스레드 1개)
+//  - miniaudio 콜백이 pop (consumer, 오디오 스레드 1개)
+//  - drop 없이, push 시 공간 없으면 0을 리턴
+//  - mutex 없음: head(쓰기)/tail(읽기) 인덱스만 atomic으로 주고받는다
+//    → 오디오 콜백은 디코더 스레드 때문에 절대 block되지 않음
+//  - 인덱스는 단조 증가 카운터, 용량은 2의 거듭제곱 → % 대신 & mask
+//  - 복사는 최대 2개의 연속 구간 memcpy (링 끝에서 한 번 꺾임)
+// ─────────────────────────────
+class StableBuffer
+{
+public:
+    explicit StableBuffer(int capacityFrames = STABLE_CAP_FRAMES)
+    {
+        allocate(capacityFrames);
+    }
+
+    // 용량 변경 — producer/consumer가 모두 없을 때만 (st_create에서 콜백 시작 전)
+    void reallocate(int capacityFrames)
+    {
+        allocate(capacityFrames);
+        head_.store(0, std::memory_order_release);
+        tail_.store(0, std::memory_order_release);
+        epoch_.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    // 읽을 수 있는 모든 프레임을 버린다.
+    //  - 어느 스레드에서 호출해도 안전: tail을 읽어 둔 head까지 CAS로 당김
+    //  - tail은 절대 뒤로 가지 않음 (그 사이 pop이 tail을 이미 더 밀었으면 그대로 둠)
+    //    → 재생한 블록을 다시 내보내지 않고, head - tail <= cap도 유지됨
+    //  - 콜백이 동시에 pop 중이면 pop 쪽 CAS가 실패해 그 블록은 버려짐
+    void clear()
+    {
+        size_t tail = tail_.load(std::memory_order_acquire);
+        const size_t head = head_.load(std::memory_order_acquire);
+        while (tail < head &&
+               !tail_.compare_exchange_weak(tail, head, std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+        }
+        epoch_.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    // frames 단위 push (producer 전용)
+    //  - 가능한 만큼만 쓰고, 실제 쓴 프레임 수를 리턴
+    int push(const float *src, int frames)
+    {
+        if (!src || frames <= 0)
+            return 0;
+
+        const size_t head = head_.load(std::memory_order_relaxed);
+        const size_t tail = tail_.load(std::memory_order_acquire);
+
+        const size_t freeFrames = capFrames_ - (head - tail);
+        if (freeFrames == 0)
+        {
+            return 0; // 더 이상 쓸 공간 없음
+        }
+
+        const size_t n = std::min(static_cast<size_t>(frames), freeFrames);
+        const size_t idx = head & mask_;
+        const size_t first = std::min(n, capFrames_ - idx);
+
+        std::memcpy(&buffer_[idx * STABLE_CHANNELS], src, first * STABLE_CHANNELS * sizeof(float));
+        if (n > first)
+        {
+            std::memcpy(&buffer_[0], src + first * STABLE_CHANNELS, (n - first) * STABLE_CHANNELS * sizeof(float));
+        }
+
+        head_.store(head + n, std::memory_order_release);
+        return static_cast<int>(n);
+    }
+
+    // frames 단위 pop (consumer 전용)
+    //  - 실제 가져온 프레임 수 리턴
+    int pop(float *dst, int maxFrames)
+    {
+        if (!dst || maxFrames <= 0)
+            return 0;
+
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        const size_t head = head_.load(std::memory_order_acquire);
+
+        const size_t avail = head - tail;
+        if (avail == 0)
+            return 0;
+
+        const size_t n = std::min(static_cast<size_t>(maxFrames), avail);
+        const size_t idx = tail & mask_;
+        const size_t first = std::min(n, capFrames_ - idx);
+
+        std::memcpy(dst, &buffer_[idx * STABLE_CHANNELS], first * STABLE_CHANNELS * sizeof(float));
+        if (n > first)
+        {
+            std::memcpy(dst + first * STABLE_CHANNELS, &buffer_[0], (n - first) * STABLE_CHANNELS * sizeof(float));
+        }
+
+        // clear()가 그 사이에 tail을 옮겼다면 방금 읽은 블록은 무효 → 버림
+        size_t expected = tail;
+        if (!tail_.compare_exchange_strong(expected, tail + n, std::memory_order_acq_rel))
+            return 0;
+        return static_cast<int>(n);
+    }
+
+    int size() const
+    {
+        const size_t head = head_.load(std::memory_order_acquire);
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        // head를 먼저 읽으므로, 그 사이 push + pop(또는 clear)이 tail을 더 밀면 tail > head로 보일 수 있음 → 방어
+        return head >= tail ? static_cast<int>(head - tail) : 0;
+    }
+
+    int capacity() const
+    {
+        return static_cast<int>(capFrames_);
+    }
+
+    // 지금 push할 수 있는 프레임 수 (producer 쪽에서 보는 값)
+    int freeFrames() const
+    {
+        return capacity() - size();
+    }
+
+    // 가득 찼을 때 back-pressure 기준 (용량의 3/4)
+    int highWatermark() const
+    {
+        return static_cast<int>(capFrames_ * 3 / 4);
+    }
+
+    // 소비 쪽이 생산자를 깨우는 기준 (이 아래로 내려가면 refill 신호)
+    int lowWatermark() const
+    {
+        return static_cast<int>(capFrames_ / 2);
+    }
+
+    // 누적 쓰기/읽기 위치 (프레임, 단조 증가) — 링 위치 마커 기준
+    size_t writePos() const
+    {
+        return head_.load(std::memory_order_acquire);
+    }
+
+    size_t readPos() const
+    {
+        return tail_.load(std::memory_order_acquire);
+    }
+
+    // clear() 횟수 — clear 이전에 만든 마커를 구분하는 세대 번호
+    uint32_t epoch() const
+    {
+        return epoch_.load(std::memory_order_acquire);
+    }
+
+private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    void allocate(int capacityFrames)
+    {
+        // 2의 거듭제곱으로 올림
+        size_t cap = 1;
+        while (cap < static_cast<size_t>(std::max(capacityFrames, 1)))
+            cap <<= 1;
+
+        capFrames_ = cap;
+        mask_ = cap - 1;
+        buffer_.assign(cap * STABLE_CHANNELS, 0.0f);
+    }
+
+    // producer / consumer 인덱스를 서로 다른 캐시 라인에 둔다 (false sharing 방지)
+    alignas(CACHE_LINE) std::atomic<size_t> head_{0}; // 다음에 쓸 위치 (producer 소유)
+    alignas(CACHE_LINE) std::atomic<size_t> tail_{0}; // 다음에 읽을 위치 (consumer 소유)
+    std::atomic<uint32_t> epoch_{0};
+
+    alignas(CACHE_LINE) size_t capFrames_ = 0;
+    size_t mask_ = 0;
+    std::vector<float> buffer_;
+};
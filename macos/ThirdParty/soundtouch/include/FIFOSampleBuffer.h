@@ -49,6 +49,11 @@ namespace soundtouch
 ///
 /// Notice that in case of stereo audio, one sample is considered to consist of
 /// both channel data.
+///
+/// After 'reserve', the buffer works as a ring whose storage is mapped twice
+/// back-to-back in virtual memory, so that 'ptrBegin' / 'ptrEnd' keep returning
+/// contiguous regions without ever moving the data. On platforms where such
+/// mirroring isn't available, 'reserve' just preallocates the linear buffer.
 class FIFOSampleBuffer : public FIFOSamplePipe
 {
 private:
@@ -65,6 +70,14 @@ private:
     /// How many samples are currently in buffer.
     uint samplesInBuffer;
 
+    /// Nonzero when 'buffer' is a mirrored ring of 'sizeInBytes' bytes (followed
+    /// by its mirror), in which case 'bufferPos' wraps around the capacity.
+    bool mirrored;
+
+    /// Capacity requested with 'reserve', in samples. Kept for re-reserving
+    /// after a channel count change.
+    uint reservedSamples;
+
     /// Channels, 1=mono, 2=stereo.
     uint channels;
 
@@ -83,6 +96,13 @@ private:
     /// Returns current capacity.
     uint getCapacity() const;
 
+    /// Moves the buffer contents into a new mirrored ring of at least
+    /// 'capacityRequirement' samples. Returns false if mirroring isn't available.
+    bool allocMirrored(uint capacityRequirement);
+
+    /// Releases the current storage, be it mirrored or linear.
+    void releaseBuffer();
+
 public:
 
     /// Constructor
@@ -173,6 +193,18 @@ public:
 
     /// Add silence to end of buffer
     void addSilent(uint nSamples);
+
+    /// Preallocates room for at least 'capacity' samples and switches the buffer
+    /// into the mirrored ring mode where available. As long as the buffer content
+    /// and the requested slack stay within the reserved capacity, adding and
+    /// removing samples then neither allocates nor moves data.
+    void reserve(uint capacity);
+
+    /// Returns nonzero if the buffer runs in the mirrored ring mode.
+    bool isMirrored() const
+    {
+        return mirrored;
+    }
 };
 
 }
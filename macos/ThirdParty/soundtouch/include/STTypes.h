@@ -157,6 +157,12 @@ namespace soundtouch
         #ifdef SOUNDTOUCH_ALLOW_X86_OPTIMIZATIONS
             // Allow SSE optimizations
             #define SOUNDTOUCH_ALLOW_SSE       1
+
+            // Allow AVX2/AVX-512 optimizations (64bit only). These are compiled
+            // with per-function target attributes and selected at runtime.
+            #if (defined(__x86_64__) || defined(_M_X64))
+                #define SOUNDTOUCH_ALLOW_AVX   1
+            #endif
         #endif
 
     #endif  // SOUNDTOUCH_INTEGER_SAMPLES
@@ -165,6 +165,22 @@ namespace soundtouch
 #define SETTING_INITIAL_LATENCY             8
 
 
+/// Enable/disable coarse-to-fine seeking algorithm in tempo changer routine. The
+/// correlation curve is first computed on a decimated mono downmix over the whole
+/// seek window, and the best peaks are then refined at full resolution. Gives
+/// nearly the same overlap positions as the full search at about the quick seek
+/// cost. When enabled, overrides SETTING_USE_QUICKSEEK.
+#define SETTING_USE_PYRAMIDSEEK             9
+
+/// Interpolation algorithm of the pitch transposer: 0 = linear, 1 = cubic,
+/// 2 = shannon, 3 = polyphase windowed-sinc. The polyphase interpolator has the
+/// anti-alias lowpass built into its kernel and replaces the separate anti-alias
+/// filter pass; SETTING_AA_FILTER_LENGTH then sets its tap count. Changing the
+/// algorithm clears the samples buffered in the transposer. Floating point
+/// builds only.
+#define SETTING_TRANSPOSER_ALGORITHM        10
+
+
 class SoundTouch : public FIFOProcessor
 {
 private:
@@ -289,6 +305,31 @@ public:
                                                     ///< contains data for both channels.
             ) override;
 
+    /// Zero-copy input: returns a pointer to the input buffer of the first
+    /// processing stage with room for at least 'maxSamples' samples. Write the
+    /// samples there (e.g. straight from a resampler) and call 'commitInput'
+    /// with the number actually written. Settings must not change in between,
+    /// and the pointer is invalidated by any other call to this object.
+    SAMPLETYPE *inputSpan(uint maxSamples);
+
+    /// Processes 'numSamples' samples written to the pointer from 'inputSpan'.
+    /// Equivalent to 'putSamples' without copying the input.
+    void commitInput(uint numSamples);
+
+    /// Zero-copy output: pointer to the first of 'numSamples()' processed samples.
+    /// Copy them out and call 'receiveSamples(n)' to remove the ones consumed.
+    SAMPLETYPE *outputBegin()
+    {
+        return ptrBegin();
+    }
+
+    /// Preallocates every internal sample buffer for at least 'numSamples' samples
+    /// and switches them to mirrored ring buffers where the platform allows. As long
+    /// as the buffered amounts stay within that, steady-state processing neither
+    /// allocates nor moves sample data; the buffers still grow if ever needed.
+    /// Call after 'setChannels'.
+    void reserveBuffers(uint numSamples);
+
     /// Output samples from beginning of the sample buffer. Copies requested samples to
     /// output buffer and removes them from the sample buffer. If there are less than
     /// 'numsample' samples in the buffer, returns all that available.
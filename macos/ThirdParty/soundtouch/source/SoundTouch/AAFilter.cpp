@@ -78,6 +78,7 @@ AAFilter::AAFilter(uint len)
 {
     pFIR = FIRFilter::newInstance();
     cutoffFreq = 0.5;
+    length = 0;
     setLength(len);
 }
 
@@ -101,6 +102,9 @@ void AAFilter::setCutoffFreq(double newCutoffFreq)
 // Sets number of FIR filter taps
 void AAFilter::setLength(uint newLength)
 {
+    // same length gives the same coefficients, skip re-designing the filter
+    if (newLength == length) return;
+
     length = newLength;
     calculateCoeffs();
 }
@@ -43,8 +43,109 @@
 
 #include "FIFOSampleBuffer.h"
 
+#if defined(__APPLE__)
+    #include <mach/mach.h>
+    #define ST_MIRROR_MACH
+#elif defined(__linux__)
+    #include <sys/mman.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+    #ifdef SYS_memfd_create
+        #define ST_MIRROR_MEMFD
+    #endif
+#endif
+
 using namespace soundtouch;
 
+
+// Virtual memory page size, i.e. the granularity of the mirrored mapping
+static uint mirrorPageSize()
+{
+#if defined(ST_MIRROR_MACH)
+    return (uint)vm_page_size;
+#elif defined(ST_MIRROR_MEMFD)
+    return (uint)sysconf(_SC_PAGESIZE);
+#else
+    return 4096;
+#endif
+}
+
+
+// Maps 'bytes' of memory twice back-to-back, so that writing to 'base[i]' also
+// shows up at 'base[bytes + i]'. 'bytes' must be a multiple of the page size.
+// Returns nullptr if not supported or failed.
+static void *mirrorMap(uint bytes)
+{
+#if defined(ST_MIRROR_MACH)
+    const vm_map_t task = mach_task_self();
+
+    // another thread may grab the upper half between deallocating and remapping it,
+    // so retry a few times
+    for (int attempt = 0; attempt < 3; attempt ++)
+    {
+        vm_address_t base = 0;
+        if (vm_allocate(task, &base, 2 * bytes, VM_FLAGS_ANYWHERE) != KERN_SUCCESS) return nullptr;
+        if (vm_deallocate(task, base + bytes, bytes) != KERN_SUCCESS)
+        {
+            vm_deallocate(task, base, bytes);
+            return nullptr;
+        }
+
+        vm_address_t mirror = base + bytes;
+        vm_prot_t curProtection, maxProtection;
+        if (vm_remap(task, &mirror, bytes, 0, VM_FLAGS_FIXED, task, base, 0,
+                     &curProtection, &maxProtection, VM_INHERIT_DEFAULT) == KERN_SUCCESS)
+        {
+            if (mirror == base + bytes) return (void *)base;
+            vm_deallocate(task, mirror, bytes);
+        }
+        vm_deallocate(task, base, bytes);
+    }
+    return nullptr;
+#elif defined(ST_MIRROR_MEMFD)
+    int fd = (int)syscall(SYS_memfd_create, "soundtouch-fifo", 1 /* MFD_CLOEXEC */);
+    if (fd < 0) return nullptr;
+
+    void *result = nullptr;
+    if (ftruncate(fd, (off_t)bytes) == 0)
+    {
+        char *base = (char *)mmap(nullptr, 2 * (size_t)bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base != MAP_FAILED)
+        {
+            if ((mmap(base, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED) &&
+                (mmap(base + bytes, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED))
+            {
+                result = base;
+            }
+            else
+            {
+                munmap(base, 2 * (size_t)bytes);
+            }
+        }
+    }
+    close(fd);
+    return result;
+#else
+    (void)bytes;
+    return nullptr;
+#endif
+}
+
+
+// Releases a mapping created by 'mirrorMap'
+static void mirrorUnmap(void *base, uint bytes)
+{
+#if defined(ST_MIRROR_MACH)
+    vm_deallocate(mach_task_self(), (vm_address_t)base, 2 * (vm_size_t)bytes);
+#elif defined(ST_MIRROR_MEMFD)
+    munmap(base, 2 * (size_t)bytes);
+#else
+    (void)base;
+    (void)bytes;
+#endif
+}
+
+
 // Constructor
 FIFOSampleBuffer::FIFOSampleBuffer(int numChannels)
 {
@@ -54,6 +155,8 @@ FIFOSampleBuffer::FIFOSampleBuffer(int numChannels)
     bufferUnaligned = nullptr;
     samplesInBuffer = 0;
     bufferPos = 0;
+    mirrored = false;
+    reservedSamples = 0;
     channels = (uint)numChannels;
     ensureCapacity(32);     // allocate initial capacity
 }
@@ -62,9 +165,24 @@ FIFOSampleBuffer::FIFOSampleBuffer(int numChannels)
 // destructor
 FIFOSampleBuffer::~FIFOSampleBuffer()
 {
-    delete[] bufferUnaligned;
+    releaseBuffer();
+}
+
+
+// Releases the current storage, be it mirrored or linear.
+void FIFOSampleBuffer::releaseBuffer()
+{
+    if (mirrored)
+    {
+        mirrorUnmap(buffer, sizeInBytes);
+    }
+    else
+    {
+        delete[] bufferUnaligned;
+    }
     bufferUnaligned = nullptr;
     buffer = nullptr;
+    mirrored = false;
 }
 
 
@@ -76,8 +194,31 @@ void FIFOSampleBuffer::setChannels(int numChannels)
     if (!verifyNumberOfChannels(numChannels)) return;
 
     usedBytes = channels * samplesInBuffer;
+    if (mirrored)
+    {
+        // the mirror size is tied to the sample frame size, so move the data
+        // to a linear buffer and re-reserve with the new channel count below
+        SAMPLETYPE *tempUnaligned = new SAMPLETYPE[usedBytes + 16 / sizeof(SAMPLETYPE)];
+        SAMPLETYPE *temp = (SAMPLETYPE *)SOUNDTOUCH_ALIGN_POINTER_16(tempUnaligned);
+        memcpy(temp, ptrBegin(), usedBytes * sizeof(SAMPLETYPE));
+        releaseBuffer();
+        buffer = temp;
+        bufferUnaligned = tempUnaligned;
+        sizeInBytes = usedBytes * sizeof(SAMPLETYPE);
+        bufferPos = 0;
+    }
+    else
+    {
+        // 'bufferPos' is in sample frames, so it must be zero before changing the frame size
+        rewind();
+    }
     channels = (uint)numChannels;
     samplesInBuffer = usedBytes / channels;
+
+    if (reservedSamples)
+    {
+        reserve(reservedSamples);
+    }
 }
 
 
@@ -86,7 +227,7 @@ void FIFOSampleBuffer::setChannels(int numChannels)
 // location on to the beginning of the buffer.
 void FIFOSampleBuffer::rewind()
 {
-    if (buffer && bufferPos)
+    if (buffer && bufferPos && !mirrored)
     {
         memmove(buffer, ptrBegin(), sizeof(SAMPLETYPE) * channels * samplesInBuffer);
         bufferPos = 0;
@@ -134,7 +275,9 @@ void FIFOSampleBuffer::putSamples(uint nSamples)
 SAMPLETYPE *FIFOSampleBuffer::ptrEnd(uint slackCapacity)
 {
     ensureCapacity(samplesInBuffer + slackCapacity);
-    return buffer + samplesInBuffer * channels;
+    // in mirrored mode this may point past the ring's end into the mirror, which
+    // is fine as 'bufferPos' + content + slack is always within twice the capacity
+    return ptrBegin() + samplesInBuffer * channels;
 }
 
 
@@ -156,16 +299,25 @@ SAMPLETYPE *FIFOSampleBuffer::ptrBegin()
 // 'capacityRequirement' number of samples. The buffer is grown in steps of
 // 4 kilobytes to eliminate the need for frequently growing up the buffer,
 // as well as to round the buffer size up to the virtual memory page size.
+//
+// A mirrored buffer that outgrows its reservation is moved into a larger ring
+// with some headroom, so that this happens only during warm-up.
 void FIFOSampleBuffer::ensureCapacity(uint capacityRequirement)
 {
     SAMPLETYPE *tempUnaligned, *temp;
+    uint newSizeInBytes;
 
     if (capacityRequirement > getCapacity())
     {
+        if (mirrored && allocMirrored(capacityRequirement + capacityRequirement / 2))
+        {
+            return;
+        }
+
         // enlarge the buffer in 4kbyte steps (round up to next 4k boundary)
-        sizeInBytes = (capacityRequirement * channels * sizeof(SAMPLETYPE) + 4095) & (uint)-4096;
-        assert(sizeInBytes % 2 == 0);
-        tempUnaligned = new SAMPLETYPE[sizeInBytes / sizeof(SAMPLETYPE) + 16 / sizeof(SAMPLETYPE)];
+        newSizeInBytes = (capacityRequirement * channels * sizeof(SAMPLETYPE) + 4095) & (uint)-4096;
+        assert(newSizeInBytes % 2 == 0);
+        tempUnaligned = new SAMPLETYPE[newSizeInBytes / sizeof(SAMPLETYPE) + 16 / sizeof(SAMPLETYPE)];
         if (tempUnaligned == nullptr)
         {
             ST_THROW_RT_ERROR("Couldn't allocate memory!\n");
@@ -176,19 +328,67 @@ void FIFOSampleBuffer::ensureCapacity(uint capacityRequirement)
         {
             memcpy(temp, ptrBegin(), samplesInBuffer * channels * sizeof(SAMPLETYPE));
         }
-        delete[] bufferUnaligned;
+        releaseBuffer();
+        sizeInBytes = newSizeInBytes;
         buffer = temp;
         bufferUnaligned = tempUnaligned;
         bufferPos = 0;
     }
-    else
+    else if (bufferPos + capacityRequirement > getCapacity())
     {
-        // simply rewind the buffer (if necessary)
+        // rewind the buffer only when the requested room doesn't fit after the
+        // current content (never the case in mirrored mode)
         rewind();
     }
 }
 
 
+// Moves the buffer contents into a new mirrored ring of at least
+// 'capacityRequirement' samples. Returns false if mirroring isn't available,
+// in which case the buffer is left untouched.
+bool FIFOSampleBuffer::allocMirrored(uint capacityRequirement)
+{
+    SAMPLETYPE *temp;
+    uint frameBytes, unit, bytes;
+
+    // the ring size has to be a whole number of both pages and sample frames
+    frameBytes = channels * sizeof(SAMPLETYPE);
+    unit = mirrorPageSize();
+    while (unit % frameBytes) unit += mirrorPageSize();
+    bytes = ((capacityRequirement * frameBytes + unit - 1) / unit) * unit;
+
+    temp = (SAMPLETYPE *)mirrorMap(bytes);
+    if (temp == nullptr) return false;
+
+    if (samplesInBuffer)
+    {
+        memcpy(temp, ptrBegin(), samplesInBuffer * frameBytes);
+    }
+    releaseBuffer();
+    buffer = temp;
+    sizeInBytes = bytes;
+    mirrored = true;
+    bufferPos = 0;
+    return true;
+}
+
+
+// Preallocates room for at least 'capacity' samples and switches the buffer
+// into the mirrored ring mode where available.
+void FIFOSampleBuffer::reserve(uint capacity)
+{
+    reservedSamples = capacity;
+    if (capacity < samplesInBuffer) capacity = samplesInBuffer;
+    if (mirrored && (capacity <= getCapacity())) return;
+
+    if (!allocMirrored(capacity))
+    {
+        // no mirroring on this platform, preallocate the linear buffer instead
+        ensureCapacity(capacity);
+    }
+}
+
+
 // Returns the current buffer capacity in terms of samples
 uint FIFOSampleBuffer::getCapacity() const
 {
@@ -230,11 +430,17 @@ uint FIFOSampleBuffer::receiveSamples(uint maxSamples)
 
         temp = samplesInBuffer;
         samplesInBuffer = 0;
+        bufferPos = 0;
         return temp;
     }
 
     samplesInBuffer -= maxSamples;
     bufferPos += maxSamples;
+    if (mirrored && (bufferPos >= getCapacity()))
+    {
+        // wrap around the ring; the data stays contiguous thanks to the mirror
+        bufferPos -= getCapacity();
+    }
 
     return maxSamples;
 }
@@ -0,0 +1,431 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// Sample interpolation routine using a table-driven polyphase windowed-sinc
+/// filter. The anti-alias lowpass is folded into the interpolation kernel, so
+/// that rate transposing takes a single pass instead of interpolation followed
+/// by a separate anti-alias FIR filter.
+///
+/// The kernel is tabulated for a fixed number of sub-sample phases, and the
+/// coefficients for the exact fractional position are linearly interpolated
+/// between two adjacent phases. The tap count is configurable (8 .. 128).
+///
+/// Author        : Copyright (c) Olli Parviainen
+/// Author e-mail : oparviai 'at' iki.fi
+/// SoundTouch WWW: http://www.surina.net/soundtouch
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <math.h>
+#include <assert.h>
+#include "InterpolatePolyphase.h"
+#include "STTypes.h"
+
+using namespace soundtouch;
+
+/// Number of tabulated sub-sample phases. Coefficients between two phases are
+/// interpolated linearly, which keeps the error below the kaiser stopband level.
+#define POLYPHASE_PHASES        256
+
+#define POLYPHASE_MIN_TAPS      8
+#define POLYPHASE_MAX_TAPS      128
+#define POLYPHASE_DEFAULT_TAPS  32
+
+/// Cutoff frequencies are rounded down to this grid, so that small rate steps
+/// (e.g. pitch ramps) don't redesign the kernel every time
+#define POLYPHASE_CUTOFF_STEPS  1024
+
+#define PI 3.14159265358979323846
+
+#if defined(SOUNDTOUCH_FLOAT_SAMPLES) && defined(__GNUC__)
+    // Compiler vector extensions (gcc & clang), compiled to SSE on x86 and to
+    // NEON on ARM. Other compilers use the plain loops and autovectorization.
+    #define POLYPHASE_VECTORS   1
+
+    typedef float v4sf __attribute__((vector_size(16)));
+    // unaligned loads of source samples
+    typedef float v4sf_u __attribute__((vector_size(16), aligned(4), __may_alias__));
+
+    #ifdef __clang__
+        #define V4SF_PAIRS_LOW(x)   __builtin_shufflevector(x, x, 0, 0, 1, 1)
+        #define V4SF_PAIRS_HIGH(x)  __builtin_shufflevector(x, x, 2, 2, 3, 3)
+    #else
+        typedef int v4si __attribute__((vector_size(16)));
+        #define V4SF_PAIRS_LOW(x)   __builtin_shuffle(x, (v4si){0, 0, 1, 1})
+        #define V4SF_PAIRS_HIGH(x)  __builtin_shuffle(x, (v4si){2, 2, 3, 3})
+    #endif
+#endif
+
+
+/// Zeroth order modified Bessel function of the first kind
+static double besselI0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    const double xx = 0.25 * x * x;
+
+    for (int k = 1; k < 50; k ++)
+    {
+        term *= xx / ((double)k * k);
+        sum += term;
+        if (term < sum * 1e-12) break;
+    }
+    return sum;
+}
+
+
+InterpolatePolyphase::InterpolatePolyphase()
+{
+    fract = 0;
+    taps = POLYPHASE_DEFAULT_TAPS;
+    tapCapacity = 0;
+    cutoff = 0.5;
+    kernel = nullptr;
+    kernelUnaligned = nullptr;
+    window = nullptr;
+    weights = nullptr;
+    designWindow();
+}
+
+
+InterpolatePolyphase::~InterpolatePolyphase()
+{
+    delete[] kernelUnaligned;
+    delete[] window;
+    delete[] weights;
+}
+
+
+void InterpolatePolyphase::resetRegisters()
+{
+    fract = 0;
+}
+
+
+// Sets new rate and redesigns the kernel if the anti-alias cutoff changes.
+// When slowing down, the kernel only needs to reject the images above the
+// source Nyquist frequency; when speeding up, the band above 0.5 / rate that
+// would fold over.
+void InterpolatePolyphase::setRate(double newRate)
+{
+    TransposerBase::setRate(newRate);
+
+    double newCutoff = (newRate > 1.0) ? 0.5 / newRate : 0.5;
+    newCutoff = floor(newCutoff * POLYPHASE_CUTOFF_STEPS) / POLYPHASE_CUTOFF_STEPS;
+    if (newCutoff != cutoff)
+    {
+        designKernel(newCutoff);
+    }
+}
+
+
+// Sets the number of filter taps. The value is rounded up to a multiple of 8
+// and limited to 8 .. 128.
+void InterpolatePolyphase::setFilterLength(int newTaps)
+{
+    newTaps = (newTaps + 7) & -8;
+    if (newTaps < POLYPHASE_MIN_TAPS) newTaps = POLYPHASE_MIN_TAPS;
+    if (newTaps > POLYPHASE_MAX_TAPS) newTaps = POLYPHASE_MAX_TAPS;
+    if (newTaps == taps) return;
+
+    taps = newTaps;
+    designWindow();
+}
+
+
+// Calculates kaiser window for every phase row. The stopband attenuation is
+// chosen by tap count, as longer filters can afford a wider main lobe. Tables
+// are reallocated only when the tap count grows beyond earlier maximum.
+void InterpolatePolyphase::designWindow()
+{
+    if (taps > tapCapacity)
+    {
+        delete[] kernelUnaligned;
+        delete[] window;
+        delete[] weights;
+
+        kernelUnaligned = new float[(POLYPHASE_PHASES + 1) * 2 * taps + 16 / sizeof(float)];
+        kernel = (float *)SOUNDTOUCH_ALIGN_POINTER_16(kernelUnaligned);
+        window = new float[(POLYPHASE_PHASES + 1) * taps];
+        weights = new float[2 * taps];
+        tapCapacity = taps;
+    }
+
+    const double atten = (taps >= 32) ? 80.0 : 40.0 + 1.25 * taps;
+    const double beta = 0.1102 * (atten - 8.7);
+    const double scale = 1.0 / besselI0(beta);
+    const int half = taps / 2;
+
+    for (int p = 0; p <= POLYPHASE_PHASES; p ++)
+    {
+        const double frac = (double)p / POLYPHASE_PHASES;
+        float *win = window + taps * p;
+
+        for (int k = 0; k < taps; k ++)
+        {
+            const double t = (k - (half - 1) - frac) / half;
+            const double tt = (t * t < 1.0) ? 1.0 - t * t : 0.0;
+            win[k] = (float)(besselI0(beta * sqrt(tt)) * scale);
+        }
+    }
+
+    designKernel(cutoff);
+}
+
+
+// Calculates windowed-sinc kernel rows for the given cutoff, normalized for
+// unity gain at DC, and the row-to-row differences used for interpolating
+// between phases.
+void InterpolatePolyphase::designKernel(double newCutoff)
+{
+    const int half = taps / 2;
+    const int rowSize = 2 * taps;
+
+    cutoff = newCutoff;
+
+    for (int p = 0; p <= POLYPHASE_PHASES; p ++)
+    {
+        const double frac = (double)p / POLYPHASE_PHASES;
+        const float *win = window + taps * p;
+        float *row = kernel + rowSize * p;
+        double sum = 0;
+
+        for (int k = 0; k < taps; k ++)
+        {
+            const double x = 2.0 * cutoff * (k - (half - 1) - frac);
+            const double h = (fabs(x) < 1e-9) ? 1.0 : sin(PI * x) / (PI * x);
+            row[k] = (float)(h * win[k]);
+            sum += row[k];
+        }
+
+        const float norm = (float)(1.0 / sum);
+        for (int k = 0; k < taps; k ++)
+        {
+            row[k] *= norm;
+        }
+    }
+
+    for (int p = 0; p < POLYPHASE_PHASES; p ++)
+    {
+        float *row = kernel + rowSize * p;
+        const float *next = row + rowSize;
+
+        for (int k = 0; k < taps; k ++)
+        {
+            row[taps + k] = next[k] - row[k];
+        }
+    }
+    float *last = kernel + rowSize * POLYPHASE_PHASES;
+    for (int k = 0; k < taps; k ++)
+    {
+        last[taps + k] = 0;
+    }
+}
+
+
+/// Transpose mono audio. Returns number of produced output samples, and
+/// updates "srcSamples" to amount of consumed source samples
+int InterpolatePolyphase::transposeMono(SAMPLETYPE *pdest,
+                    const SAMPLETYPE *psrc,
+                    int &srcSamples)
+{
+    int i;
+    int srcSampleEnd = srcSamples - taps;
+    int srcCount = 0;
+
+    i = 0;
+    while (srcCount < srcSampleEnd)
+    {
+        assert(fract < 1.0);
+
+        const double pos = fract * POLYPHASE_PHASES;
+        const int phase = (int)pos;
+        const float mu = (float)(pos - phase);
+        const float *c = kernel + 2 * taps * phase;
+        const float *d = c + taps;
+
+#ifdef POLYPHASE_VECTORS
+        const v4sf vmu = {mu, mu, mu, mu};
+        v4sf sum0 = {0, 0, 0, 0};
+        v4sf sum1 = {0, 0, 0, 0};
+
+        for (int k = 0; k < taps; k += 8)
+        {
+            sum0 += (*(const v4sf *)(c + k)     + vmu * *(const v4sf *)(d + k))     * *(const v4sf_u *)(psrc + k);
+            sum1 += (*(const v4sf *)(c + k + 4) + vmu * *(const v4sf *)(d + k + 4)) * *(const v4sf_u *)(psrc + k + 4);
+        }
+        sum0 += sum1;
+        pdest[i] = (sum0[0] + sum0[1]) + (sum0[2] + sum0[3]);
+#else
+        float sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+
+        // four independent sums so that the compiler can vectorize over taps
+        for (int k = 0; k < taps; k += 4)
+        {
+            sum0 += (c[k]     + mu * d[k])     * psrc[k];
+            sum1 += (c[k + 1] + mu * d[k + 1]) * psrc[k + 1];
+            sum2 += (c[k + 2] + mu * d[k + 2]) * psrc[k + 2];
+            sum3 += (c[k + 3] + mu * d[k + 3]) * psrc[k + 3];
+        }
+        pdest[i] = (SAMPLETYPE)((sum0 + sum1) + (sum2 + sum3));
+#endif
+        i ++;
+
+        // update position fraction
+        fract += rate;
+        // update whole positions
+        int whole = (int)fract;
+        fract -= whole;
+        psrc += whole;
+        srcCount += whole;
+    }
+    srcSamples = srcCount;
+    return i;
+}
+
+
+/// Transpose stereo audio. Returns number of produced output samples, and
+/// updates "srcSamples" to amount of consumed source samples
+int InterpolatePolyphase::transposeStereo(SAMPLETYPE *pdest,
+                    const SAMPLETYPE *psrc,
+                    int &srcSamples)
+{
+    int i;
+    int srcSampleEnd = srcSamples - taps;
+    int srcCount = 0;
+
+    i = 0;
+    while (srcCount < srcSampleEnd)
+    {
+        assert(fract < 1.0);
+
+        const double pos = fract * POLYPHASE_PHASES;
+        const int phase = (int)pos;
+        const float mu = (float)(pos - phase);
+        const float *c = kernel + 2 * taps * phase;
+        const float *d = c + taps;
+#ifdef POLYPHASE_VECTORS
+        const v4sf vmu = {mu, mu, mu, mu};
+        v4sf sum0 = {0, 0, 0, 0};
+        v4sf sum1 = {0, 0, 0, 0};
+
+        // four coefficients at a time, paired up against the interleaved
+        // LRLR samples of the same four taps
+        for (int k = 0; k < taps; k += 4)
+        {
+            const v4sf w = *(const v4sf *)(c + k) + vmu * *(const v4sf *)(d + k);
+            sum0 += V4SF_PAIRS_LOW(w)  * *(const v4sf_u *)(psrc + 2 * k);
+            sum1 += V4SF_PAIRS_HIGH(w) * *(const v4sf_u *)(psrc + 2 * k + 4);
+        }
+        sum0 += sum1;
+        pdest[2 * i]     = sum0[0] + sum0[2];
+        pdest[2 * i + 1] = sum0[1] + sum0[3];
+#else
+        float sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+
+        // interpolate the coefficients into pairs matching the interleaved
+        // LRLR samples, so that both loops vectorize without shuffles
+        for (int k = 0; k < taps; k ++)
+        {
+            const float w = c[k] + mu * d[k];
+            weights[2 * k] = w;
+            weights[2 * k + 1] = w;
+        }
+        for (int k = 0; k < 2 * taps; k += 4)
+        {
+            sum0 += weights[k]     * psrc[k];
+            sum1 += weights[k + 1] * psrc[k + 1];
+            sum2 += weights[k + 2] * psrc[k + 2];
+            sum3 += weights[k + 3] * psrc[k + 3];
+        }
+        pdest[2 * i]     = (SAMPLETYPE)(sum0 + sum2);
+        pdest[2 * i + 1] = (SAMPLETYPE)(sum1 + sum3);
+#endif
+        i ++;
+
+        // update position fraction
+        fract += rate;
+        // update whole positions
+        int whole = (int)fract;
+        fract -= whole;
+        psrc += 2 * whole;
+        srcCount += whole;
+    }
+    srcSamples = srcCount;
+    return i;
+}
+
+
+/// Transpose multi-channel audio. Returns number of produced output samples, and
+/// updates "srcSamples" to amount of consumed source samples
+int InterpolatePolyphase::transposeMulti(SAMPLETYPE *pdest,
+                    const SAMPLETYPE *psrc,
+                    int &srcSamples)
+{
+    int i;
+    int srcSampleEnd = srcSamples - taps;
+    int srcCount = 0;
+
+    i = 0;
+    while (srcCount < srcSampleEnd)
+    {
+        assert(fract < 1.0);
+
+        const double pos = fract * POLYPHASE_PHASES;
+        const int phase = (int)pos;
+        const float mu = (float)(pos - phase);
+        const float *c = kernel + 2 * taps * phase;
+        const float *d = c + taps;
+
+        // interpolate the coefficients once for all channels
+        for (int k = 0; k < taps; k ++)
+        {
+            weights[k] = c[k] + mu * d[k];
+        }
+
+        for (int ch = 0; ch < numChannels; ch ++)
+        {
+            const SAMPLETYPE *src = psrc + ch;
+            float sum = 0;
+
+            for (int k = 0; k < taps; k ++)
+            {
+                sum += weights[k] * src[k * numChannels];
+            }
+            *pdest = (SAMPLETYPE)sum;
+            pdest ++;
+        }
+        i ++;
+
+        // update position fraction
+        fract += rate;
+        // update whole positions
+        int whole = (int)fract;
+        fract -= whole;
+        psrc += numChannels * whole;
+        srcCount += whole;
+    }
+    srcSamples = srcCount;
+    return i;
+}
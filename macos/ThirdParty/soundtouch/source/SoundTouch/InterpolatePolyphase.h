@@ -0,0 +1,110 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// Sample interpolation routine using a table-driven polyphase windowed-sinc
+/// filter. The anti-alias lowpass is folded into the interpolation kernel, so
+/// that rate transposing takes a single pass instead of interpolation followed
+/// by a separate anti-alias FIR filter.
+///
+/// The kernel is tabulated for a fixed number of sub-sample phases, and the
+/// coefficients for the exact fractional position are linearly interpolated
+/// between two adjacent phases. The tap count is configurable (8 .. 128).
+///
+/// Author        : Copyright (c) Olli Parviainen
+/// Author e-mail : oparviai 'at' iki.fi
+/// SoundTouch WWW: http://www.surina.net/soundtouch
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _InterpolatePolyphase_H_
+#define _InterpolatePolyphase_H_
+
+#include "RateTransposer.h"
+#include "STTypes.h"
+
+namespace soundtouch
+{
+
+class InterpolatePolyphase : public TransposerBase
+{
+protected:
+    int transposeMono(SAMPLETYPE *dest,
+                        const SAMPLETYPE *src,
+                        int &srcSamples) override;
+    int transposeStereo(SAMPLETYPE *dest,
+                        const SAMPLETYPE *src,
+                        int &srcSamples) override;
+    int transposeMulti(SAMPLETYPE *dest,
+                        const SAMPLETYPE *src,
+                        int &srcSamples) override;
+
+    /// Allocates the tables for 'taps' and calculates the window table
+    void designWindow();
+
+    /// Calculates the kernel table for lowpass cutoff 'newCutoff'
+    void designKernel(double newCutoff);
+
+    double fract;
+
+    /// Number of filter taps, multiple of 8
+    int taps;
+
+    /// Tap count the tables have been allocated for
+    int tapCapacity;
+
+    /// Lowpass cutoff of the current kernel, relative to source sample rate
+    double cutoff;
+
+    /// Kernel table, one row per phase: 'taps' coefficients followed by 'taps'
+    /// differences to the next phase row
+    float *kernel;
+    float *kernelUnaligned;
+
+    /// Kaiser window for each phase row
+    float *window;
+
+    /// Scratch buffer for the interpolated coefficients of one output sample
+    float *weights;
+
+public:
+    InterpolatePolyphase();
+    ~InterpolatePolyphase() override;
+
+    void resetRegisters() override;
+    void setRate(double newRate) override;
+    void setFilterLength(int newTaps) override;
+
+    bool isBandLimited() const override
+    {
+        return true;
+    }
+
+    int getLatency() const override
+    {
+        return taps / 2 - 1;
+    }
+};
+
+}
+
+#endif
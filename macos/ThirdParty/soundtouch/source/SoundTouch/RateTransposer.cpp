@@ -39,6 +39,7 @@
 #include "InterpolateLinear.h"
 #include "InterpolateCubic.h"
 #include "InterpolateShannon.h"
+#include "InterpolatePolyphase.h"
 #include "AAFilter.h"
 
 using namespace soundtouch;
@@ -60,7 +61,9 @@ RateTransposer::RateTransposer() : FIFOProcessor(&outputBuffer)
 
     // Instantiates the anti-alias filter
     pAAFilter = new AAFilter(64);
-    pTransposer = TransposerBase::newInstance();
+    algorithm = TransposerBase::getAlgorithm();
+    pTransposer = TransposerBase::newInstance(algorithm);
+    pTransposer->setFilterLength((int)pAAFilter->getLength());
     clear();
 }
 
@@ -96,6 +99,37 @@ AAFilter *RateTransposer::getAAFilter()
 }
 
 
+// Sets the anti-alias filter length, for both the separate filter and a
+// transposer that band-limits by itself
+void RateTransposer::setAAFilterLength(uint newLength)
+{
+    pAAFilter->setLength(newLength);
+    pTransposer->setFilterLength((int)newLength);
+}
+
+
+// Changes the interpolation algorithm. The new transposer inherits the current
+// rate, channel count and filter length.
+void RateTransposer::setAlgorithm(TransposerBase::ALGORITHM a)
+{
+    TransposerBase *pNew = TransposerBase::newInstance(a);
+    pNew->setChannels(pTransposer->numChannels);
+    pNew->setFilterLength((int)pAAFilter->getLength());
+    pNew->setRate(pTransposer->rate);
+
+    delete pTransposer;
+    pTransposer = pNew;
+    algorithm = a;
+    clear();
+}
+
+
+TransposerBase::ALGORITHM RateTransposer::getAlgorithm() const
+{
+    return algorithm;
+}
+
+
 // Sets new target iRate. Normal iRate = 1.0, smaller values represent slower
 // iRate, larger faster iRates.
 void RateTransposer::setRate(double newRate)
@@ -135,10 +169,34 @@ void RateTransposer::processSamples(const SAMPLETYPE *src, uint nSamples)
 
     // Store samples to input buffer
     inputBuffer.putSamples(src, nSamples);
+    processInput();
+}
+
 
-    // If anti-alias filter is turned off, simply transpose without applying
-    // the filter
-    if (bUseAAFilter == false)
+// Processes samples written directly to the input buffer via 'inputSpan'.
+void RateTransposer::commitInput(uint nSamples)
+{
+    if (nSamples == 0) return;
+
+    inputBuffer.putSamples(nSamples);
+    processInput();
+}
+
+
+// Preallocates the internal sample buffers.
+void RateTransposer::reserveBuffers(uint nSamples)
+{
+    inputBuffer.reserve(nSamples);
+    midBuffer.reserve(nSamples);
+    outputBuffer.reserve(nSamples);
+}
+
+
+void RateTransposer::processInput()
+{
+    // If anti-alias filter is turned off, or the transposer band-limits by
+    // itself, simply transpose without applying the filter
+    if ((bUseAAFilter == false) || pTransposer->isBandLimited())
     {
         (void)pTransposer->transpose(outputBuffer, inputBuffer);
         return;
@@ -215,7 +273,7 @@ int RateTransposer::isEmpty() const
 int RateTransposer::getLatency() const
 {
     return pTransposer->getLatency() +
-        ((bUseAAFilter) ? (pAAFilter->getLength() / 2) : 0);
+        ((bUseAAFilter && !pTransposer->isBandLimited()) ? (pAAFilter->getLength() / 2) : 0);
 }
 
 
@@ -231,6 +289,13 @@ void TransposerBase::setAlgorithm(TransposerBase::ALGORITHM a)
 }
 
 
+// static function to get interpolation algorithm
+TransposerBase::ALGORITHM TransposerBase::getAlgorithm()
+{
+    return TransposerBase::algorithm;
+}
+
+
 // Transposes the sample rate of the given samples using linear interpolation.
 // Returns the number of samples returned in the "dest" buffer
 int TransposerBase::transpose(FIFOSampleBuffer &dest, FIFOSampleBuffer &src)
@@ -289,12 +354,20 @@ void TransposerBase::setRate(double newRate)
 
 // static factory function
 TransposerBase *TransposerBase::newInstance()
+{
+    return newInstance(algorithm);
+}
+
+
+// static factory function for the given algorithm
+TransposerBase *TransposerBase::newInstance(TransposerBase::ALGORITHM a)
 {
 #ifdef SOUNDTOUCH_INTEGER_SAMPLES
     // Notice: For integer arithmetic support only linear algorithm (due to simplest calculus)
+    (void)a;
     return ::new InterpolateLinearInteger;
 #else
-    switch (algorithm)
+    switch (a)
     {
         case LINEAR:
             return new InterpolateLinearFloat;
@@ -305,6 +378,9 @@ TransposerBase *TransposerBase::newInstance()
         case SHANNON:
             return new InterpolateShannon;
 
+        case POLYPHASE:
+            return new InterpolatePolyphase;
+
         default:
             assert(false);
             return nullptr;
@@ -55,7 +55,8 @@ public:
         enum ALGORITHM {
         LINEAR = 0,
         CUBIC,
-        SHANNON
+        SHANNON,
+        POLYPHASE
     };
 
 protected:
@@ -85,11 +86,22 @@ public:
 
     virtual void resetRegisters() = 0;
 
-    // static factory function
+    /// Returns true if the transposer band-limits the signal by itself, so that
+    /// the separate anti-alias filter pass isn't needed
+    virtual bool isBandLimited() const { return false; }
+
+    /// Sets the filter length of band-limiting transposers
+    virtual void setFilterLength(int) {}
+
+    // static factory functions, for the default or the given algorithm
     static TransposerBase *newInstance();
+    static TransposerBase *newInstance(ALGORITHM a);
 
     // static function to set interpolation algorithm
     static void setAlgorithm(ALGORITHM a);
+
+    // static function to get interpolation algorithm
+    static ALGORITHM getAlgorithm();
 };
 
 
@@ -114,6 +126,9 @@ protected:
 
     bool bUseAAFilter;
 
+    /// Interpolation algorithm of this instance
+    TransposerBase::ALGORITHM algorithm;
+
 
     /// Transposes sample rate by applying anti-alias filter to prevent folding.
     /// Returns amount of samples returned in the "dest" buffer.
@@ -122,6 +137,9 @@ protected:
     void processSamples(const SAMPLETYPE *src,
                         uint numSamples);
 
+    /// Transposes the samples currently in 'inputBuffer' into 'outputBuffer'.
+    void processInput();
+
 public:
     RateTransposer();
     virtual ~RateTransposer() override;
@@ -138,6 +156,18 @@ public:
     /// Returns nonzero if anti-alias filter is enabled.
     bool isAAFilterEnabled() const;
 
+    /// Sets the anti-alias filter length. Also sets the tap count of a
+    /// band-limiting transposer (see TransposerBase::isBandLimited).
+    void setAAFilterLength(uint newLength);
+
+    /// Changes the interpolation algorithm of this transposer and clears the
+    /// processing pipeline. Doesn't affect the default of other instances,
+    /// see TransposerBase::setAlgorithm.
+    void setAlgorithm(TransposerBase::ALGORITHM a);
+
+    /// Returns the interpolation algorithm of this transposer
+    TransposerBase::ALGORITHM getAlgorithm() const;
+
     /// Sets new target rate. Normal rate = 1.0, smaller values represent slower
     /// rate, larger faster rates.
     virtual void setRate(double newRate);
@@ -149,6 +179,18 @@ public:
     /// the input of the object.
     void putSamples(const SAMPLETYPE *samples, uint numSamples) override;
 
+    /// Returns a pointer to the end of the input buffer with room for at least
+    /// 'slackCapacity' samples. Write samples there directly and then call
+    /// 'commitInput' to process them without an intermediate copy.
+    SAMPLETYPE *inputSpan(uint slackCapacity) { return inputBuffer.ptrEnd(slackCapacity); }
+
+    /// Processes 'numSamples' samples written to the pointer from 'inputSpan'.
+    void commitInput(uint numSamples);
+
+    /// Preallocates each internal sample buffer for 'numSamples' samples,
+    /// see FIFOSampleBuffer::reserve.
+    void reserveBuffers(uint numSamples);
+
     /// Clears all the samples in the object
     void clear() override;
 
@@ -308,6 +308,60 @@ void SoundTouch::putSamples(const SAMPLETYPE *samples, uint nSamples)
 }
 
 
+// Returns a writable pointer to the input buffer of the first processing stage,
+// i.e. the same stage that 'putSamples' feeds for the current rate.
+SAMPLETYPE *SoundTouch::inputSpan(uint maxSamples)
+{
+#ifndef SOUNDTOUCH_PREVENT_CLICK_AT_RATE_CROSSOVER
+    if (rate <= 1.0f)
+    {
+        return pRateTransposer->inputSpan(maxSamples);
+    }
+#endif
+    return pTDStretch->inputSpan(maxSamples);
+}
+
+
+// Processes samples written via 'inputSpan' - same pipeline as 'putSamples'.
+void SoundTouch::commitInput(uint nSamples)
+{
+    if (bSrateSet == false)
+    {
+        ST_THROW_RT_ERROR("SoundTouch : Sample rate not defined");
+    }
+    else if (channels == 0)
+    {
+        ST_THROW_RT_ERROR("SoundTouch : Number of channels not defined");
+    }
+    if (nSamples == 0) return;
+
+    samplesExpectedOut += (double)nSamples / ((double)rate * (double)tempo);
+
+#ifndef SOUNDTOUCH_PREVENT_CLICK_AT_RATE_CROSSOVER
+    if (rate <= 1.0f)
+    {
+        assert(output == pTDStretch);
+        pRateTransposer->commitInput(nSamples);
+        pTDStretch->moveSamples(*pRateTransposer);
+    }
+    else
+#endif
+    {
+        assert(output == pRateTransposer);
+        pTDStretch->commitInput(nSamples);
+        pRateTransposer->moveSamples(*pTDStretch);
+    }
+}
+
+
+// Preallocates the sample buffers of both processing stages.
+void SoundTouch::reserveBuffers(uint numSamples)
+{
+    pRateTransposer->reserveBuffers(numSamples);
+    pTDStretch->reserveBuffers(numSamples);
+}
+
+
 // Flushes the last samples from the processing pipeline to the output.
 // Clears also the internal processing buffers.
 //
@@ -364,7 +418,7 @@ bool SoundTouch::setSetting(int settingId, int value)
 
         case SETTING_AA_FILTER_LENGTH :
             // sets anti-alias filter length
-            pRateTransposer->getAAFilter()->setLength(value);
+            pRateTransposer->setAAFilterLength((uint)value);
             return true;
 
         case SETTING_USE_QUICKSEEK :
@@ -372,6 +426,22 @@ bool SoundTouch::setSetting(int settingId, int value)
             pTDStretch->enableQuickSeek((value != 0) ? true : false);
             return true;
 
+        case SETTING_USE_PYRAMIDSEEK :
+            // enables / disables tempo routine coarse-to-fine seeking algorithm
+            pTDStretch->enablePyramidSeek((value != 0) ? true : false);
+            return true;
+
+        case SETTING_TRANSPOSER_ALGORITHM :
+#ifdef SOUNDTOUCH_INTEGER_SAMPLES
+            // integer arithmetic supports only linear interpolation
+            return (value == TransposerBase::LINEAR);
+#else
+            // changes the pitch transposer interpolation algorithm
+            if ((value < TransposerBase::LINEAR) || (value > TransposerBase::POLYPHASE)) return false;
+            pRateTransposer->setAlgorithm((TransposerBase::ALGORITHM)value);
+            return true;
+#endif
+
         case SETTING_SEQUENCE_MS:
             // change time-stretch sequence duration parameter
             pTDStretch->setParameters(sampleRate, value, seekWindowMs, overlapMs);
@@ -412,6 +482,16 @@ int SoundTouch::getSetting(int settingId) const
         case SETTING_USE_QUICKSEEK :
             return (uint)pTDStretch->isQuickSeekEnabled();
 
+        case SETTING_USE_PYRAMIDSEEK :
+            return (uint)pTDStretch->isPyramidSeekEnabled();
+
+        case SETTING_TRANSPOSER_ALGORITHM :
+#ifdef SOUNDTOUCH_INTEGER_SAMPLES
+            return TransposerBase::LINEAR;
+#else
+            return pRateTransposer->getAlgorithm();
+#endif
+
         case SETTING_SEQUENCE_MS:
             pTDStretch->getParameters(nullptr, &temp, nullptr, nullptr);
             return temp;
@@ -64,14 +64,23 @@ using namespace soundtouch;
 TDStretch::TDStretch() : FIFOProcessor(&outputBuffer)
 {
     bQuickSeek = false;
+    bPyramidSeek = false;
     channels = 2;
 
     pMidBuffer = nullptr;
     pMidBufferUnaligned = nullptr;
+    midBufferSize = 0;
+    pPyramidRef = nullptr;
+    pPyramidMid = nullptr;
+    pPyramidCorr = nullptr;
+    pPyramidEnergy = nullptr;
+    pyramidCapacity = 0;
     overlapLength = 0;
 
     bAutoSeqSetting = true;
     bAutoSeekSetting = true;
+    isBeginning = true;
+    bOverlapPending = false;
 
     tempo = 1.0f;
     setParameters(44100, DEFAULT_SEQUENCE_MS, DEFAULT_SEEKWINDOW_MS, DEFAULT_OVERLAP_MS);
@@ -85,6 +94,8 @@ TDStretch::TDStretch() : FIFOProcessor(&outputBuffer)
 TDStretch::~TDStretch()
 {
     delete[] pMidBufferUnaligned;
+    delete[] pPyramidRef;
+    delete[] pPyramidEnergy;
 }
 
 
@@ -134,7 +145,19 @@ void TDStretch::setParameters(int aSampleRate, int aSequenceMS,
 
     calcSeqParameters();
 
-    calculateOverlapLength(overlapMs);
+    preallocate();
+
+    if (isBeginning)
+    {
+        calculateOverlapLength(overlapMs);
+        bOverlapPending = false;
+    }
+    else
+    {
+        // in the middle of a stream, the tail for the next overlap has already been
+        // taken with the current length: switch at the next sequence boundary instead
+        bOverlapPending = (overlapLengthFor(overlapMs) != overlapLength);
+    }
 
     // set tempo to recalculate 'sampleReq'
     setTempo(tempo);
@@ -196,6 +219,13 @@ void TDStretch::clearMidBuffer()
 
 void TDStretch::clearInput()
 {
+    if (bOverlapPending)
+    {
+        // no tail to carry over, so take the new overlap length into use right away
+        calculateOverlapLength(overlapMs);
+        bOverlapPending = false;
+        setTempo(tempo);
+    }
     inputBuffer.clear();
     clearMidBuffer();
     isBeginning = true;
@@ -229,10 +259,28 @@ bool TDStretch::isQuickSeekEnabled() const
 }
 
 
+// Enables/disables the coarse-to-fine position seeking algorithm.
+void TDStretch::enablePyramidSeek(bool enable)
+{
+    bPyramidSeek = enable;
+}
+
+
+// Returns nonzero if the coarse-to-fine seeking algorithm is enabled.
+bool TDStretch::isPyramidSeekEnabled() const
+{
+    return bPyramidSeek;
+}
+
+
 // Seeks for the optimal overlap-mixing position.
 int TDStretch::seekBestOverlapPosition(const SAMPLETYPE *refPos)
 {
-    if (bQuickSeek)
+    if (bPyramidSeek)
+    {
+        return seekBestOverlapPositionPyramid(refPos);
+    }
+    else if (bQuickSeek)
     {
         return seekBestOverlapPositionQuick(refPos);
     }
@@ -454,6 +502,173 @@ int TDStretch::seekBestOverlapPositionQuick(const SAMPLETYPE *refPos)
 }
 
 
+// Decimation factor of the coarse pass of the coarse-to-fine seek
+#define PYRAMID_DECIM       4
+// Number of coarse correlation peaks that get refined at full resolution
+#define PYRAMID_CANDIDATES  3
+
+// Coarse-to-fine seek algorithm: First computes the whole correlation curve on a mono
+// downmix that is decimated by PYRAMID_DECIM, normalizing every offset by the reference
+// energy taken from prefix sums, and then scans the surroundings of the best coarse
+// peaks at full resolution with the same scoring as the full algorithm.
+//
+// The coarse pass costs about 1/(2 * PYRAMID_DECIM^2) of the full search (stereo), so
+// the total is in the same range as the quick seek, while the coarse pass still sees
+// every offset of the seek range.
+int TDStretch::seekBestOverlapPositionPyramid(const SAMPLETYPE *refPos)
+{
+    int bestOffs;
+    double bestCorr;
+    int i, k, c;
+    double norm;
+
+    const int coarseOvl = overlapLength / PYRAMID_DECIM;
+    const int coarseSeek = seekLength / PYRAMID_DECIM;
+    const int coarseRef = coarseSeek + coarseOvl;
+
+    if ((coarseOvl < 8) || (coarseSeek < 3))
+    {
+        // too short ranges to decimate meaningfully
+        return seekBestOverlapPositionFull(refPos);
+    }
+    assert(coarseRef <= pyramidCapacity);
+
+    // Decimated mono downmix: plain sum over channels and PYRAMID_DECIM frames
+    // acts as a (crude) low-pass before decimating
+    for (k = 0; k < coarseRef; k ++)
+    {
+        const SAMPLETYPE *src = refPos + channels * PYRAMID_DECIM * k;
+        float sum = 0;
+        for (i = 0; i < channels * PYRAMID_DECIM; i ++)
+        {
+            sum += (float)src[i];
+        }
+        pPyramidRef[k] = sum;
+    }
+    for (k = 0; k < coarseOvl; k ++)
+    {
+        const SAMPLETYPE *src = pMidBuffer + channels * PYRAMID_DECIM * k;
+        float sum = 0;
+        for (i = 0; i < channels * PYRAMID_DECIM; i ++)
+        {
+            sum += (float)src[i];
+        }
+        pPyramidMid[k] = sum;
+    }
+
+    // Energy prefix sums of the decimated reference, so that the norm of any
+    // coarse window is a single subtraction
+    pPyramidEnergy[0] = 0;
+    for (k = 0; k < coarseRef; k ++)
+    {
+        pPyramidEnergy[k + 1] = pPyramidEnergy[k] + (double)pPyramidRef[k] * pPyramidRef[k];
+    }
+
+    // Coarse correlation curve over the whole seek range
+    for (k = 0; k < coarseSeek; k ++)
+    {
+        const float *ref = pPyramidRef + k;
+        float corr = 0;
+        for (i = 0; i < coarseOvl; i ++)
+        {
+            corr += ref[i] * pPyramidMid[i];
+        }
+        double energy = pPyramidEnergy[k + coarseOvl] - pPyramidEnergy[k];
+        double corrNorm = corr / sqrt((energy < 1e-9) ? 1.0 : energy);
+
+        // same heuristic rule as in the full algorithm to favour the mid of the range
+        double tmp = (double)(2 * PYRAMID_DECIM * k - seekLength) / (double)seekLength;
+        pPyramidCorr[k] = (float)(corrNorm * (1.0 - 0.25 * tmp * tmp));
+    }
+
+    // Pick the best local peaks of the coarse curve
+    int cand[PYRAMID_CANDIDATES];
+    float candCorr[PYRAMID_CANDIDATES];
+    for (c = 0; c < PYRAMID_CANDIDATES; c ++)
+    {
+        cand[c] = -1;
+        candCorr[c] = -FLT_MAX;
+    }
+    for (k = 0; k < coarseSeek; k ++)
+    {
+        const float corr = pPyramidCorr[k];
+        if ((k > 0 && corr < pPyramidCorr[k - 1]) ||
+            (k < coarseSeek - 1 && corr <= pPyramidCorr[k + 1]))
+        {
+            continue;   // not a local peak
+        }
+        for (c = 0; c < PYRAMID_CANDIDATES; c ++)
+        {
+            if (corr > candCorr[c])
+            {
+                for (int m = PYRAMID_CANDIDATES - 1; m > c; m --)
+                {
+                    cand[m] = cand[m - 1];
+                    candCorr[m] = candCorr[m - 1];
+                }
+                cand[c] = k;
+                candCorr[c] = corr;
+                break;
+            }
+        }
+    }
+
+    // Refine around the peaks at full resolution
+    bestCorr = -FLT_MAX;
+    bestOffs = 0;
+    for (c = 0; c < PYRAMID_CANDIDATES; c ++)
+    {
+        if (cand[c] < 0) break;
+
+        const int center = cand[c] * PYRAMID_DECIM;
+        const int begin = max(center - PYRAMID_DECIM, 0);
+        const int end = _MIN(center + 2 * PYRAMID_DECIM, seekLength);
+        for (i = begin; i < end; i ++)
+        {
+            double corr = calcCrossCorr(refPos + channels * i, pMidBuffer, norm);
+            // heuristic rule to slightly favour values close to mid of the range
+            double tmp = (double)(2 * i - seekLength) / (double)seekLength;
+            corr = ((corr + 0.1) * (1.0 - 0.25 * tmp * tmp));
+
+            if (corr > bestCorr)
+            {
+                bestCorr = corr;
+                bestOffs = i;
+            }
+        }
+    }
+
+#ifdef SOUNDTOUCH_INTEGER_SAMPLES
+    adaptNormalizer();
+#endif
+
+    // clear cross correlation routine state if necessary (is so e.g. in MMX routines).
+    clearCrossCorrState();
+
+    return bestOffs;
+}
+
+
+/// Grows the coarse-to-fine seek scratch buffers to fit the given seek & overlap
+/// lengths, so that the seek routine itself doesn't allocate.
+void TDStretch::reservePyramidBuffers(int maxSeekLength, int maxOverlapLength)
+{
+    int need = (maxSeekLength + maxOverlapLength) / PYRAMID_DECIM + 1;
+
+    if (need > pyramidCapacity)
+    {
+        delete[] pPyramidRef;
+        delete[] pPyramidEnergy;
+
+        pPyramidRef = new float[3 * need];
+        pPyramidMid = pPyramidRef + need;
+        pPyramidCorr = pPyramidMid + need;
+        pPyramidEnergy = new double[need + 1];
+        pyramidCapacity = need;
+    }
+}
+
+
 
 
 /// For integer algorithm: adapt normalization factor divider with music so that
@@ -537,6 +752,8 @@ void TDStretch::calcSeqParameters()
         seekWindowLength = 2 * overlapLength;
     }
     seekLength = (sampleRate * seekWindowMs) / 1000;
+
+    reservePyramidBuffers(seekLength, overlapLength);
 }
 
 
@@ -574,9 +791,12 @@ void TDStretch::setChannels(int numChannels)
     inputBuffer.setChannels(channels);
     outputBuffer.setChannels(channels);
 
-    // re-init overlap/buffer
-    overlapLength=0;
-    setParameters(sampleRate);
+    // re-init overlap/buffer, the previous tail is meaningless with another channel count
+    preallocate();
+    calculateOverlapLength(overlapMs);
+    bOverlapPending = false;
+    clearMidBuffer();
+    setTempo(tempo);
 }
 
 
@@ -684,6 +904,10 @@ void TDStretch::processSamples()
 
         // length of sequence
         temp = (seekWindowLength - 2 * overlapLength);
+        if (bOverlapPending)
+        {
+            temp = switchOverlapLength(offset, temp);
+        }
         outputBuffer.putSamples(inputBuffer.ptrBegin() + channels * offset, (uint)temp);
 
         // Copies the end of the current sequence from 'inputBuffer' to
@@ -715,26 +939,91 @@ void TDStretch::putSamples(const SAMPLETYPE *samples, uint nSamples)
 }
 
 
+// Processes samples written directly to the input buffer via 'inputSpan'.
+void TDStretch::commitInput(uint nSamples)
+{
+    inputBuffer.putSamples(nSamples);
+    processSamples();
+}
+
+
+// Preallocates the input & output sample buffers.
+void TDStretch::reserveBuffers(uint nSamples)
+{
+    inputBuffer.reserve(nSamples);
+    outputBuffer.reserve(nSamples);
+}
+
+
 
-/// Set new overlap length parameter & reallocate RefMidBuffer if necessary.
+/// Set new overlap length parameter & reallocate MidBuffer if it exceeds the
+/// preallocated size.
 void TDStretch::acceptNewOverlapLength(int newOverlapLength)
 {
-    int prevOvl;
-
     assert(newOverlapLength >= 0);
-    prevOvl = overlapLength;
     overlapLength = newOverlapLength;
 
-    if (overlapLength > prevOvl)
+    reserveMidBuffer(overlapLength);
+    reservePyramidBuffers(seekLength, overlapLength);
+}
+
+
+/// Grows 'pMidBuffer' to hold at least 'maxOverlapLength' samples. The buffer
+/// content is lost when it grows.
+void TDStretch::reserveMidBuffer(int maxOverlapLength)
+{
+    if (maxOverlapLength * channels > midBufferSize)
     {
         delete[] pMidBufferUnaligned;
 
-        pMidBufferUnaligned = new SAMPLETYPE[overlapLength * channels + 16 / sizeof(SAMPLETYPE)];
+        midBufferSize = maxOverlapLength * channels;
+        pMidBufferUnaligned = new SAMPLETYPE[midBufferSize + 16 / sizeof(SAMPLETYPE)];
         // ensure that 'pMidBuffer' is aligned to 16 byte boundary for efficiency
         pMidBuffer = (SAMPLETYPE *)SOUNDTOUCH_ALIGN_POINTER_16(pMidBufferUnaligned);
 
-        clearMidBuffer();
+        memset(pMidBuffer, 0, midBufferSize * sizeof(SAMPLETYPE));
+    }
+}
+
+
+/// Preallocates the overlap & seek work buffers for the current sample rate and
+/// channel count, up to TDSTRETCH_PREALLOC_... or the current settings if larger.
+void TDStretch::preallocate()
+{
+    int maxOvl = overlapLengthFor(max(overlapMs, TDSTRETCH_PREALLOC_OVERLAP_MS));
+    int maxSeek = (sampleRate * max(seekWindowMs, TDSTRETCH_PREALLOC_SEEKWINDOW_MS)) / 1000;
+
+    reserveMidBuffer(maxOvl);
+    reservePyramidBuffers(maxSeek, maxOvl);
+}
+
+
+/// Takes the pending overlap length into use at a sequence boundary. 'offset' is
+/// the input position where the sequence continues after the overlap-add and
+/// 'seqLength' the sequence length for the current overlap length.
+///
+/// The end of the current sequence, i.e. end of the tail for the next overlap,
+/// stays where it is and the tail is taken at the new length just before it, so
+/// the output continues seamlessly. Returns the adjusted sequence length.
+int TDStretch::switchOverlapLength(int offset, int seqLength)
+{
+    int seqEnd = offset + seqLength + overlapLength;
+    int newOvl = overlapLengthFor(overlapMs);
+
+    // a tail longer than the whole sequence extends past its end
+    seqEnd = max(seqEnd, offset + newOvl);
+    if (seqEnd > (int)inputBuffer.numSamples())
+    {
+        // not enough input for that, retry at the next sequence boundary
+        return seqLength;
     }
+
+    calculateOverlapLength(overlapMs);
+    bOverlapPending = false;
+    // recalculate sequence lengths & 'sampleReq' for the new overlap length
+    setTempo(tempo);
+
+    return seqEnd - offset - overlapLength;
 }
 
 
@@ -755,7 +1044,20 @@ TDStretch * TDStretch::newInstance()
     uExtensions = detectCPUextensions();
     (void)uExtensions;
 
-    // Check if MMX/SSE instruction set extensions supported by CPU
+    // Check if MMX/SSE/AVX instruction set extensions supported by CPU
+
+#ifdef SOUNDTOUCH_ALLOW_AVX
+    // widest available vector routines first
+    if (uExtensions & SUPPORT_AVX512)
+    {
+        return ::new TDStretchAVX512;
+    }
+    else if (uExtensions & SUPPORT_AVX2)
+    {
+        return ::new TDStretchAVX2;
+    }
+    else
+#endif // SOUNDTOUCH_ALLOW_AVX
 
 #ifdef SOUNDTOUCH_ALLOW_MMX
     // MMX routines available only with integer sample types
@@ -834,6 +1136,23 @@ static int _getClosest2Power(double value)
 }
 
 
+/// Returns the overlap period length in samples for the given milliseconds.
+/// Integer version rounds overlap length to closest power of 2
+/// for a divide scaling operation.
+int TDStretch::overlapLengthFor(int aoverlapMs) const
+{
+    int bits;
+
+    // calculate overlap length so that it's power of 2 - thus it's easy to do
+    // integer division by right-shifting. Term "-1" at end is to account for
+    // the extra most significatnt bit left unused in result by signed multiplication
+    bits = _getClosest2Power((sampleRate * aoverlapMs) / 1000.0) - 1;
+    if (bits > 9) bits = 9;
+    if (bits < 3) bits = 3;
+    return (int)pow(2.0, bits + 1);    // +1 => account for -1 above
+}
+
+
 /// Calculates overlap period length in samples.
 /// Integer version rounds overlap length to closest power of 2
 /// for a divide scaling operation.
@@ -843,13 +1162,8 @@ void TDStretch::calculateOverlapLength(int aoverlapMs)
 
     assert(aoverlapMs >= 0);
 
-    // calculate overlap length so that it's power of 2 - thus it's easy to do
-    // integer division by right-shifting. Term "-1" at end is to account for
-    // the extra most significatnt bit left unused in result by signed multiplication
-    overlapDividerBitsPure = _getClosest2Power((sampleRate * aoverlapMs) / 1000.0) - 1;
-    if (overlapDividerBitsPure > 9) overlapDividerBitsPure = 9;
-    if (overlapDividerBitsPure < 3) overlapDividerBitsPure = 3;
-    newOvl = (int)pow(2.0, (int)overlapDividerBitsPure + 1);    // +1 => account for -1 above
+    newOvl = overlapLengthFor(aoverlapMs);
+    overlapDividerBitsPure = _getClosest2Power((double)newOvl) - 1;
 
     acceptNewOverlapLength(newOvl);
 
@@ -1007,19 +1321,25 @@ void TDStretch::overlapMulti(float *pOutput, const float *pInput) const
 }
 
 
-/// Calculates overlapInMsec period length in samples.
-void TDStretch::calculateOverlapLength(int overlapInMsec)
+/// Returns the overlap period length in samples for the given milliseconds.
+int TDStretch::overlapLengthFor(int overlapInMsec) const
 {
     int newOvl;
 
-    assert(overlapInMsec >= 0);
     newOvl = (sampleRate * overlapInMsec) / 1000;
     if (newOvl < 16) newOvl = 16;
 
     // must be divisible by 8
     newOvl -= newOvl % 8;
+    return newOvl;
+}
 
-    acceptNewOverlapLength(newOvl);
+
+/// Calculates overlapInMsec period length in samples.
+void TDStretch::calculateOverlapLength(int overlapInMsec)
+{
+    assert(overlapInMsec >= 0);
+    acceptNewOverlapLength(overlapLengthFor(overlapInMsec));
 }
 
 
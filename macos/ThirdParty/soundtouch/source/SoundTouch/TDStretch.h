@@ -4,8 +4,8 @@
 /// while maintaining the original pitch by using a time domain WSOLA-like method
 /// with several performance-increasing tweaks.
 ///
-/// Note : MMX/SSE optimized functions reside in separate, platform-specific files
-/// 'mmx_optimized.cpp' and 'sse_optimized.cpp'
+/// Note : MMX/SSE/AVX optimized functions reside in separate, platform-specific files
+/// 'mmx_optimized.cpp', 'sse_optimized.cpp' and 'avx_optimized.cpp'
 ///
 /// Author        : Copyright (c) Olli Parviainen
 /// Author e-mail : oparviai 'at' iki.fi
@@ -97,6 +97,12 @@ namespace soundtouch
 /// Increasing this value increases computational burden & vice versa.
 #define DEFAULT_OVERLAP_MS      8
 
+/// Seek window & overlap lengths in milliseconds that the work buffers are preallocated
+/// for, so that changing the parameters up to these values in the middle of a stream
+/// doesn't allocate memory. Larger values still work but grow the buffers when set.
+#define TDSTRETCH_PREALLOC_SEEKWINDOW_MS    50
+#define TDSTRETCH_PREALLOC_OVERLAP_MS       32
+
 
 /// Class that does the time-stretch (tempo change) effect for the processed
 /// sound.
@@ -125,17 +131,35 @@ protected:
     double skipFract;
 
     bool bQuickSeek;
+    bool bPyramidSeek;
     bool bAutoSeqSetting;
     bool bAutoSeekSetting;
     bool isBeginning;
 
+    /// Nonzero when 'overlapMs' has been changed in the middle of a stream; the new
+    /// overlap length is taken into use at the next sequence boundary.
+    bool bOverlapPending;
+
     SAMPLETYPE *pMidBuffer;
     SAMPLETYPE *pMidBufferUnaligned;
+    int midBufferSize;      ///< allocated size of 'pMidBuffer' in SAMPLETYPE units
+
+    // Scratch buffers of the coarse-to-fine seek: decimated mono downmix of the
+    // seek range and of 'pMidBuffer', coarse correlation curve and energy prefix sums
+    float *pPyramidRef;
+    float *pPyramidMid;
+    float *pPyramidCorr;
+    double *pPyramidEnergy;
+    int pyramidCapacity;
 
     FIFOSampleBuffer outputBuffer;
     FIFOSampleBuffer inputBuffer;
 
     void acceptNewOverlapLength(int newOverlapLength);
+    int overlapLengthFor(int overlapMs) const;
+    int switchOverlapLength(int offset, int seqLength);
+    void preallocate();
+    void reserveMidBuffer(int maxOverlapLength);
 
     virtual void clearCrossCorrState();
     void calculateOverlapLength(int overlapMs);
@@ -145,6 +169,7 @@ protected:
 
     virtual int seekBestOverlapPositionFull(const SAMPLETYPE *refPos);
     virtual int seekBestOverlapPositionQuick(const SAMPLETYPE *refPos);
+    virtual int seekBestOverlapPositionPyramid(const SAMPLETYPE *refPos);
     virtual int seekBestOverlapPosition(const SAMPLETYPE *refPos);
 
     virtual void overlapStereo(SAMPLETYPE *output, const SAMPLETYPE *input) const;
@@ -152,6 +177,7 @@ protected:
     virtual void overlapMulti(SAMPLETYPE *output, const SAMPLETYPE *input) const;
 
     void clearMidBuffer();
+    void reservePyramidBuffers(int maxSeekLength, int maxOverlapLength);
     void overlap(SAMPLETYPE *output, const SAMPLETYPE *input, uint ovlPos) const;
 
     void calcSeqParameters();
@@ -202,6 +228,13 @@ public:
     /// Returns nonzero if the quick seeking algorithm is enabled.
     bool isQuickSeekEnabled() const;
 
+    /// Enables/disables the coarse-to-fine position seeking algorithm. When enabled,
+    /// it takes precedence over the quick seeking algorithm.
+    void enablePyramidSeek(bool enable);
+
+    /// Returns nonzero if the coarse-to-fine seeking algorithm is enabled.
+    bool isPyramidSeekEnabled() const;
+
     /// Sets routine control parameters. These control are certain time constants
     /// defining how the sound is stretched to the desired duration.
     //
@@ -229,6 +262,21 @@ public:
                                                     ///< contains both channels if stereo
             ) override;
 
+    /// Returns a pointer to the end of the input buffer with room for at least
+    /// 'slackCapacity' samples. Write samples there directly and then call
+    /// 'commitInput' to process them without an intermediate copy.
+    SAMPLETYPE *inputSpan(uint slackCapacity)
+    {
+        return inputBuffer.ptrEnd(slackCapacity);
+    }
+
+    /// Processes 'numSamples' samples written to the pointer from 'inputSpan'.
+    void commitInput(uint numSamples);
+
+    /// Preallocates the input & output sample buffers for 'numSamples' samples
+    /// each, see FIFOSampleBuffer::reserve.
+    void reserveBuffers(uint numSamples);
+
     /// return nominal input sample requirement for triggering a processing batch
     int getInputSampleReq() const
     {
@@ -275,5 +323,29 @@ public:
 
 #endif /// SOUNDTOUCH_ALLOW_SSE
 
+
+#ifdef SOUNDTOUCH_ALLOW_AVX
+    /// Class that implements AVX2+FMA optimized routines for floating point samples type.
+    class TDStretchAVX2 : public TDStretch
+    {
+    protected:
+        double calcCrossCorr(const float *mixingPos, const float *compare, double &norm) override;
+        double calcCrossCorrAccumulate(const float *mixingPos, const float *compare, double &norm) override;
+        virtual void overlapStereo(float *output, const float *input) const override;
+        virtual void overlapMulti(float *output, const float *input) const override;
+    };
+
+    /// Class that implements AVX-512 optimized routines for floating point samples type.
+    /// Multichannel overlap is inherited from the AVX2 version.
+    class TDStretchAVX512 : public TDStretchAVX2
+    {
+    protected:
+        double calcCrossCorr(const float *mixingPos, const float *compare, double &norm) override;
+        double calcCrossCorrAccumulate(const float *mixingPos, const float *compare, double &norm) override;
+        virtual void overlapStereo(float *output, const float *input) const override;
+    };
+
+#endif /// SOUNDTOUCH_ALLOW_AVX
+
 }
 #endif  /// TDStretch_H
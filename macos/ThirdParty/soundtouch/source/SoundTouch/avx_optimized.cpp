@@ -0,0 +1,394 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// AVX2+FMA and AVX-512 optimized routines for TDStretch. All AVX optimized
+/// functions have been gathered into this single source code file, in the same
+/// way as the SSE routines in 'sse_optimized.cpp'.
+///
+/// The functions are compiled with per-function target attributes, so this file
+/// doesn't need any special compiler switches; the routines are selected at
+/// runtime by 'TDStretch::newInstance' only if 'detectCPUextensions' reports
+/// the corresponding instruction set as supported by both CPU and OS.
+///
+/// Correlation and norm sums use float accumulators. Products are first summed
+/// in short FMA chains and the chain results are then added with compensated
+/// (Kahan) summation, which keeps the accuracy of the old per-call double math
+/// without converting every vector to double.
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "cpu_detect.h"
+#include "STTypes.h"
+
+using namespace soundtouch;
+
+#ifdef SOUNDTOUCH_ALLOW_AVX
+
+// AVX routines available only with float sample type
+
+#include "TDStretch.h"
+#include <immintrin.h>
+#include <math.h>
+
+// Compensated summation relies on exact operation order; keep it even when the
+// library is built with -ffast-math (see CMakeLists.txt).
+#if defined(__clang__)
+    #pragma clang fp reassociate(off)
+#elif defined(__GNUC__)
+    #pragma GCC optimize("no-associative-math")
+#endif
+
+#if defined(__GNUC__)
+    #define ST_TARGET_AVX2      __attribute__((target("avx2,fma")))
+    #define ST_TARGET_AVX512    __attribute__((target("avx512f,avx2,fma")))
+#else
+    #define ST_TARGET_AVX2
+    #define ST_TARGET_AVX512
+#endif
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// implementation of AVX2+FMA optimized functions of class 'TDStretchAVX2'
+//
+//////////////////////////////////////////////////////////////////////////////
+
+// sum += x with running compensation 'comp'
+ST_TARGET_AVX2
+static inline void kahanAdd256(__m256 &sum, __m256 &comp, __m256 x)
+{
+    const __m256 y = _mm256_sub_ps(x, comp);
+    const __m256 t = _mm256_add_ps(sum, y);
+    comp = _mm256_sub_ps(_mm256_sub_ps(t, sum), y);
+    sum = t;
+}
+
+
+ST_TARGET_AVX2
+static inline float horizontalSum256(__m256 v)
+{
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 0x55));
+    return _mm_cvtss_f32(s);
+}
+
+
+// Sums pV1[i] * pV2[i] (and pV1[i]^2 if 'pNorm' given) over 'length' samples,
+// 'length' divisible by 8
+ST_TARGET_AVX2
+static float crossCorrSum256(const float *pV1, const float *pV2, int length, float *pNorm)
+{
+    __m256 vCorr = _mm256_setzero_ps();
+    __m256 cCorr = _mm256_setzero_ps();
+    __m256 vNorm = _mm256_setzero_ps();
+    __m256 cNorm = _mm256_setzero_ps();
+    int i = 0;
+
+    // Unroll by 4 * 8 samples: one FMA chain per round, compensated add per chain
+    for (; i + 32 <= length; i += 32)
+    {
+        const __m256 a0 = _mm256_loadu_ps(pV1 + i);
+        const __m256 a1 = _mm256_loadu_ps(pV1 + i + 8);
+        const __m256 a2 = _mm256_loadu_ps(pV1 + i + 16);
+        const __m256 a3 = _mm256_loadu_ps(pV1 + i + 24);
+
+        __m256 corr = _mm256_mul_ps(a0, _mm256_loadu_ps(pV2 + i));
+        corr = _mm256_fmadd_ps(a1, _mm256_loadu_ps(pV2 + i + 8), corr);
+        corr = _mm256_fmadd_ps(a2, _mm256_loadu_ps(pV2 + i + 16), corr);
+        corr = _mm256_fmadd_ps(a3, _mm256_loadu_ps(pV2 + i + 24), corr);
+        kahanAdd256(vCorr, cCorr, corr);
+
+        if (pNorm)
+        {
+            __m256 norm = _mm256_mul_ps(a0, a0);
+            norm = _mm256_fmadd_ps(a1, a1, norm);
+            norm = _mm256_fmadd_ps(a2, a2, norm);
+            norm = _mm256_fmadd_ps(a3, a3, norm);
+            kahanAdd256(vNorm, cNorm, norm);
+        }
+    }
+
+    for (; i < length; i += 8)
+    {
+        const __m256 a = _mm256_loadu_ps(pV1 + i);
+        kahanAdd256(vCorr, cCorr, _mm256_mul_ps(a, _mm256_loadu_ps(pV2 + i)));
+        if (pNorm)
+        {
+            kahanAdd256(vNorm, cNorm, _mm256_mul_ps(a, a));
+        }
+    }
+
+    if (pNorm)
+    {
+        *pNorm = horizontalSum256(_mm256_sub_ps(vNorm, cNorm));
+    }
+    return horizontalSum256(_mm256_sub_ps(vCorr, cCorr));
+}
+
+
+// Calculates cross correlation of two buffers
+ST_TARGET_AVX2
+double TDStretchAVX2::calcCrossCorr(const float *pV1, const float *pV2, double &anorm)
+{
+#ifdef ST_SIMD_AVOID_UNALIGNED
+    // skip unaligned locations, see TDStretchSSE::calcCrossCorr
+    if (((ulongptr)pV1) & 15) return -1e50;
+#endif
+
+    // hint that loop length is divisible by 8
+    const int ilength = (channels * overlapLength) & -8;
+
+    float norm;
+    const float corr = crossCorrSum256(pV1, pV2, ilength, &norm);
+    anorm = norm;
+
+    return corr / sqrt(norm < 1e-9 ? 1.0 : norm);
+}
+
+
+// Update cross-correlation by accumulating "norm" coefficient by previously calculated value
+ST_TARGET_AVX2
+double TDStretchAVX2::calcCrossCorrAccumulate(const float *pV1, const float *pV2, double &norm)
+{
+#ifdef ST_SIMD_AVOID_UNALIGNED
+    return calcCrossCorr(pV1, pV2, norm);
+#else
+    const int ilength = (channels * overlapLength) & -8;
+
+    // cancel first normalizer tap from previous round
+    for (int i = 1; i <= channels; i ++)
+    {
+        norm -= pV1[-i] * pV1[-i];
+    }
+
+    const float corr = crossCorrSum256(pV1, pV2, ilength, nullptr);
+
+    // update normalizer with last samples of this round
+    for (int i = 1; i <= channels; i ++)
+    {
+        norm += pV1[ilength - i] * pV1[ilength - i];
+    }
+
+    return corr / sqrt(norm < 1e-9 ? 1.0 : norm);
+#endif
+}
+
+
+// Overlaps samples in 'midBuffer' with the samples in 'pInput'
+ST_TARGET_AVX2
+void TDStretchAVX2::overlapStereo(float *pOutput, const float *pInput) const
+{
+    // weights per frame are computed from the frame index instead of being
+    // accumulated, 4 stereo frames per vector
+    const __m256 vScale = _mm256_set1_ps(1.0f / (float)overlapLength);
+    const __m256 vOne = _mm256_set1_ps(1.0f);
+    const __m256 vStep = _mm256_set1_ps(4.0f);
+    __m256 vFrame = _mm256_setr_ps(0, 0, 1, 1, 2, 2, 3, 3);
+
+    // overlapLength is divisible by 8 -> 2 * overlapLength divisible by 16
+    for (int i = 0; i < 2 * overlapLength; i += 8)
+    {
+        const __m256 f1 = _mm256_mul_ps(vFrame, vScale);
+        const __m256 f2 = _mm256_sub_ps(vOne, f1);
+        const __m256 mid = _mm256_mul_ps(_mm256_loadu_ps(pMidBuffer + i), f2);
+        _mm256_storeu_ps(pOutput + i, _mm256_fmadd_ps(_mm256_loadu_ps(pInput + i), f1, mid));
+        vFrame = _mm256_add_ps(vFrame, vStep);
+    }
+}
+
+
+// Overlaps samples in 'midBuffer' with the samples in 'pInput'
+ST_TARGET_AVX2
+void TDStretchAVX2::overlapMulti(float *pOutput, const float *pInput) const
+{
+    const float fScale = 1.0f / (float)overlapLength;
+
+    for (int frame = 0; frame < overlapLength; frame ++)
+    {
+        const float f1 = (float)frame * fScale;
+        const float f2 = 1.0f - f1;
+        const __m256 vF1 = _mm256_set1_ps(f1);
+        const __m256 vF2 = _mm256_set1_ps(f2);
+        const int base = frame * channels;
+
+        int c = 0;
+        for (; c + 8 <= channels; c += 8)
+        {
+            const __m256 mid = _mm256_mul_ps(_mm256_loadu_ps(pMidBuffer + base + c), vF2);
+            _mm256_storeu_ps(pOutput + base + c,
+                             _mm256_fmadd_ps(_mm256_loadu_ps(pInput + base + c), vF1, mid));
+        }
+        for (; c < channels; c ++)
+        {
+            pOutput[base + c] = pInput[base + c] * f1 + pMidBuffer[base + c] * f2;
+        }
+    }
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// implementation of AVX-512 optimized functions of class 'TDStretchAVX512'
+//
+//////////////////////////////////////////////////////////////////////////////
+
+// sum += x with running compensation 'comp'
+ST_TARGET_AVX512
+static inline void kahanAdd512(__m512 &sum, __m512 &comp, __m512 x)
+{
+    const __m512 y = _mm512_sub_ps(x, comp);
+    const __m512 t = _mm512_add_ps(sum, y);
+    comp = _mm512_sub_ps(_mm512_sub_ps(t, sum), y);
+    sum = t;
+}
+
+
+ST_TARGET_AVX512
+static inline float horizontalSum512(__m512 v)
+{
+    float lanes[16];
+    _mm512_storeu_ps(lanes, v);
+    return horizontalSum256(_mm256_add_ps(_mm256_loadu_ps(lanes), _mm256_loadu_ps(lanes + 8)));
+}
+
+
+// Same as 'crossCorrSum256' with 16 lanes; 'length' divisible by 8, the last
+// half vector (mono) is handled with a masked load
+ST_TARGET_AVX512
+static float crossCorrSum512(const float *pV1, const float *pV2, int length, float *pNorm)
+{
+    __m512 vCorr = _mm512_setzero_ps();
+    __m512 cCorr = _mm512_setzero_ps();
+    __m512 vNorm = _mm512_setzero_ps();
+    __m512 cNorm = _mm512_setzero_ps();
+    int i = 0;
+
+    for (; i + 64 <= length; i += 64)
+    {
+        const __m512 a0 = _mm512_loadu_ps(pV1 + i);
+        const __m512 a1 = _mm512_loadu_ps(pV1 + i + 16);
+        const __m512 a2 = _mm512_loadu_ps(pV1 + i + 32);
+        const __m512 a3 = _mm512_loadu_ps(pV1 + i + 48);
+
+        __m512 corr = _mm512_mul_ps(a0, _mm512_loadu_ps(pV2 + i));
+        corr = _mm512_fmadd_ps(a1, _mm512_loadu_ps(pV2 + i + 16), corr);
+        corr = _mm512_fmadd_ps(a2, _mm512_loadu_ps(pV2 + i + 32), corr);
+        corr = _mm512_fmadd_ps(a3, _mm512_loadu_ps(pV2 + i + 48), corr);
+        kahanAdd512(vCorr, cCorr, corr);
+
+        if (pNorm)
+        {
+            __m512 norm = _mm512_mul_ps(a0, a0);
+            norm = _mm512_fmadd_ps(a1, a1, norm);
+            norm = _mm512_fmadd_ps(a2, a2, norm);
+            norm = _mm512_fmadd_ps(a3, a3, norm);
+            kahanAdd512(vNorm, cNorm, norm);
+        }
+    }
+
+    for (; i < length; i += 16)
+    {
+        const int rest = length - i;
+        const __mmask16 mask = (rest >= 16) ? (__mmask16)0xFFFF : (__mmask16)((1u << rest) - 1);
+        const __m512 a = _mm512_maskz_loadu_ps(mask, pV1 + i);
+        kahanAdd512(vCorr, cCorr, _mm512_mul_ps(a, _mm512_maskz_loadu_ps(mask, pV2 + i)));
+        if (pNorm)
+        {
+            kahanAdd512(vNorm, cNorm, _mm512_mul_ps(a, a));
+        }
+    }
+
+    if (pNorm)
+    {
+        *pNorm = horizontalSum512(_mm512_sub_ps(vNorm, cNorm));
+    }
+    return horizontalSum512(_mm512_sub_ps(vCorr, cCorr));
+}
+
+
+// Calculates cross correlation of two buffers
+ST_TARGET_AVX512
+double TDStretchAVX512::calcCrossCorr(const float *pV1, const float *pV2, double &anorm)
+{
+#ifdef ST_SIMD_AVOID_UNALIGNED
+    if (((ulongptr)pV1) & 15) return -1e50;
+#endif
+
+    const int ilength = (channels * overlapLength) & -8;
+
+    float norm;
+    const float corr = crossCorrSum512(pV1, pV2, ilength, &norm);
+    anorm = norm;
+
+    return corr / sqrt(norm < 1e-9 ? 1.0 : norm);
+}
+
+
+// Update cross-correlation by accumulating "norm" coefficient by previously calculated value
+ST_TARGET_AVX512
+double TDStretchAVX512::calcCrossCorrAccumulate(const float *pV1, const float *pV2, double &norm)
+{
+#ifdef ST_SIMD_AVOID_UNALIGNED
+    return calcCrossCorr(pV1, pV2, norm);
+#else
+    const int ilength = (channels * overlapLength) & -8;
+
+    for (int i = 1; i <= channels; i ++)
+    {
+        norm -= pV1[-i] * pV1[-i];
+    }
+
+    const float corr = crossCorrSum512(pV1, pV2, ilength, nullptr);
+
+    for (int i = 1; i <= channels; i ++)
+    {
+        norm += pV1[ilength - i] * pV1[ilength - i];
+    }
+
+    return corr / sqrt(norm < 1e-9 ? 1.0 : norm);
+#endif
+}
+
+
+// Overlaps samples in 'midBuffer' with the samples in 'pInput', 8 stereo frames per vector
+ST_TARGET_AVX512
+void TDStretchAVX512::overlapStereo(float *pOutput, const float *pInput) const
+{
+    const __m512 vScale = _mm512_set1_ps(1.0f / (float)overlapLength);
+    const __m512 vOne = _mm512_set1_ps(1.0f);
+    const __m512 vStep = _mm512_set1_ps(8.0f);
+    __m512 vFrame = _mm512_setr_ps(0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7);
+
+    // 2 * overlapLength is divisible by 16
+    for (int i = 0; i < 2 * overlapLength; i += 16)
+    {
+        const __m512 f1 = _mm512_mul_ps(vFrame, vScale);
+        const __m512 f2 = _mm512_sub_ps(vOne, f1);
+        const __m512 mid = _mm512_mul_ps(_mm512_loadu_ps(pMidBuffer + i), f2);
+        _mm512_storeu_ps(pOutput + i, _mm512_fmadd_ps(_mm512_loadu_ps(pInput + i), f1, mid));
+        vFrame = _mm512_add_ps(vFrame, vStep);
+    }
+}
+
+#endif // SOUNDTOUCH_ALLOW_AVX
@@ -41,7 +41,7 @@
    #if defined(__GNUC__) && defined(__i386__)
        // gcc
        #include "cpuid.h"
-   #elif defined(_M_IX86)
+   #elif defined(_M_IX86) || defined(_M_X64)
        // windows non-gcc
        #include <intrin.h>
    #endif
@@ -68,16 +68,61 @@ void disableExtensions(uint dwDisableMask)
 }
 
 
+#if defined(SOUNDTOUCH_ALLOW_AVX)
+/// Checks AVX2+FMA and AVX-512F support. Unlike SSE these need also the OS to
+/// save the wider register state, so the check is always done at runtime.
+static uint detectAVXextensions(void)
+{
+    uint res = 0;
+
+#if defined(__GNUC__)
+    // gcc & clang: the builtins check both cpuid and the XCR0 register state
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    {
+        res = res | SUPPORT_AVX2;
+        if (__builtin_cpu_supports("avx512f")) res = res | SUPPORT_AVX512;
+    }
+
+#else
+    int reg[4] = {-1};
+
+    __cpuid(reg, 0);
+    if (reg[0] < 7) return 0;
+
+    __cpuid(reg, 1);
+    const bool osxsave = ((unsigned int)reg[2] & (1u << 27)) != 0;
+    const bool fma     = ((unsigned int)reg[2] & (1u << 12)) != 0;
+    if (!osxsave) return 0;
+    const unsigned long long xcr0 = _xgetbv(0);
+
+    __cpuidex(reg, 7, 0);
+    // YMM state (bits 1-2), additionally opmask + ZMM state (bits 5-7) for AVX-512
+    if (fma && ((unsigned int)reg[1] & (1u << 5)) && (xcr0 & 0x06) == 0x06)
+    {
+        res = res | SUPPORT_AVX2;
+        if (((unsigned int)reg[1] & (1u << 16)) && (xcr0 & 0xe6) == 0xe6) res = res | SUPPORT_AVX512;
+    }
+#endif
+
+    return res;
+}
+#endif // SOUNDTOUCH_ALLOW_AVX
+
+
 /// Checks which instruction set extensions are supported by the CPU.
 uint detectCPUextensions(void)
 {
 /// If building for a 64bit system (no Itanium) and the user wants optimizations.
-/// Return the OR of SUPPORT_{MMX,SSE,SSE2}. 11001 or 0x19.
+/// Return the OR of SUPPORT_{MMX,SSE,SSE2}. 11001 or 0x19, plus AVX2/AVX-512
+/// if available at runtime.
 /// Keep the _dwDisabledISA test (2 more operations, could be eliminated).
 #if ((defined(__GNUC__) && defined(__x86_64__)) \
     || defined(_M_X64))  \
     && defined(SOUNDTOUCH_ALLOW_X86_OPTIMIZATIONS)
-    return 0x19 & ~_dwDisabledISA;
+    if (_dwDisabledISA == 0xffffffff) return 0;
+
+    return (0x19 | detectAVXextensions()) & ~_dwDisabledISA;
 
 /// If building for a 32bit system and the user wants optimizations.
 /// Keep the _dwDisabledISA test (2 more operations, could be eliminated).
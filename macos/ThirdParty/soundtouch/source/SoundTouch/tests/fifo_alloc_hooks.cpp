@@ -0,0 +1,56 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// memmove replacement for 'fifo_alloc_test', counting the calls.
+///
+/// Kept in its own file without any includes, so that it doesn't clash with
+/// the library declaration of memmove. Must be built with _FORTIFY_SOURCE
+/// disabled, as fortified builds call '__memmove_chk' instead.
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+extern "C"
+{
+
+long fifoTestMemmoveCount = 0;
+
+void *memmove(void *dest, const void *src, __SIZE_TYPE__ n)
+{
+    // volatile, so that the compiler doesn't turn the loops back into a
+    // memmove call
+    volatile unsigned char *d = (volatile unsigned char *)dest;
+    const volatile unsigned char *s = (const volatile unsigned char *)src;
+
+    fifoTestMemmoveCount ++;
+    if (d < s)
+    {
+        for (__SIZE_TYPE__ i = 0; i < n; i ++) d[i] = s[i];
+    }
+    else
+    {
+        for (__SIZE_TYPE__ i = n; i > 0; i --) d[i - 1] = s[i - 1];
+    }
+    return dest;
+}
+
+}
@@ -0,0 +1,210 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// Allocation test for the reserved (mirrored ring) FIFO buffers.
+///
+/// Runs the whole SoundTouch pipeline the way the player engine does: samples
+/// are written through 'inputSpan' / 'commitInput' and read through
+/// 'outputBegin' / 'receiveSamples'. Each configuration of the tempo, pitch and
+/// block size matrix is processed twice, with default buffers and with
+/// 'reserveBuffers'. After 300 warm-up blocks, 3000 further blocks are counted:
+///
+/// - reserved buffers must not call operator new or memmove at all
+/// - default buffers must call memmove (proves the memmove counter works)
+/// - both runs must produce bit-identical output
+///
+/// memmove is counted by the replacement in 'fifo_alloc_hooks.cpp', which is
+/// linked into the same image as the SoundTouch sources.
+///
+/// Returns 0 if all configurations pass.
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <new>
+#include "SoundTouch.h"
+
+using namespace soundtouch;
+
+#define SAMPLE_RATE     48000
+#define CHANNELS        2
+#define WARMUP_BLOCKS   300
+#define MEASURE_BLOCKS  3000
+#define MAX_BLOCK       2048
+
+/// Same reservation as the player engine (400 ms)
+#define RESERVE_FRAMES  (SAMPLE_RATE * 400 / 1000)
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+extern "C" long fifoTestMemmoveCount;
+
+static long newCount = 0;
+
+void *operator new(size_t size)
+{
+    newCount ++;
+    void *ptr = malloc(size ? size : 1);
+    if (ptr == nullptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void *operator new[](size_t size)
+{
+    newCount ++;
+    void *ptr = malloc(size ? size : 1);
+    if (ptr == nullptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept { free(ptr); }
+void operator delete[](void *ptr) noexcept { free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { free(ptr); }
+
+
+struct RunResult
+{
+    long allocs;
+    long memmoves;
+    unsigned long long frames;
+    unsigned long long hash;
+};
+
+
+/// FNV-1a over the sample bit patterns
+static unsigned long long hashSamples(unsigned long long hash, const float *samples, uint count)
+{
+    const unsigned char *bytes = (const unsigned char *)samples;
+    for (size_t i = 0; i < count * sizeof(float); i ++)
+    {
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+
+static RunResult run(bool reserve, float tempo, float pitch, uint block)
+{
+    SoundTouch st;
+    RunResult res = {0, 0, 0, 14695981039346656037ULL};
+    double phase = 0;
+
+    st.setSampleRate(SAMPLE_RATE);
+    st.setChannels(CHANNELS);
+    st.setSetting(SETTING_SEQUENCE_MS, 36);
+    st.setSetting(SETTING_SEEKWINDOW_MS, 18);
+    st.setSetting(SETTING_OVERLAP_MS, 9);
+    st.setTempo(tempo);
+    st.setPitchSemiTones(pitch);
+    if (reserve)
+    {
+        st.reserveBuffers(RESERVE_FRAMES);
+    }
+
+    long newBase = 0;
+    long moveBase = 0;
+    for (int b = 0; b < WARMUP_BLOCKS + MEASURE_BLOCKS; b ++)
+    {
+        if (b == WARMUP_BLOCKS)
+        {
+            newBase = newCount;
+            moveBase = fifoTestMemmoveCount;
+        }
+
+        float *dest = st.inputSpan(block);
+        const double freq = 220.0 + 50.0 * sin(b * 0.01);
+        for (uint i = 0; i < block; i ++)
+        {
+            phase += 2.0 * M_PI * freq / SAMPLE_RATE;
+            dest[2 * i] = (float)sin(phase);
+            dest[2 * i + 1] = (float)(0.5 * sin(2.0 * phase));
+        }
+        st.commitInput(block);
+
+        uint avail;
+        while ((avail = st.numSamples()) > 0)
+        {
+            const uint count = (avail > 1024) ? 1024 : avail;
+            res.hash = hashSamples(res.hash, st.outputBegin(), count * CHANNELS);
+            res.frames += count;
+            st.receiveSamples(count);
+        }
+    }
+    res.allocs = newCount - newBase;
+    res.memmoves = fifoTestMemmoveCount - moveBase;
+    return res;
+}
+
+
+int main()
+{
+    const float tempos[] = {0.6f, 1.0f, 1.4f};
+    const float pitches[] = {0.0f, 3.0f, -5.0f};
+    const uint blocks[] = {512, 1152, MAX_BLOCK};
+    int failures = 0;
+
+    // the counters must see the library: constructing SoundTouch allocates
+    const long newBefore = newCount;
+    {
+        SoundTouch probe;
+    }
+    if (newCount == newBefore)
+    {
+        printf("operator new replacement is not active\n");
+        return 1;
+    }
+
+    for (float tempo : tempos)
+    {
+        for (float pitch : pitches)
+        {
+            for (uint block : blocks)
+            {
+                const RunResult def = run(false, tempo, pitch, block);
+                const RunResult rsv = run(true, tempo, pitch, block);
+                const bool identical = (def.frames == rsv.frames) && (def.hash == rsv.hash);
+                const bool ok = (rsv.allocs == 0) && (rsv.memmoves == 0) && (def.memmoves > 0) && identical;
+
+                printf("%s tempo %.1f pitch %+.0f block %4u | default: allocs %ld memmoves %ld"
+                       " | reserved: allocs %ld memmoves %ld | identical %s\n",
+                       ok ? "ok  " : "FAIL", tempo, pitch, block, def.allocs, def.memmoves,
+                       rsv.allocs, rsv.memmoves, identical ? "yes" : "no");
+                if (!ok) failures ++;
+            }
+        }
+    }
+
+    if (failures)
+    {
+        printf("%d configuration(s) failed\n", failures);
+        return 1;
+    }
+    printf("all configurations passed\n");
+    return 0;
+}
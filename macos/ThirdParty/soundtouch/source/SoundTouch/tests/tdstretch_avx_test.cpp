@@ -0,0 +1,273 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// Equivalence test for the AVX2 / AVX-512 TDStretch kernels.
+///
+/// Each vectorized kernel is run side by side with the plain C kernel of the
+/// TDStretch base class on the same overlap buffer and input, for 1, 2 and 6
+/// channels and several overlap lengths:
+///
+/// - calcCrossCorr / calcCrossCorrAccumulate over a full seek scan: every
+///   correlation value and the rolling norm must match within tolerance, and
+///   the best offset of the scan must be the same
+/// - overlapStereo / overlapMulti: the mixed output must match within tolerance
+///
+/// Kernel sets that 'detectCPUextensions' doesn't report are skipped; if none
+/// is available (or the build has no AVX routines) the test returns 77, which
+/// ctest reports as skipped.
+///
+/// Returns 0 if all kernels pass.
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include "../TDStretch.h"
+#include "../cpu_detect.h"
+
+using namespace soundtouch;
+
+#define SAMPLE_RATE     48000
+#define SCAN_OFFSETS    480
+#define SKIP_RETURN     77
+
+/// Correlation tolerance, relative to the overlap buffer magnitude
+#define CORR_TOLERANCE  1e-5
+/// Absolute tolerance of overlap-add output for full-scale input. The plain C
+/// kernels step the mixing weights with a running sum, which drifts by ~1e-5
+/// over a 20 ms overlap; the AVX kernels compute the weights per frame.
+#define MIX_TOLERANCE   1e-4
+
+#ifdef SOUNDTOUCH_ALLOW_AVX
+
+/// Deterministic pseudo-random sample in [-1, 1)
+static float noise(unsigned int &state)
+{
+    state = state * 1664525u + 1013904223u;
+    return (float)(state >> 8) * (2.0f / 16777216.0f) - 1.0f;
+}
+
+
+/// Gives the test access to the protected kernels of a TDStretch variant
+template <class Base> class KernelProbe : public Base
+{
+public:
+    void setup(int numChannels, int overlapMs)
+    {
+        this->setChannels(numChannels);
+        this->setParameters(SAMPLE_RATE, 40, 15, overlapMs);
+    }
+
+    int overlapFrames() const
+    {
+        return this->overlapLength;
+    }
+
+    float *mid()
+    {
+        return this->pMidBuffer;
+    }
+
+    double corr(const float *pos, double &norm)
+    {
+        return this->calcCrossCorr(pos, this->pMidBuffer, norm);
+    }
+
+    double corrAccumulate(const float *pos, double &norm)
+    {
+        return this->calcCrossCorrAccumulate(pos, this->pMidBuffer, norm);
+    }
+
+    void mix(float *output, const float *input) const
+    {
+        if (this->channels == 1)
+        {
+            this->overlapMono(output, input);
+        }
+        else if (this->channels == 2)
+        {
+            this->overlapStereo(output, input);
+        }
+        else
+        {
+            this->overlapMulti(output, input);
+        }
+    }
+};
+
+
+struct KernelResult
+{
+    double maxCorrErr;
+    double maxNormErr;
+    double maxMixErr;
+    int plainBest;
+    int simdBest;
+};
+
+
+/// Runs the plain and the vectorized kernels on identical data
+template <class Simd> static KernelResult compareKernels(int numChannels, int overlapMs, unsigned int seed)
+{
+    KernelProbe<TDStretch> plain;
+    KernelProbe<Simd> simd;
+    plain.setup(numChannels, overlapMs);
+    simd.setup(numChannels, overlapMs);
+
+    const int ovl = plain.overlapFrames();
+    const int ovlSamples = ovl * numChannels;
+
+    // overlap buffer: a tone plus noise; input: the same tone shifted, plus other noise,
+    // so that the scan has a clear but not trivial correlation peak
+    unsigned int state = seed;
+    double midEnergy = 0;
+    for (int i = 0; i < ovlSamples; i ++)
+    {
+        const int frame = i / numChannels;
+        const float v = 0.6f * (float)sin(0.031 * frame + 0.7 * (i % numChannels)) + 0.3f * noise(state);
+        plain.mid()[i] = v;
+        midEnergy += (double)v * v;
+    }
+    memcpy(simd.mid(), plain.mid(), ovlSamples * sizeof(float));
+
+    std::vector<float> input((SCAN_OFFSETS + ovl) * numChannels);
+    for (size_t i = 0; i < input.size(); i ++)
+    {
+        const int frame = (int)(i / numChannels) - SCAN_OFFSETS / 3;
+        input[i] = 0.6f * (float)sin(0.031 * frame + 0.7 * (i % numChannels)) + 0.3f * noise(state);
+    }
+
+    KernelResult res = {0, 0, 0, 0, 0};
+    const double corrScale = sqrt(midEnergy);
+    double plainNorm = 0;
+    double simdNorm = 0;
+    double plainBestCorr = -1e30;
+    double simdBestCorr = -1e30;
+
+    for (int i = 0; i < SCAN_OFFSETS; i ++)
+    {
+        const float *pos = &input[i * numChannels];
+        const double pc = (i == 0) ? plain.corr(pos, plainNorm) : plain.corrAccumulate(pos, plainNorm);
+        const double sc = (i == 0) ? simd.corr(pos, simdNorm) : simd.corrAccumulate(pos, simdNorm);
+
+        const double corrErr = fabs(sc - pc) / corrScale;
+        const double normErr = fabs(simdNorm - plainNorm) / (plainNorm > 1 ? plainNorm : 1);
+        if (corrErr > res.maxCorrErr) res.maxCorrErr = corrErr;
+        if (normErr > res.maxNormErr) res.maxNormErr = normErr;
+
+        if (pc > plainBestCorr)
+        {
+            plainBestCorr = pc;
+            res.plainBest = i;
+        }
+        if (sc > simdBestCorr)
+        {
+            simdBestCorr = sc;
+            res.simdBest = i;
+        }
+    }
+
+    std::vector<float> plainOut(ovlSamples);
+    std::vector<float> simdOut(ovlSamples);
+    plain.mix(plainOut.data(), &input[res.plainBest * numChannels]);
+    simd.mix(simdOut.data(), &input[res.plainBest * numChannels]);
+    for (int i = 0; i < ovlSamples; i ++)
+    {
+        const double err = fabs((double)simdOut[i] - (double)plainOut[i]);
+        if (err > res.maxMixErr) res.maxMixErr = err;
+    }
+    return res;
+}
+
+
+template <class Simd> static int testKernelSet(const char *name)
+{
+    const int channelCounts[] = {1, 2, 6};
+    const int overlapMsecs[] = {2, 8, 20};
+    int failures = 0;
+
+    for (int numChannels : channelCounts)
+    {
+        for (int overlapMs : overlapMsecs)
+        {
+            const KernelResult r = compareKernels<Simd>(numChannels, overlapMs, 12345u + numChannels * 100 + overlapMs);
+            const bool ok = (r.maxCorrErr < CORR_TOLERANCE) && (r.maxNormErr < CORR_TOLERANCE) &&
+                            (r.maxMixErr < MIX_TOLERANCE) && (r.plainBest == r.simdBest);
+
+            printf("%s %-7s ch %d overlap %2d ms | corr err %.2e norm err %.2e mix err %.2e | best %d / %d\n",
+                   ok ? "ok  " : "FAIL", name, numChannels, overlapMs, r.maxCorrErr, r.maxNormErr,
+                   r.maxMixErr, r.plainBest, r.simdBest);
+            if (!ok) failures ++;
+        }
+    }
+    return failures;
+}
+
+#endif // SOUNDTOUCH_ALLOW_AVX
+
+
+int main()
+{
+#ifdef SOUNDTOUCH_ALLOW_AVX
+    const uint extensions = detectCPUextensions();
+    int tested = 0;
+    int failures = 0;
+
+    if (extensions & SUPPORT_AVX2)
+    {
+        failures += testKernelSet<TDStretchAVX2>("AVX2");
+        tested ++;
+    }
+    else
+    {
+        printf("skip AVX2: not supported by this CPU / OS\n");
+    }
+
+    if (extensions & SUPPORT_AVX512)
+    {
+        failures += testKernelSet<TDStretchAVX512>("AVX-512");
+        tested ++;
+    }
+    else
+    {
+        printf("skip AVX-512: not supported by this CPU / OS\n");
+    }
+
+    if (tested == 0)
+    {
+        return SKIP_RETURN;
+    }
+    if (failures)
+    {
+        printf("%d kernel configuration(s) failed\n", failures);
+        return 1;
+    }
+    printf("all kernel configurations passed\n");
+    return 0;
+#else
+    printf("skip: this build has no AVX routines\n");
+    return SKIP_RETURN;
+#endif // SOUNDTOUCH_ALLOW_AVX
+}
@@ -0,0 +1,243 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// Agreement test for the coarse-to-fine (pyramid) overlap seek of TDStretch.
+///
+/// For a synthetic stereo music-like signal, the pyramid seek and the full
+/// search are run on the same overlap buffer and seek range many times. The
+/// pyramid seek must
+///
+/// - land within OFFSET_TOLERANCE frames of the full-search offset in at least
+///   MIN_AGREEMENT of the trials, and
+/// - reach on average at least MIN_SCORE_RATIO of the full search's score.
+///
+/// Configurations whose decimated overlap or seek range is too short for the
+/// pyramid ('coarseOvl < 8' or 'coarseSeek < 3') must fall back to the full
+/// search, i.e. return exactly the same offset in every trial.
+///
+/// The plain C correlation kernels of the TDStretch base class are used, so the
+/// result doesn't depend on the CPU.
+///
+/// Returns 0 if all configurations pass.
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include "../TDStretch.h"
+
+using namespace soundtouch;
+
+#define CHANNELS            2
+#define TRIALS              2000
+#define OFFSET_TOLERANCE    2
+#define MIN_AGREEMENT       0.98
+#define MIN_SCORE_RATIO     0.998
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/// Deterministic pseudo-random number in [0, 1)
+static double uniform(unsigned int &state)
+{
+    state = state * 1664525u + 1013904223u;
+    return (double)(state >> 8) / 16777216.0;
+}
+
+
+/// A few detuned harmonic voices with slow vibrato, panned apart, plus noise
+static std::vector<SAMPLETYPE> makeSignal(int sampleRate, int frames, unsigned int seed)
+{
+    const double freqs[] = {110.0, 164.8, 220.0, 329.6, 440.0};
+    std::vector<SAMPLETYPE> sig((size_t)frames * CHANNELS);
+    unsigned int state = seed;
+    double phase[5] = {0, 0, 0, 0, 0};
+
+    for (int n = 0; n < frames; n ++)
+    {
+        const double t = (double)n / sampleRate;
+        double l = 0;
+        double r = 0;
+        for (int v = 0; v < 5; v ++)
+        {
+            const double f = freqs[v] * (1.0 + 0.004 * sin(2 * M_PI * (0.5 + 0.3 * v) * t));
+            phase[v] += 2 * M_PI * f / sampleRate;
+            const double s = 0.7 * sin(phase[v]) + 0.2 * sin(2 * phase[v]) + 0.1 * sin(3 * phase[v]);
+            const double pan = 0.2 + 0.15 * v;
+            l += s * (1.0 - pan);
+            r += s * pan;
+        }
+        sig[n * CHANNELS + 0] = (SAMPLETYPE)(0.15 * l + 0.1 * (uniform(state) - 0.5));
+        sig[n * CHANNELS + 1] = (SAMPLETYPE)(0.15 * r + 0.1 * (uniform(state) - 0.5));
+    }
+    return sig;
+}
+
+
+/// Gives the test access to the protected seek routines
+class SeekProbe : public TDStretch
+{
+public:
+    void setup(int sampleRate, int seekMs, int overlapMs)
+    {
+        setChannels(CHANNELS);
+        setParameters(sampleRate, 40, seekMs, overlapMs);
+    }
+
+    int overlapFrames() const
+    {
+        return overlapLength;
+    }
+
+    int seekFrames() const
+    {
+        return seekLength;
+    }
+
+    SAMPLETYPE *mid()
+    {
+        return pMidBuffer;
+    }
+
+    int full(const SAMPLETYPE *refPos)
+    {
+        return seekBestOverlapPositionFull(refPos);
+    }
+
+    int pyramid(const SAMPLETYPE *refPos)
+    {
+        return seekBestOverlapPositionPyramid(refPos);
+    }
+
+    /// Score of offset 'i' exactly as the full search rates it
+    double score(const SAMPLETYPE *refPos, int i)
+    {
+        double norm;
+        const double corr = calcCrossCorr(refPos + CHANNELS * i, pMidBuffer, norm);
+        const double tmp = (double)(2 * i - seekLength) / (double)seekLength;
+        return (corr + 0.1) * (1.0 - 0.25 * tmp * tmp);
+    }
+};
+
+
+struct SeekResult
+{
+    int overlap;
+    int seek;
+    double agreement;
+    double exact;
+    double scoreRatio;
+};
+
+
+static SeekResult runSeek(int sampleRate, int seekMs, int overlapMs, unsigned int seed)
+{
+    SeekProbe st;
+    st.setup(sampleRate, seekMs, overlapMs);
+
+    const int ovl = st.overlapFrames();
+    const int seek = st.seekFrames();
+    const int frames = sampleRate * 10;
+    const std::vector<SAMPLETYPE> sig = makeSignal(sampleRate, frames, seed);
+    unsigned int state = seed * 7 + 1;
+
+    int near = 0;
+    int exact = 0;
+    double ratioSum = 0;
+
+    for (int trial = 0; trial < TRIALS; trial ++)
+    {
+        // overlap buffer = tail of the "previous sequence"; the seek range starts one
+        // stretched sequence later, as in the WSOLA loop at tempo != 1, so the range
+        // holds no exact copy of the overlap buffer
+        const int midPos = (int)(uniform(state) * (frames - 4 * seek - 2 * ovl));
+        for (int i = 0; i < ovl * CHANNELS; i ++)
+        {
+            st.mid()[i] = sig[(size_t)midPos * CHANNELS + i];
+        }
+        const int refFrame = midPos + ovl + (int)(uniform(state) * 2 * seek);
+        const SAMPLETYPE *refPos = &sig[(size_t)refFrame * CHANNELS];
+
+        const int fullOffs = st.full(refPos);
+        const int pyrOffs = st.pyramid(refPos);
+
+        if (abs(pyrOffs - fullOffs) <= OFFSET_TOLERANCE) near ++;
+        if (pyrOffs == fullOffs) exact ++;
+
+        const double fullScore = st.score(refPos, fullOffs);
+        const double pyrScore = st.score(refPos, pyrOffs);
+        ratioSum += (fullScore > 0) ? pyrScore / fullScore : 1.0;
+    }
+
+    SeekResult res;
+    res.overlap = ovl;
+    res.seek = seek;
+    res.agreement = (double)near / TRIALS;
+    res.exact = (double)exact / TRIALS;
+    res.scoreRatio = ratioSum / TRIALS;
+    return res;
+}
+
+
+int main()
+{
+    struct Config
+    {
+        int sampleRate;
+        int seekMs;
+        int overlapMs;
+        bool fallback;      ///< too short for the pyramid, must equal full search
+    };
+    const Config configs[] = {
+        {44100, 18, 9, false},      // player engine 0.5-0.75x band
+        {48000, 18, 9, false},
+        {48000, 25, 12, false},
+        {48000, 15, 4, false},
+        {8000, 15, 2, true},        // overlap 16 frames -> coarseOvl 4 < 8
+        {8000, 1, 8, true},         // seek 8 frames -> coarseSeek 2 < 3
+    };
+    int failures = 0;
+
+    for (const Config &c : configs)
+    {
+        const SeekResult r = runSeek(c.sampleRate, c.seekMs, c.overlapMs, (unsigned int)(c.sampleRate + c.overlapMs));
+        const bool ok = c.fallback ? (r.exact == 1.0)
+                                   : (r.agreement >= MIN_AGREEMENT && r.scoreRatio >= MIN_SCORE_RATIO);
+
+        printf("%s rate %5d ovl %3d seek %4d%s | within %d: %5.1f%% exact: %5.1f%% score ratio %.4f\n",
+               ok ? "ok  " : "FAIL", c.sampleRate, r.overlap, r.seek, c.fallback ? " (fallback)" : "",
+               OFFSET_TOLERANCE, r.agreement * 100, r.exact * 100, r.scoreRatio);
+        if (!ok) failures ++;
+    }
+
+    if (failures)
+    {
+        printf("%d configuration(s) failed\n", failures);
+        return 1;
+    }
+    printf("all configurations passed\n");
+    return 0;
+}